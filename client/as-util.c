@@ -939,41 +939,35 @@ as_util_non_package_yaml (AsUtilPrivate *priv, gchar **values, GError **error)
 }
 
 /**
- * as_util_validate_file:
+ * as_util_validate_store:
  **/
 static gboolean
-as_util_validate_file (const gchar *filename,
-		       AsAppValidateFlags flags,
-		       GError **error)
+as_util_validate_store (const gchar *filename, GError **error)
+{
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+
+	file = g_file_new_for_path (filename);
+	store = as_store_new ();
+	if (!as_store_from_file (store, file, NULL, NULL, error))
+		return FALSE;
+	g_print ("%s: %s\n", filename, _("OK"));
+	return TRUE;
+}
+
+/**
+ * as_util_validate_output:
+ **/
+static gboolean
+as_util_validate_output (const gchar *filename,
+			 GPtrArray *probs,
+			 GError **error)
 {
 	AsProblemKind kind;
 	AsProblem *problem;
 	guint i;
-	_cleanup_object_unref_ AsApp *app = NULL;
-	_cleanup_ptrarray_unref_ GPtrArray *probs = NULL;
-
-	/* is AppStream */
-	if (g_str_has_suffix (filename, ".xml.gz")) {
-		gboolean ret;
-		_cleanup_object_unref_ AsStore *store;
-		_cleanup_object_unref_ GFile *file;
-		file = g_file_new_for_path (filename);
-		store = as_store_new ();
-		ret = as_store_from_file (store, file, NULL, NULL, error);
-		if (!ret)
-			return FALSE;
-		g_print ("%s: %s\n", filename, _("OK"));
-		return TRUE;
-	}
 
-	/* load file */
-	app = as_app_new ();
 	g_print ("%s: ", filename);
-	if (!as_app_parse_file (app, filename, AS_APP_PARSE_FLAG_NONE, error))
-		return FALSE;
-	probs = as_app_validate (app, flags, error);
-	if (probs == NULL)
-		return FALSE;
 	if (probs->len > 0) {
 		g_print ("%s:\n", _("FAILED"));
 		for (i = 0; i < probs->len; i++) {
@@ -1001,9 +995,17 @@ as_util_validate_files (gchar **filenames,
 		        AsAppValidateFlags flags,
 		        GError **error)
 {
+	GError *error_app;
 	GError *error_local = NULL;
+	GPtrArray *probs;
+	gboolean ret;
 	guint i;
+	guint j = 0;
 	guint n_failed = 0;
+	_cleanup_hashtable_unref_ GHashTable *errors_parse = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *errors = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *results = NULL;
 
 	/* check args */
 	if (g_strv_length (filenames) < 1) {
@@ -1015,18 +1017,68 @@ as_util_validate_files (gchar **filenames,
 		return FALSE;
 	}
 
-	/* check each file */
+	/* load all the AppData files, keeping the parse errors to show
+	 * in order with the other results */
+	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	errors_parse = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+					      NULL, (GDestroyNotify) g_error_free);
+	for (i = 0; filenames[i] != NULL; i++) {
+		AsApp *app;
+		if (g_str_has_suffix (filenames[i], ".xml.gz"))
+			continue;
+		app = as_app_new ();
+		if (!as_app_parse_file (app, filenames[i],
+					AS_APP_PARSE_FLAG_NONE, &error_local)) {
+			g_hash_table_insert (errors_parse,
+					     GUINT_TO_POINTER (i),
+					     error_local);
+			error_local = NULL;
+			g_object_unref (app);
+			continue;
+		}
+		g_ptr_array_add (apps, app);
+	}
+
+	/* validate them all at once so downloads and lookups are shared, and
+	 * check each screenshot URL only if it changed since the last run */
+	results = as_app_validate_batch (apps,
+					 flags |
+					 AS_APP_VALIDATE_FLAG_PARALLEL |
+					 AS_APP_VALIDATE_FLAG_USE_CACHE,
+					 &errors,
+					 error);
+	if (results == NULL)
+		return FALSE;
+
+	/* show the results for each file in order, carrying on past any
+	 * file that could not be loaded or validated */
 	for (i = 0; filenames[i] != NULL; i++) {
-		if (as_util_validate_file (filenames[i], flags, &error_local))
+		if (g_str_has_suffix (filenames[i], ".xml.gz")) {
+			ret = as_util_validate_store (filenames[i], &error_local);
+		} else {
+			probs = NULL;
+			error_app = g_hash_table_lookup (errors_parse,
+							 GUINT_TO_POINTER (i));
+			if (error_app == NULL) {
+				probs = g_ptr_array_index (results, j);
+				error_app = g_ptr_array_index (errors, j);
+				j++;
+			}
+			if (error_app != NULL) {
+				g_print ("%s: %s\n", filenames[i], error_app->message);
+				n_failed++;
+				continue;
+			}
+			ret = as_util_validate_output (filenames[i], probs, &error_local);
+		}
+		if (ret)
 			continue;
 
-		/* anything other than AsProblems bail */
+		/* AsProblems have already been shown */
 		n_failed++;
 		if (!g_error_matches (error_local, AS_ERROR,
-				      AS_ERROR_INVALID_ARGUMENTS)) {
-			g_propagate_error (error, error_local);
-			return FALSE;
-		}
+				      AS_ERROR_INVALID_ARGUMENTS))
+			g_print ("%s: %s\n", filenames[i], error_local->message);
 		g_clear_error (&error_local);
 	}
 	if (n_failed > 0) {
@@ -1036,7 +1088,7 @@ as_util_validate_files (gchar **filenames,
 				     _("Validation of files failed"));
 		return FALSE;
 	}
-	return n_failed == 0;
+	return TRUE;
 }
 
 /**
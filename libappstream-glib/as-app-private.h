@@ -29,6 +29,9 @@
 #include <glib-object.h>
 
 #include "as-app.h"
+#include "as-provide-private.h"
+#include "as-release-private.h"
+#include "as-screenshot-private.h"
 
 G_BEGIN_DECLS
 
@@ -44,6 +47,18 @@ typedef enum {
 	AS_APP_PROBLEM_LAST
 } AsAppProblems;
 
+typedef struct {
+	gchar		**values_ascii;
+	gchar		**values_utf8;
+	guint		  score;
+} AsAppTokenItem;
+
+#define AS_APP_VARIANT_TYPE	"(msuiumsmsmsmsmsa{sms}a{sms}a{sms}a{sms}a{sms}a{sms}" \
+				 "amsamsamsamsamsamsamsa{si}" \
+				 "a" AS_SCREENSHOT_VARIANT_TYPE \
+				 "a" AS_RELEASE_VARIANT_TYPE \
+				 "a" AS_PROVIDE_VARIANT_TYPE "u)"
+
 AsAppProblems	 as_app_get_problems		(AsApp		*app);
 guint		 as_app_get_name_size		(AsApp		*app);
 guint		 as_app_get_comment_size	(AsApp		*app);
@@ -55,6 +70,19 @@ GNode		*as_app_node_insert		(AsApp		*app,
 gboolean	 as_app_node_parse		(AsApp		*app,
 						 GNode		*node,
 						 GError		**error);
+gboolean	 as_app_node_parse_lazy		(AsApp		*app,
+						 GNode		*node,
+						 GError		**error);
+GPtrArray	*as_app_get_search_tokens	(AsApp		*app);
+guint		 as_app_get_changed_serial	(AsApp		*app);
+guint		 as_app_get_changed_serial_global (void);
+GVariant	*as_app_to_variant		(AsApp		*app);
+gboolean	 as_app_from_variant		(AsApp		*app,
+						 GVariant	*value,
+						 GError		**error);
+gboolean	 as_app_from_variant_lazy	(AsApp		*app,
+						 GVariant	*value,
+						 GError		**error);
 
 G_END_DECLS
 
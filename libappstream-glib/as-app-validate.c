@@ -31,12 +31,71 @@
 #include "as-node-private.h"
 #include "as-problem.h"
 #include "as-utils.h"
+#include "as-utils-private.h"
+
+/* the number of screenshot URLs checked at the same time */
+#define AS_APP_VALIDATE_MAX_REQUESTS	4
+
+/* cached results that have not been used for this long are dropped */
+#define AS_APP_VALIDATE_CACHE_MAX_AGE	(60 * 60 * 24 * 30)
+
+/* shared by all the applications validated in one batch */
+typedef struct {
+	SoupSession		*session;
+	GMutex			 mutex;
+	GCond			 cond;		/* signalled when a download ends */
+	GHashTable		*image_urls;	/* of url:AsAppValidateImage */
+	GHashTable		*image_urls_pending;	/* of url being downloaded */
+	GHashTable		*license_ids;	/* of id:GINT_TO_POINTER(valid) */
+	GKeyFile		*cache;		/* or NULL if not persistent */
+	gboolean		 cache_changed;
+	GThreadPool		*prefetch_pool;	/* or NULL if not prefetching */
+} AsAppValidateShared;
+
+/* the screenshots being prefetched for one application */
+typedef struct {
+	GMutex			 mutex;
+	GCond			 cond;
+	guint			 pending;
+} AsAppValidatePrefetch;
+
+typedef struct {
+	AsAppValidateShared	*shared;
+	AsAppValidatePrefetch	*prefetch;
+	const gchar		*url;
+} AsAppValidatePrefetchItem;
+
+typedef enum {
+	AS_APP_VALIDATE_IMAGE_RESULT_OK,
+	AS_APP_VALIDATE_IMAGE_RESULT_URL_INVALID,
+	AS_APP_VALIDATE_IMAGE_RESULT_NOT_FOUND,
+	AS_APP_VALIDATE_IMAGE_RESULT_ZERO_LENGTH,
+	AS_APP_VALIDATE_IMAGE_RESULT_NOT_IMAGE,
+	AS_APP_VALIDATE_IMAGE_RESULT_LAST
+} AsAppValidateImageResult;
+
+typedef struct {
+	AsAppValidateImageResult result;
+	guint			 width;
+	guint			 height;
+	gchar			*etag;
+} AsAppValidateImage;
+
+typedef struct {
+	SoupSession		*session;
+	GdkPixbufLoader		*loader;
+	gsize			 length;
+	gboolean		 failed;
+	gboolean		 got_size;
+	guint			 width;
+	guint			 height;
+} AsAppValidateDownload;
 
 typedef struct {
 	AsAppValidateFlags	 flags;
 	GPtrArray		*screenshot_urls;
 	GPtrArray		*probs;
-	SoupSession		*session;
+	AsAppValidateShared	*shared;
 	gboolean		 previous_para_was_short;
 	guint			 para_chars_before_list;
 	guint			 number_paragraphs;
@@ -340,27 +399,332 @@ as_app_validate_image_url_already_exists (AsAppValidateHelper *helper,
 	return FALSE;
 }
 
+/**
+ * as_app_validate_image_result_to_problem:
+ **/
+static const gchar *
+as_app_validate_image_result_to_problem (AsAppValidateImageResult result,
+					 AsProblemKind *kind)
+{
+	switch (result) {
+	case AS_APP_VALIDATE_IMAGE_RESULT_URL_INVALID:
+		*kind = AS_PROBLEM_KIND_URL_NOT_FOUND;
+		return "<screenshot> url not valid";
+	case AS_APP_VALIDATE_IMAGE_RESULT_NOT_FOUND:
+		*kind = AS_PROBLEM_KIND_URL_NOT_FOUND;
+		return "<screenshot> url not found";
+	case AS_APP_VALIDATE_IMAGE_RESULT_ZERO_LENGTH:
+		*kind = AS_PROBLEM_KIND_FILE_INVALID;
+		return "<screenshot> url is a zero length file";
+	case AS_APP_VALIDATE_IMAGE_RESULT_NOT_IMAGE:
+		*kind = AS_PROBLEM_KIND_FILE_INVALID;
+		return "<screenshot> failed to load image";
+	default:
+		break;
+	}
+	return NULL;
+}
+
+/**
+ * as_app_validate_image_free:
+ **/
+static void
+as_app_validate_image_free (AsAppValidateImage *image)
+{
+	g_free (image->etag);
+	g_free (image);
+}
+
+/**
+ * as_app_validate_size_prepared_cb:
+ **/
+static void
+as_app_validate_size_prepared_cb (GdkPixbufLoader *loader,
+				  gint width,
+				  gint height,
+				  gpointer user_data)
+{
+	AsAppValidateDownload *dl = (AsAppValidateDownload *) user_data;
+	dl->width = width;
+	dl->height = height;
+	dl->got_size = TRUE;
+}
+
+/**
+ * as_app_validate_got_chunk_cb:
+ *
+ * Feeds each chunk of the image to the loader until the header has been
+ * parsed, and then stops the download.
+ **/
+static void
+as_app_validate_got_chunk_cb (SoupMessage *msg,
+			      SoupBuffer *chunk,
+			      gpointer user_data)
+{
+	AsAppValidateDownload *dl = (AsAppValidateDownload *) user_data;
+
+	/* error pages are not images */
+	if (msg->status_code != SOUP_STATUS_OK)
+		return;
+	dl->length += chunk->length;
+	if (dl->got_size || dl->failed)
+		return;
+	if (!gdk_pixbuf_loader_write (dl->loader,
+				      (const guchar *) chunk->data,
+				      chunk->length, NULL))
+		dl->failed = TRUE;
+	if (dl->got_size || dl->failed)
+		soup_session_cancel_message (dl->session, msg, SOUP_STATUS_CANCELLED);
+}
+
+/**
+ * as_app_validate_image_download:
+ *
+ * Downloads just enough of an image to get the size, unless @cached is still
+ * current according to the server.
+ **/
+static gboolean
+as_app_validate_image_download (SoupSession *session,
+				const gchar *url,
+				AsAppValidateImage *cached,
+				AsAppValidateImage *image)
+{
+	AsAppValidateDownload dl;
+	gint status_code;
+	_cleanup_object_unref_ GdkPixbufLoader *loader = NULL;
+	_cleanup_object_unref_ SoupMessage *msg = NULL;
+	_cleanup_uri_unref_ SoupURI *base_uri = NULL;
+
+	g_debug ("checking %s", url);
+	base_uri = soup_uri_new (url);
+	if (base_uri == NULL) {
+		image->result = AS_APP_VALIDATE_IMAGE_RESULT_URL_INVALID;
+		return TRUE;
+	}
+	msg = soup_message_new_from_uri (SOUP_METHOD_GET, base_uri);
+	if (msg == NULL) {
+		g_warning ("Failed to setup message");
+		return FALSE;
+	}
+	if (cached != NULL && cached->etag != NULL) {
+		soup_message_headers_append (msg->request_headers,
+					     "If-None-Match", cached->etag);
+	}
+
+	/* send sync, handling the data as it arrives */
+	loader = gdk_pixbuf_loader_new ();
+	memset (&dl, 0, sizeof (dl));
+	dl.session = session;
+	dl.loader = loader;
+	g_signal_connect (loader, "size-prepared",
+			  G_CALLBACK (as_app_validate_size_prepared_cb), &dl);
+	g_signal_connect (msg, "got-chunk",
+			  G_CALLBACK (as_app_validate_got_chunk_cb), &dl);
+	soup_message_body_set_accumulate (msg->response_body, FALSE);
+	status_code = soup_session_send_message (session, msg);
+	gdk_pixbuf_loader_close (loader, NULL);
+
+	/* the old result is still valid */
+	if (status_code == SOUP_STATUS_NOT_MODIFIED && cached != NULL) {
+		image->result = cached->result;
+		image->width = cached->width;
+		image->height = cached->height;
+		image->etag = g_strdup (cached->etag);
+		return TRUE;
+	}
+
+	/* the download was stopped as soon as the size was known */
+	if (dl.got_size) {
+		image->result = AS_APP_VALIDATE_IMAGE_RESULT_OK;
+		image->width = dl.width;
+		image->height = dl.height;
+	} else if (dl.failed) {
+		image->result = AS_APP_VALIDATE_IMAGE_RESULT_NOT_IMAGE;
+	} else if (status_code != SOUP_STATUS_OK) {
+		image->result = AS_APP_VALIDATE_IMAGE_RESULT_NOT_FOUND;
+		return TRUE;
+	} else if (dl.length == 0) {
+		image->result = AS_APP_VALIDATE_IMAGE_RESULT_ZERO_LENGTH;
+	} else {
+		image->result = AS_APP_VALIDATE_IMAGE_RESULT_NOT_IMAGE;
+	}
+	image->etag = g_strdup (soup_message_headers_get_one (msg->response_headers,
+							      "ETag"));
+	return TRUE;
+}
+
+/**
+ * as_app_validate_cache_get_group:
+ *
+ * Gets the group name for a URL, which is hashed as URLs can contain
+ * characters such as '[' that are not allowed in group names.
+ **/
+static gchar *
+as_app_validate_cache_get_group (const gchar *url)
+{
+	return g_compute_checksum_for_string (G_CHECKSUM_SHA1, url, -1);
+}
+
+/**
+ * as_app_validate_cache_lookup:
+ *
+ * Gets the result from a previous run, which must be called with the
+ * mutex held.
+ **/
+static AsAppValidateImage *
+as_app_validate_cache_lookup (AsAppValidateShared *shared, const gchar *url)
+{
+	AsAppValidateImage *image;
+	_cleanup_free_ gchar *etag = NULL;
+	_cleanup_free_ gchar *group = NULL;
+
+	if (shared->cache == NULL)
+		return NULL;
+	group = as_app_validate_cache_get_group (url);
+	etag = g_key_file_get_string (shared->cache, group, "ETag", NULL);
+	if (etag == NULL)
+		return NULL;
+	image = g_new0 (AsAppValidateImage, 1);
+	image->result = g_key_file_get_integer (shared->cache, group, "Result", NULL);
+	image->width = g_key_file_get_integer (shared->cache, group, "Width", NULL);
+	image->height = g_key_file_get_integer (shared->cache, group, "Height", NULL);
+	image->etag = g_strdup (etag);
+	if (image->result >= AS_APP_VALIDATE_IMAGE_RESULT_LAST) {
+		as_app_validate_image_free (image);
+		return NULL;
+	}
+	return image;
+}
+
+/**
+ * as_app_validate_cache_add:
+ **/
+static void
+as_app_validate_cache_add (AsAppValidateShared *shared,
+			   const gchar *url,
+			   AsAppValidateImage *image)
+{
+	_cleanup_free_ gchar *group = NULL;
+
+	/* the server can only say if the result is still valid with an ETag */
+	if (shared->cache == NULL || image->etag == NULL)
+		return;
+	group = as_app_validate_cache_get_group (url);
+	g_key_file_set_string (shared->cache, group, "ETag", image->etag);
+	g_key_file_set_integer (shared->cache, group, "Result", image->result);
+	g_key_file_set_integer (shared->cache, group, "Width", image->width);
+	g_key_file_set_integer (shared->cache, group, "Height", image->height);
+	g_key_file_set_int64 (shared->cache, group, "Checked",
+			      g_get_real_time () / G_USEC_PER_SEC);
+	shared->cache_changed = TRUE;
+}
+
+/**
+ * as_app_validate_cache_prune:
+ *
+ * Removes the results that have not been checked for a long time, so that
+ * the cache does not keep growing.
+ **/
+static void
+as_app_validate_cache_prune (AsAppValidateShared *shared)
+{
+	gint64 checked;
+	gint64 now;
+	guint i;
+	_cleanup_strv_free_ gchar **groups = NULL;
+
+	now = g_get_real_time () / G_USEC_PER_SEC;
+	groups = g_key_file_get_groups (shared->cache, NULL);
+	for (i = 0; groups[i] != NULL; i++) {
+		checked = g_key_file_get_int64 (shared->cache, groups[i],
+						"Checked", NULL);
+		if (checked > now - AS_APP_VALIDATE_CACHE_MAX_AGE &&
+		    checked <= now)
+			continue;
+		g_key_file_remove_group (shared->cache, groups[i], NULL);
+		shared->cache_changed = TRUE;
+	}
+}
+
+/**
+ * as_app_validate_fetch_image:
+ *
+ * Gets the result of loading an image, only downloading each URL once for
+ * all the applications sharing @shared.
+ **/
+static AsAppValidateImage *
+as_app_validate_fetch_image (AsAppValidateShared *shared, const gchar *url)
+{
+	AsAppValidateImage *cached;
+	AsAppValidateImage *image;
+
+	/* wait for another thread downloading the same URL */
+	g_mutex_lock (&shared->mutex);
+	while (g_hash_table_contains (shared->image_urls_pending, url))
+		g_cond_wait (&shared->cond, &shared->mutex);
+	image = g_hash_table_lookup (shared->image_urls, url);
+	if (image != NULL) {
+		g_mutex_unlock (&shared->mutex);
+		return image;
+	}
+	cached = as_app_validate_cache_lookup (shared, url);
+	g_hash_table_add (shared->image_urls_pending, g_strdup (url));
+	g_mutex_unlock (&shared->mutex);
+
+	/* download without holding the lock */
+	image = g_new0 (AsAppValidateImage, 1);
+	if (!as_app_validate_image_download (shared->session, url, cached, image)) {
+		as_app_validate_image_free (image);
+		image = NULL;
+	}
+	if (cached != NULL)
+		as_app_validate_image_free (cached);
+	g_mutex_lock (&shared->mutex);
+	if (image != NULL) {
+		g_hash_table_insert (shared->image_urls, g_strdup (url), image);
+		as_app_validate_cache_add (shared, url, image);
+	}
+	g_hash_table_remove (shared->image_urls_pending, url);
+	g_cond_broadcast (&shared->cond);
+	g_mutex_unlock (&shared->mutex);
+	return image;
+}
+
+/**
+ * as_app_validate_fetch_image_thread_cb:
+ **/
+static void
+as_app_validate_fetch_image_thread_cb (gpointer data, gpointer user_data)
+{
+	AsAppValidatePrefetchItem *item = (AsAppValidatePrefetchItem *) data;
+	AsAppValidatePrefetch *prefetch = item->prefetch;
+
+	as_app_validate_fetch_image (item->shared, item->url);
+	g_mutex_lock (&prefetch->mutex);
+	if (--prefetch->pending == 0)
+		g_cond_signal (&prefetch->cond);
+	g_mutex_unlock (&prefetch->mutex);
+}
+
 /**
  * ai_app_validate_image_check:
  */
 static gboolean
 ai_app_validate_image_check (AsImage *im, AsAppValidateHelper *helper)
 {
+	AsAppValidateImage *image;
+	AsProblemKind kind;
+	const gchar *message;
 	const gchar *url;
 	gboolean require_correct_aspect_ratio = FALSE;
 	gdouble desired_aspect = 1.777777778;
 	gdouble screenshot_aspect;
-	gint status_code;
 	guint screenshot_height;
 	guint screenshot_width;
 	guint ss_size_height_max = 900;
 	guint ss_size_height_min = 351;
 	guint ss_size_width_max = 1600;
 	guint ss_size_width_min = 624;
-	_cleanup_object_unref_ GdkPixbuf *pixbuf = NULL;
-	_cleanup_object_unref_ GInputStream *stream = NULL;
-	_cleanup_object_unref_ SoupMessage *msg = NULL;
-	_cleanup_uri_unref_ SoupURI *base_uri = NULL;
 
 	/* make the requirements more strict */
 	if ((helper->flags & AS_APP_VALIDATE_FLAG_STRICT) > 0) {
@@ -379,62 +743,20 @@ ai_app_validate_image_check (AsImage *im, AsAppValidateHelper *helper)
 	if ((helper->flags & AS_APP_VALIDATE_FLAG_NO_NETWORK) > 0)
 		return TRUE;
 
-	/* GET file */
+	/* GET file, or use the result from another application */
 	url = as_image_get_url (im);
-	g_debug ("checking %s", url);
-	base_uri = soup_uri_new (url);
-	if (base_uri == NULL) {
-		ai_app_validate_add (helper->probs,
-				     AS_PROBLEM_KIND_URL_NOT_FOUND,
-				     "<screenshot> url not valid");
+	image = as_app_validate_fetch_image (helper->shared, url);
+	if (image == NULL)
 		return FALSE;
-	}
-	msg = soup_message_new_from_uri (SOUP_METHOD_GET, base_uri);
-	if (msg == NULL) {
-		g_warning ("Failed to setup message");
-		return FALSE;
-	}
-
-	/* send sync */
-	status_code = soup_session_send_message (helper->session, msg);
-	if (status_code != SOUP_STATUS_OK) {
-		ai_app_validate_add (helper->probs,
-				     AS_PROBLEM_KIND_URL_NOT_FOUND,
-				     "<screenshot> url not found");
-		return FALSE;
-	}
-
-	/* check if it's a zero sized file */
-	if (msg->response_body->length == 0) {
-		ai_app_validate_add (helper->probs,
-				     AS_PROBLEM_KIND_FILE_INVALID,
-				     "<screenshot> url is a zero length file");
-		return FALSE;
-	}
-
-	/* create a buffer with the data */
-	stream = g_memory_input_stream_new_from_data (msg->response_body->data,
-						      msg->response_body->length,
-						      NULL);
-	if (stream == NULL) {
-		ai_app_validate_add (helper->probs,
-				     AS_PROBLEM_KIND_URL_NOT_FOUND,
-				     "<screenshot> failed to load data");
-		return FALSE;
-	}
-
-	/* load the image */
-	pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
-	if (pixbuf == NULL) {
-		ai_app_validate_add (helper->probs,
-				     AS_PROBLEM_KIND_FILE_INVALID,
-				     "<screenshot> failed to load image");
+	message = as_app_validate_image_result_to_problem (image->result, &kind);
+	if (message != NULL) {
+		ai_app_validate_add (helper->probs, kind, message);
 		return FALSE;
 	}
+	screenshot_width = image->width;
+	screenshot_height = image->height;
 
 	/* check width matches */
-	screenshot_width = gdk_pixbuf_get_width (pixbuf);
-	screenshot_height = gdk_pixbuf_get_height (pixbuf);
 	if (as_image_get_width (im) != 0 &&
 	    as_image_get_width (im) != screenshot_width) {
 		ai_app_validate_add (helper->probs,
@@ -541,6 +863,69 @@ as_app_validate_screenshot (AsScreenshot *ss, AsAppValidateHelper *helper)
 	}
 }
 
+/**
+ * as_app_validate_screenshots_prefetch:
+ *
+ * Downloads the start of all the screenshot images at the same time so that
+ * the checks done afterwards only have to look in the cache. The pool is
+ * shared by all the applications in the batch, so the number of requests
+ * made at the same time stays the same however many are validated.
+ **/
+static void
+as_app_validate_screenshots_prefetch (GPtrArray *screenshots,
+				      AsAppValidateHelper *helper)
+{
+	AsAppValidatePrefetch prefetch;
+	AsImage *im;
+	AsScreenshot *ss;
+	GPtrArray *images;
+	GThreadPool *pool = helper->shared->prefetch_pool;
+	const gchar *url;
+	guint i;
+	guint j;
+	_cleanup_array_unref_ GArray *items = NULL;
+
+	if (pool == NULL)
+		return;
+
+	/* the array is not resized once the items are being used */
+	items = g_array_new (FALSE, FALSE, sizeof (AsAppValidatePrefetchItem));
+	for (i = 0; i < screenshots->len; i++) {
+		ss = g_ptr_array_index (screenshots, i);
+		images = as_screenshot_get_images (ss);
+		for (j = 0; j < images->len; j++) {
+			AsAppValidatePrefetchItem item;
+			im = g_ptr_array_index (images, j);
+			url = as_image_get_url (im);
+			if (url == NULL || url[0] == '\0')
+				continue;
+			item.shared = helper->shared;
+			item.prefetch = &prefetch;
+			item.url = url;
+			g_array_append_val (items, item);
+		}
+	}
+	if (items->len == 0)
+		return;
+
+	/* wait for just the images of this application */
+	g_mutex_init (&prefetch.mutex);
+	g_cond_init (&prefetch.cond);
+	prefetch.pending = items->len;
+	for (i = 0; i < items->len; i++) {
+		AsAppValidatePrefetchItem *item;
+		item = &g_array_index (items, AsAppValidatePrefetchItem, i);
+		if (!g_thread_pool_push (pool, item, NULL))
+			as_app_validate_fetch_image_thread_cb (item, NULL);
+	}
+	g_mutex_lock (&prefetch.mutex);
+	while (prefetch.pending > 0)
+		g_cond_wait (&prefetch.cond, &prefetch.mutex);
+	g_mutex_unlock (&prefetch.mutex);
+	g_mutex_clear (&prefetch.mutex);
+	g_cond_clear (&prefetch.cond);
+}
+
 /**
  * as_app_validate_screenshots:
  **/
@@ -579,6 +964,9 @@ as_app_validate_screenshots (AsApp *app, AsAppValidateHelper *helper)
 				     AS_PROBLEM_KIND_STYLE_INCORRECT,
 				     "Too many <screenshot> tags");
 	}
+	if ((helper->flags & AS_APP_VALIDATE_FLAG_PARALLEL) > 0 &&
+	    (helper->flags & AS_APP_VALIDATE_FLAG_NO_NETWORK) == 0)
+		as_app_validate_screenshots_prefetch (screenshots, helper);
 	for (i = 0; i < screenshots->len; i++) {
 		ss = g_ptr_array_index (screenshots, i);
 		as_app_validate_screenshot (ss, helper);
@@ -691,64 +1079,202 @@ as_app_validate_releases (AsApp *app, AsAppValidateHelper *helper, GError **erro
  * as_app_validate_setup_networking:
  **/
 static gboolean
-as_app_validate_setup_networking (AsAppValidateHelper *helper, GError **error)
+as_app_validate_setup_networking (AsAppValidateShared *shared, GError **error)
 {
-	helper->session = soup_session_sync_new_with_options (SOUP_SESSION_USER_AGENT,
+	shared->session = soup_session_sync_new_with_options (SOUP_SESSION_USER_AGENT,
 							      "libappstream-glib",
 							      SOUP_SESSION_TIMEOUT,
 							      5000,
+							      SOUP_SESSION_MAX_CONNS_PER_HOST,
+							      AS_APP_VALIDATE_MAX_REQUESTS,
 							      NULL);
-	if (helper->session == NULL) {
+	if (shared->session == NULL) {
 		g_set_error_literal (error,
 				     AS_APP_ERROR,
 				     AS_APP_ERROR_FAILED,
 				     "Failed to set up networking");
 		return FALSE;
 	}
-	soup_session_add_feature_by_type (helper->session,
+	soup_session_add_feature_by_type (shared->session,
 					  SOUP_TYPE_PROXY_RESOLVER_DEFAULT);
 	return TRUE;
 }
 
 /**
- * as_app_validate_license:
+ * as_app_validate_cache_get_filename:
  **/
-static gboolean
-as_app_validate_license (const gchar *license_text, GError **error)
+static gchar *
+as_app_validate_cache_get_filename (void)
 {
-	guint i;
-	_cleanup_strv_free_ gchar **licenses = NULL;
+	return g_build_filename (g_get_user_cache_dir (),
+				 "appstream-glib",
+				 "validate-urls.cache",
+				 NULL);
+}
 
-	licenses = as_utils_spdx_license_tokenize (license_text);
-	for (i = 0; licenses[i] != NULL; i++) {
-		if (g_str_has_prefix (licenses[i], "#"))
-			continue;
-		if (!as_utils_is_spdx_license_id (licenses[i])) {
-			g_set_error (error,
-				     AS_APP_ERROR,
-				     AS_APP_ERROR_FAILED,
-				     "SPDX ID '%s' unknown",
-				     licenses[i]);
-			return FALSE;
-		}
+/**
+ * as_app_validate_cache_save:
+ **/
+static void
+as_app_validate_cache_save (AsAppValidateShared *shared)
+{
+	gsize len;
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_free_ gchar *data = NULL;
+	_cleanup_free_ gchar *dirname = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+
+	filename = as_app_validate_cache_get_filename ();
+	dirname = g_path_get_dirname (filename);
+	if (g_mkdir_with_parents (dirname, 0700) < 0) {
+		g_warning ("Failed to create %s", dirname);
+		return;
 	}
-	return TRUE;
+	data = g_key_file_to_data (shared->cache, &len, NULL);
+	if (!g_file_set_contents (filename, data, len, &error))
+		g_warning ("Failed to save cache: %s", error->message);
 }
 
 /**
- * as_app_validate:
- * @app: a #AsApp instance.
- * @flags: the #AsAppValidateFlags to use, e.g. %AS_APP_VALIDATE_FLAG_NONE
- * @error: A #GError or %NULL.
- *
- * Validates data in the instance for style and consitency.
- *
- * Returns: (transfer container) (element-type AsProblem): A list of problems, or %NULL
+ * as_app_validate_shared_free:
+ **/
+static void
+as_app_validate_shared_free (AsAppValidateShared *shared)
+{
+	if (shared->prefetch_pool != NULL)
+		g_thread_pool_free (shared->prefetch_pool, FALSE, TRUE);
+	if (shared->cache != NULL) {
+		if (shared->cache_changed)
+			as_app_validate_cache_save (shared);
+		g_key_file_unref (shared->cache);
+	}
+	if (shared->session != NULL)
+		g_object_unref (shared->session);
+	g_hash_table_unref (shared->image_urls);
+	g_hash_table_unref (shared->image_urls_pending);
+	g_hash_table_unref (shared->license_ids);
+	g_mutex_clear (&shared->mutex);
+	g_cond_clear (&shared->cond);
+	g_free (shared);
+}
+
+/**
+ * as_app_validate_shared_new:
+ **/
+static AsAppValidateShared *
+as_app_validate_shared_new (AsAppValidateFlags flags, GError **error)
+{
+	AsAppValidateShared *shared;
+
+	shared = g_new0 (AsAppValidateShared, 1);
+	g_mutex_init (&shared->mutex);
+	g_cond_init (&shared->cond);
+	shared->image_urls = g_hash_table_new_full (g_str_hash, g_str_equal,
+						    g_free, (GDestroyNotify) as_app_validate_image_free);
+	shared->image_urls_pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+							    g_free, NULL);
+	shared->license_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     g_free, NULL);
+	if ((flags & AS_APP_VALIDATE_FLAG_USE_CACHE) > 0) {
+		_cleanup_free_ gchar *filename = NULL;
+		filename = as_app_validate_cache_get_filename ();
+		shared->cache = g_key_file_new ();
+		if (!g_key_file_load_from_file (shared->cache, filename,
+						G_KEY_FILE_NONE, NULL))
+			g_debug ("no validation cache in %s", filename);
+		as_app_validate_cache_prune (shared);
+	}
+	if ((flags & AS_APP_VALIDATE_FLAG_PARALLEL) > 0 &&
+	    (flags & AS_APP_VALIDATE_FLAG_NO_NETWORK) == 0) {
+		shared->prefetch_pool = g_thread_pool_new (as_app_validate_fetch_image_thread_cb,
+							   NULL,
+							   AS_APP_VALIDATE_MAX_REQUESTS,
+							   FALSE,
+							   NULL);
+	}
+	if (!as_app_validate_setup_networking (shared, error)) {
+		as_app_validate_shared_free (shared);
+		return NULL;
+	}
+	return shared;
+}
+
+#ifndef HAVE_GPERF
+/**
+ * as_app_validate_is_spdx_license_id:
  *
- * Since: 0.1.4
+ * Searching the license list is slow without the perfect hash, so the
+ * result for each ID is kept for the whole batch. The ID is only copied
+ * into the cache the first time it is seen.
  **/
-GPtrArray *
-as_app_validate (AsApp *app, AsAppValidateFlags flags, GError **error)
+static gboolean
+as_app_validate_is_spdx_license_id (const gchar *license_id,
+				    guint len,
+				    gpointer user_data)
+{
+	AsAppValidateShared *shared = (AsAppValidateShared *) user_data;
+	gboolean ret;
+	gchar key[64];
+	gpointer value;
+
+	/* longer than any known ID */
+	if (len >= sizeof (key))
+		return FALSE;
+	memcpy (key, license_id, len);
+	key[len] = '\0';
+	g_mutex_lock (&shared->mutex);
+	if (g_hash_table_lookup_extended (shared->license_ids, key,
+					  NULL, &value)) {
+		g_mutex_unlock (&shared->mutex);
+		return GPOINTER_TO_INT (value);
+	}
+	g_mutex_unlock (&shared->mutex);
+
+	ret = as_utils_is_spdx_license_id (key);
+	g_mutex_lock (&shared->mutex);
+	g_hash_table_insert (shared->license_ids,
+			     g_strdup (key),
+			     GINT_TO_POINTER (ret));
+	g_mutex_unlock (&shared->mutex);
+	return ret;
+}
+#endif
+
+/**
+ * as_app_validate_license:
+ **/
+static gboolean
+as_app_validate_license (AsAppValidateShared *shared,
+			 const gchar *license_text,
+			 GError **error)
+{
+	AsSpdxExpression *expr;
+
+#ifdef HAVE_GPERF
+	/* the perfect hash needs no copy of the ID and no cache */
+	expr = as_utils_spdx_parse_full (license_text,
+					 AS_SPDX_PARSE_FLAG_VALIDATE,
+					 NULL, NULL, error);
+#else
+	expr = as_utils_spdx_parse_full (license_text,
+					 AS_SPDX_PARSE_FLAG_VALIDATE,
+					 as_app_validate_is_spdx_license_id,
+					 shared, error);
+#endif
+	if (expr == NULL)
+		return FALSE;
+	as_utils_spdx_expression_free (expr);
+	return TRUE;
+}
+
+/**
+ * as_app_validate_full:
+ **/
+static GPtrArray *
+as_app_validate_full (AsApp *app,
+		      AsAppValidateFlags flags,
+		      AsAppValidateShared *shared,
+		      GError **error)
 {
 	AsAppProblems problems;
 	AsAppValidateHelper helper;
@@ -798,18 +1324,14 @@ as_app_validate (AsApp *app, AsAppValidateFlags flags, GError **error)
 		require_project_license = TRUE;
 	}
 
-	/* set up networking */
+	/* networking and caches are shared */
 	helper.probs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	helper.screenshot_urls = g_ptr_array_new_with_free_func (g_free);
 	helper.flags = flags;
+	helper.shared = shared;
 	helper.previous_para_was_short = FALSE;
 	helper.para_chars_before_list = 0;
 	helper.number_paragraphs = 0;
-	ret = as_app_validate_setup_networking (&helper, error);
-	if (!ret)
-		goto out;
-
-	/* success, enough */
 	probs = helper.probs;
 
 	/* id */
@@ -882,7 +1404,7 @@ as_app_validate (AsApp *app, AsAppValidateFlags flags, GError **error)
 	/* project_license */
 	license = as_app_get_project_license (app);
 	if (license != NULL) {
-		ret = as_app_validate_license (license, &error_local);
+		ret = as_app_validate_license (shared, license, &error_local);
 		if (!ret) {
 			g_prefix_error (&error_local,
 					"<project_license> is not valid: ");
@@ -979,8 +1501,11 @@ as_app_validate (AsApp *app, AsAppValidateFlags flags, GError **error)
 
 	/* releases */
 	ret = as_app_validate_releases (app, &helper, error);
-	if (!ret)
+	if (!ret) {
+		g_ptr_array_unref (probs);
+		probs = NULL;
 		goto out;
+	}
 
 	/* name */
 	name = as_app_get_name (app, "C");
@@ -1105,7 +1630,148 @@ as_app_validate (AsApp *app, AsAppValidateFlags flags, GError **error)
 	}
 out:
 	g_ptr_array_unref (helper.screenshot_urls);
-	if (helper.session != NULL)
-		g_object_unref (helper.session);
 	return probs;
 }
+
+/**
+ * as_app_validate:
+ * @app: a #AsApp instance.
+ * @flags: the #AsAppValidateFlags to use, e.g. %AS_APP_VALIDATE_FLAG_NONE
+ * @error: A #GError or %NULL.
+ *
+ * Validates data in the instance for style and consitency.
+ *
+ * Returns: (transfer container) (element-type AsProblem): A list of problems, or %NULL
+ *
+ * Since: 0.1.4
+ **/
+GPtrArray *
+as_app_validate (AsApp *app, AsAppValidateFlags flags, GError **error)
+{
+	AsAppValidateShared *shared;
+	GPtrArray *probs;
+
+	shared = as_app_validate_shared_new (flags, error);
+	if (shared == NULL)
+		return NULL;
+	probs = as_app_validate_full (app, flags, shared, error);
+	as_app_validate_shared_free (shared);
+	return probs;
+}
+
+typedef struct {
+	AsApp			*app;
+	GPtrArray		*probs;
+	GError			*error;
+} AsAppValidateItem;
+
+typedef struct {
+	AsAppValidateFlags	 flags;
+	AsAppValidateShared	*shared;
+} AsAppValidateBatchHelper;
+
+/**
+ * as_app_validate_item_thread_cb:
+ **/
+static void
+as_app_validate_item_thread_cb (gpointer data, gpointer user_data)
+{
+	AsAppValidateItem *item = (AsAppValidateItem *) data;
+	AsAppValidateBatchHelper *helper = (AsAppValidateBatchHelper *) user_data;
+	item->probs = as_app_validate_full (item->app,
+					    helper->flags,
+					    helper->shared,
+					    &item->error);
+}
+
+/**
+ * as_app_validate_batch_probs_free:
+ **/
+static void
+as_app_validate_batch_probs_free (GPtrArray *probs)
+{
+	if (probs != NULL)
+		g_ptr_array_unref (probs);
+}
+
+/**
+ * as_app_validate_batch_error_free:
+ **/
+static void
+as_app_validate_batch_error_free (GError *error)
+{
+	if (error != NULL)
+		g_error_free (error);
+}
+
+/**
+ * as_app_validate_batch:
+ * @apps: (element-type AsApp): an array of #AsApp instances.
+ * @flags: the #AsAppValidateFlags to use, e.g. %AS_APP_VALIDATE_FLAG_NONE
+ * @errors: (out) (allow-none) (element-type GError): the error for each
+ * application in the same order as @apps, or %NULL
+ * @error: A #GError or %NULL.
+ *
+ * Validates a number of applications in a thread pool, sharing one network
+ * session and caching the results of screenshot downloads and license
+ * lookups between them.
+ *
+ * An application that could not be validated does not stop the others.
+ * Its entry in the returned list is %NULL, and its entry in @errors is set
+ * to the reason. The entries in @errors are %NULL for the applications that
+ * were validated. @error is only set if the batch could not be started.
+ *
+ * Returns: (transfer full) (element-type GPtrArray): A list of the
+ * problems found for each application in the same order as @apps, or %NULL
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_app_validate_batch (GPtrArray *apps,
+		       AsAppValidateFlags flags,
+		       GPtrArray **errors,
+		       GError **error)
+{
+	AsAppValidateBatchHelper helper;
+	GPtrArray *results;
+	GThreadPool *pool;
+	guint i;
+	_cleanup_free_ AsAppValidateItem *items = NULL;
+
+	g_return_val_if_fail (apps != NULL, NULL);
+
+	helper.flags = flags;
+	helper.shared = as_app_validate_shared_new (flags, error);
+	if (helper.shared == NULL)
+		return NULL;
+
+	/* validate each application */
+	items = g_new0 (AsAppValidateItem, apps->len);
+	pool = g_thread_pool_new (as_app_validate_item_thread_cb,
+				  &helper,
+				  (gint) g_get_num_processors (),
+				  FALSE,
+				  NULL);
+	for (i = 0; i < apps->len; i++) {
+		items[i].app = g_ptr_array_index (apps, i);
+		if (pool == NULL || !g_thread_pool_push (pool, &items[i], NULL))
+			as_app_validate_item_thread_cb (&items[i], &helper);
+	}
+	if (pool != NULL)
+		g_thread_pool_free (pool, FALSE, TRUE);
+	as_app_validate_shared_free (helper.shared);
+
+	/* return the results and errors in order */
+	results = g_ptr_array_new_with_free_func ((GDestroyNotify) as_app_validate_batch_probs_free);
+	if (errors != NULL)
+		*errors = g_ptr_array_new_with_free_func ((GDestroyNotify) as_app_validate_batch_error_free);
+	for (i = 0; i < apps->len; i++) {
+		g_ptr_array_add (results, items[i].probs);
+		if (errors != NULL) {
+			g_ptr_array_add (*errors, items[i].error);
+		} else if (items[i].error != NULL) {
+			g_error_free (items[i].error);
+		}
+	}
+	return results;
+}
@@ -47,6 +47,13 @@
 #include "as-tag.h"
 #include "as-utils-private.h"
 
+typedef enum {
+	AS_APP_LOCALIZED_NAME,
+	AS_APP_LOCALIZED_COMMENT,
+	AS_APP_LOCALIZED_DESCRIPTION,
+	AS_APP_LOCALIZED_LAST
+} AsAppLocalized;
+
 typedef struct _AsAppPrivate	AsAppPrivate;
 struct _AsAppPrivate
 {
@@ -72,6 +79,7 @@ struct _AsAppPrivate
 	GPtrArray	*provides;			/* of AsProvide */
 	GPtrArray	*screenshots;			/* of AsScreenshot */
 	AsAppSourceKind	 source_kind;
+	gchar		*source_file;
 	gchar		*icon;
 	gchar		*icon_path;
 	gchar		*id;
@@ -83,17 +91,160 @@ struct _AsAppPrivate
 	gint		 priority;
 	gsize		 token_cache_valid;
 	GPtrArray	*token_cache;			/* of AsAppTokenItem */
+	GNode		*lazy_node;			/* of unparsed elements */
+	GVariant	*lazy_variant;			/* of unparsed cache data */
+	gint		 lazy_pending;
+	gboolean	 lazy_loading;
+	gint		 changed_serial;
+	gint		 localized_serial;
+	const gchar * const *localized_locales;	/* of g_get_language_names() */
+	gint		 localized_cache_serial;
+	guint		 localized_cache_valid;		/* of AsAppLocalized bitfield */
+	const gchar	*localized_cache[AS_APP_LOCALIZED_LAST];
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsApp, as_app, G_TYPE_OBJECT)
 
 #define GET_PRIVATE(o) (as_app_get_instance_private (o))
 
-typedef struct {
-	gchar		**values_ascii;
-	gchar		**values_utf8;
-	guint		  score;
-} AsAppTokenItem;
+/* deferred elements are only ever parsed by one thread */
+static GRecMutex as_app_lazy_mutex;
+
+static void	 as_app_lazy_load		(AsApp		*app);
+
+/* bumped whenever any application changes a property that is indexed */
+static gint as_app_changed_serial = 0;
+
+/**
+ * as_app_ensure_lazy:
+ *
+ * Parses the large elements that were deferred when the application was
+ * loaded. Every method that uses them has to call this first.
+ **/
+static void
+as_app_ensure_lazy (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+
+	/* nothing to do */
+	if (g_atomic_int_get (&priv->lazy_pending) == 0)
+		return;
+
+	/* recursive calls from the parser itself do nothing */
+	g_rec_mutex_lock (&as_app_lazy_mutex);
+	if (priv->lazy_pending && !priv->lazy_loading) {
+		priv->lazy_loading = TRUE;
+		as_app_lazy_load (app);
+		priv->lazy_loading = FALSE;
+		g_atomic_int_set (&priv->lazy_pending, 0);
+	}
+	g_rec_mutex_unlock (&as_app_lazy_mutex);
+}
+
+/**
+ * as_app_changed:
+ *
+ * Records that a property the store indexes or sorts by has changed, i.e.
+ * the ID, name, priority, project group, categories, mimetypes, provides
+ * or metadata.
+ **/
+static void
+as_app_changed (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	g_atomic_int_inc (&priv->changed_serial);
+	g_atomic_int_inc (&priv->localized_serial);
+	g_atomic_int_inc (&as_app_changed_serial);
+}
+
+/**
+ * as_app_localized_changed:
+ *
+ * Records that a name, comment or description has changed, so that the
+ * values resolved for the user locale are looked up again.
+ **/
+static void
+as_app_localized_changed (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	g_atomic_int_inc (&priv->localized_serial);
+}
+
+/**
+ * as_app_lookup_localized:
+ *
+ * Looks up the best value for the user locale, remembering the result for
+ * the next call. g_get_language_names() returns the same array until the
+ * environment changes, so the array and the serial are enough to tell if
+ * the remembered value is still valid.
+ **/
+static const gchar *
+as_app_lookup_localized (AsApp *app,
+			 GHashTable *hash,
+			 AsAppLocalized idx,
+			 const gchar *locale)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	const gchar * const *locales;
+	const gchar *tmp;
+	gint serial;
+
+	/* the user specified a locale */
+	if (locale != NULL)
+		return g_hash_table_lookup (hash, locale);
+
+	locales = g_get_language_names ();
+	serial = g_atomic_int_get (&priv->localized_serial);
+	g_rec_mutex_lock (&as_app_lazy_mutex);
+	if (priv->localized_locales != locales ||
+	    priv->localized_cache_serial != serial) {
+		priv->localized_locales = locales;
+		priv->localized_cache_serial = serial;
+		priv->localized_cache_valid = 0;
+	}
+	if ((priv->localized_cache_valid & (1u << idx)) == 0) {
+		priv->localized_cache[idx] = as_hash_lookup_by_locales (hash, locales);
+		priv->localized_cache_valid |= 1u << idx;
+	}
+	tmp = priv->localized_cache[idx];
+	g_rec_mutex_unlock (&as_app_lazy_mutex);
+	return tmp;
+}
+
+/**
+ * as_app_get_changed_serial: (skip)
+ * @app: a #AsApp instance.
+ *
+ * Gets a number that changes whenever a property that can be indexed
+ * changes, so that callers can tell if their index is out of date.
+ *
+ * Returns: a serial number
+ *
+ * Since: 0.1.8
+ **/
+guint
+as_app_get_changed_serial (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	return (guint) g_atomic_int_get (&priv->changed_serial);
+}
+
+/**
+ * as_app_get_changed_serial_global: (skip)
+ *
+ * Gets a number that changes whenever any application changes a property
+ * that can be indexed, so that callers only have to check each application
+ * when something has changed.
+ *
+ * Returns: a serial number
+ *
+ * Since: 0.1.8
+ **/
+guint
+as_app_get_changed_serial_global (void)
+{
+	return (guint) g_atomic_int_get (&as_app_changed_serial);
+}
 
 /**
  * as_app_error_quark:
@@ -123,6 +274,7 @@ as_app_finalize (GObject *object)
 	g_free (priv->icon);
 	g_free (priv->icon_path);
 	g_free (priv->id);
+	g_free (priv->source_file);
 	g_free (priv->id_full);
 	g_free (priv->project_group);
 	g_free (priv->project_license);
@@ -147,6 +299,10 @@ as_app_finalize (GObject *object)
 	g_ptr_array_unref (priv->provides);
 	g_ptr_array_unref (priv->screenshots);
 	g_ptr_array_unref (priv->token_cache);
+	if (priv->lazy_node != NULL)
+		as_node_unref (priv->lazy_node);
+	if (priv->lazy_variant != NULL)
+		g_variant_unref (priv->lazy_variant);
 
 	G_OBJECT_CLASS (as_app_parent_class)->finalize (object);
 }
@@ -169,26 +325,28 @@ static void
 as_app_init (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	priv->categories = g_ptr_array_new_with_free_func (g_free);
-	priv->compulsory_for_desktops = g_ptr_array_new_with_free_func (g_free);
+	priv->categories = g_ptr_array_new ();
+	priv->compulsory_for_desktops = g_ptr_array_new ();
 	priv->extends = g_ptr_array_new_with_free_func (g_free);
 	priv->keywords = g_ptr_array_new_with_free_func (g_free);
-	priv->mimetypes = g_ptr_array_new_with_free_func (g_free);
+	priv->mimetypes = g_ptr_array_new ();
 	priv->pkgnames = g_ptr_array_new_with_free_func (g_free);
-	priv->architectures = g_ptr_array_new_with_free_func (g_free);
+	priv->architectures = g_ptr_array_new ();
 	priv->addons = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->releases = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->provides = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->screenshots = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
 	priv->token_cache = g_ptr_array_new_with_free_func ((GDestroyNotify) as_app_token_item_free);
 
-	priv->comments = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->developer_names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->descriptions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->languages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-	priv->metadata = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->urls = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	/* the keys and the categories, architectures, mimetypes and desktops
+	 * are drawn from a small set of values, so are interned */
+	priv->comments = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	priv->developer_names = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	priv->descriptions = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	priv->languages = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
+	priv->metadata = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	priv->names = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	priv->urls = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
 }
 
 /**
@@ -254,6 +412,23 @@ as_app_get_categories (AsApp *app)
 	return priv->categories;
 }
 
+/**
+ * as_app_get_mimetypes:
+ * @app: a #AsApp instance.
+ *
+ * Get the mimetypes the application can process.
+ *
+ * Returns: (element-type utf8) (transfer none): an array
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_app_get_mimetypes (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	return priv->mimetypes;
+}
+
 /**
  * as_app_has_category:
  * @app: a #AsApp instance.
@@ -329,6 +504,7 @@ GPtrArray *
 as_app_get_releases (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	return priv->releases;
 }
 
@@ -346,6 +522,7 @@ GPtrArray *
 as_app_get_provides (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	return priv->provides;
 }
 
@@ -363,6 +540,7 @@ GPtrArray *
 as_app_get_screenshots (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	return priv->screenshots;
 }
 
@@ -370,7 +548,8 @@ as_app_get_screenshots (AsApp *app)
  * as_app_get_names:
  * @app: a #AsApp instance.
  *
- * Gets the names set for the application.
+ * Gets the names set for the application. The hash table must not be
+ * modified directly; use as_app_set_name() instead.
  *
  * Returns: (transfer none): hash table of names
  *
@@ -387,7 +566,8 @@ as_app_get_names (AsApp *app)
  * as_app_get_comments:
  * @app: a #AsApp instance.
  *
- * Gets the comments set for the application.
+ * Gets the comments set for the application. The hash table must not be
+ * modified directly; use as_app_set_comment() instead.
  *
  * Returns: (transfer none): hash table of comments
  *
@@ -438,7 +618,8 @@ as_app_get_metadata (AsApp *app)
  * as_app_get_descriptions:
  * @app: a #AsApp instance.
  *
- * Gets the descriptions set for the application.
+ * Gets the descriptions set for the application. The hash table must not be
+ * modified directly; use as_app_set_description() instead.
  *
  * Returns: (transfer none): hash table of descriptions
  *
@@ -448,6 +629,7 @@ GHashTable *
 as_app_get_descriptions (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	return priv->descriptions;
 }
 
@@ -602,6 +784,7 @@ guint
 as_app_get_description_size (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	return g_hash_table_size (priv->descriptions);
 }
 
@@ -622,6 +805,23 @@ as_app_get_source_kind (AsApp *app)
 	return priv->source_kind;
 }
 
+/**
+ * as_app_get_source_file:
+ * @app: a #AsApp instance.
+ *
+ * Gets the file the AsApp was loaded from.
+ *
+ * Returns: full filename, or %NULL if unset
+ *
+ * Since: 0.1.8
+ **/
+const gchar *
+as_app_get_source_file (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	return priv->source_file;
+}
+
 /**
  * as_app_get_problems: (skip)
  * @app: a #AsApp instance.
@@ -706,7 +906,8 @@ const gchar *
 as_app_get_name (AsApp *app, const gchar *locale)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	return as_hash_lookup_by_locale (priv->names, locale);
+	return as_app_lookup_localized (app, priv->names,
+					AS_APP_LOCALIZED_NAME, locale);
 }
 
 /**
@@ -724,7 +925,8 @@ const gchar *
 as_app_get_comment (AsApp *app, const gchar *locale)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	return as_hash_lookup_by_locale (priv->comments, locale);
+	return as_app_lookup_localized (app, priv->comments,
+					AS_APP_LOCALIZED_COMMENT, locale);
 }
 
 /**
@@ -760,7 +962,9 @@ const gchar *
 as_app_get_description (AsApp *app, const gchar *locale)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
-	return as_hash_lookup_by_locale (priv->descriptions, locale);
+	as_app_ensure_lazy (app);
+	return as_app_lookup_localized (app, priv->descriptions,
+					AS_APP_LOCALIZED_DESCRIPTION, locale);
 }
 
 /**
@@ -781,6 +985,7 @@ as_app_get_language (AsApp *app, const gchar *locale)
 	gboolean ret;
 	gpointer value = NULL;
 
+	as_app_ensure_lazy (app);
 	if (locale == NULL)
 		locale = "C";
 	ret = g_hash_table_lookup_extended (priv->languages,
@@ -821,6 +1026,7 @@ GList *
 as_app_get_languages (AsApp *app)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	return g_hash_table_get_keys (priv->languages);
 }
 
@@ -956,6 +1162,7 @@ as_app_set_id_full (AsApp *app, const gchar *id_full, gssize id_full_len)
 	tmp = g_strrstr_len (priv->id, -1, ".");
 	if (tmp != NULL)
 		*tmp = '\0';
+	as_app_changed (app);
 }
 
 /**
@@ -974,6 +1181,23 @@ as_app_set_source_kind (AsApp *app, AsAppSourceKind source_kind)
 	priv->source_kind = source_kind;
 }
 
+/**
+ * as_app_set_source_file:
+ * @app: a #AsApp instance.
+ * @source_file: a full filename, or %NULL
+ *
+ * Sets the file the AsApp was loaded from.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_app_set_source_file (AsApp *app, const gchar *source_file)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	g_free (priv->source_file);
+	priv->source_file = g_strdup (source_file);
+}
+
 /**
  * as_app_set_id_kind:
  * @app: a #AsApp instance.
@@ -1008,6 +1232,7 @@ as_app_set_project_group (AsApp *app,
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	g_free (priv->project_group);
 	priv->project_group = as_strndup (project_group, project_group_len);
+	as_app_changed (app);
 }
 
 /**
@@ -1218,8 +1443,9 @@ as_app_set_name (AsApp *app,
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->names,
-			     g_strdup (locale),
+			     (gpointer) as_intern (locale, -1),
 			     as_strndup (name, name_len));
+	as_app_changed (app);
 }
 
 /**
@@ -1244,8 +1470,9 @@ as_app_set_comment (AsApp *app,
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->comments,
-			     g_strdup (locale),
+			     (gpointer) as_intern (locale, -1),
 			     as_strndup (comment, comment_len));
+	as_app_localized_changed (app);
 }
 
 /**
@@ -1270,7 +1497,7 @@ as_app_set_developer_name (AsApp *app,
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->developer_names,
-			     g_strdup (locale),
+			     (gpointer) as_intern (locale, -1),
 			     as_strndup (developer_name, developer_name_len));
 }
 
@@ -1293,11 +1520,13 @@ as_app_set_description (AsApp *app,
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	g_return_if_fail (description != NULL);
+	as_app_ensure_lazy (app);
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->descriptions,
-			     g_strdup (locale),
+			     (gpointer) as_intern (locale, -1),
 			     as_strndup (description, description_len));
+	as_app_localized_changed (app);
 }
 
 /**
@@ -1315,6 +1544,7 @@ as_app_set_priority (AsApp *app, gint priority)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	priv->priority = priority;
+	as_app_changed (app);
 }
 
 /**
@@ -1355,7 +1585,8 @@ as_app_add_category (AsApp *app, const gchar *category, gssize category_len)
 
 	if (as_app_array_find_string (priv->categories, category))
 		return;
-	g_ptr_array_add (priv->categories, as_strndup (category, category_len));
+	g_ptr_array_add (priv->categories, (gpointer) as_intern (category, category_len));
+	as_app_changed (app);
 }
 
 
@@ -1379,8 +1610,8 @@ as_app_add_compulsory_for_desktop (AsApp *app,
 				      compulsory_for_desktop))
 		return;
 	g_ptr_array_add (priv->compulsory_for_desktops,
-			 as_strndup (compulsory_for_desktop,
-				     compulsory_for_desktop_len));
+			 (gpointer) as_intern (compulsory_for_desktop,
+					       compulsory_for_desktop_len));
 }
 
 /**
@@ -1418,7 +1649,8 @@ as_app_add_mimetype (AsApp *app, const gchar *mimetype, gssize mimetype_len)
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	if (as_app_array_find_string (priv->mimetypes, mimetype))
 		return;
-	g_ptr_array_add (priv->mimetypes, as_strndup (mimetype, mimetype_len));
+	g_ptr_array_add (priv->mimetypes, (gpointer) as_intern (mimetype, mimetype_len));
+	as_app_changed (app);
 }
 
 /**
@@ -1434,6 +1666,7 @@ void
 as_app_add_release (AsApp *app, AsRelease *release)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	g_ptr_array_add (priv->releases, g_object_ref (release));
 }
 
@@ -1450,7 +1683,9 @@ void
 as_app_add_provide (AsApp *app, AsProvide *provide)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	g_ptr_array_add (priv->provides, g_object_ref (provide));
+	as_app_changed (app);
 }
 
 /**
@@ -1466,6 +1701,7 @@ void
 as_app_add_screenshot (AsApp *app, AsScreenshot *screenshot)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	g_ptr_array_add (priv->screenshots, g_object_ref (screenshot));
 }
 
@@ -1504,7 +1740,7 @@ as_app_add_arch (AsApp *app, const gchar *arch, gssize arch_len)
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	if (as_app_array_find_string (priv->architectures, arch))
 		return;
-	g_ptr_array_add (priv->architectures, as_strndup (arch, arch_len));
+	g_ptr_array_add (priv->architectures, (gpointer) as_intern (arch, arch_len));
 }
 
 /**
@@ -1525,10 +1761,11 @@ as_app_add_language (AsApp *app,
 		     gssize locale_len)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
+	as_app_ensure_lazy (app);
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->languages,
-			     as_strndup (locale, locale_len),
+			     (gpointer) as_intern (locale, locale_len),
 			     GINT_TO_POINTER (percentage));
 }
 
@@ -1551,7 +1788,7 @@ as_app_add_url (AsApp *app,
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	g_hash_table_insert (priv->urls,
-			     g_strdup (as_url_kind_to_string (url_kind)),
+			     (gpointer) as_intern (as_url_kind_to_string (url_kind), -1),
 			     as_strndup (url, url_len));
 }
 
@@ -1577,8 +1814,9 @@ as_app_add_metadata (AsApp *app,
 	if (value == NULL)
 		value = "";
 	g_hash_table_insert (priv->metadata,
-			     g_strdup (key),
+			     (gpointer) as_intern (key, -1),
 			     as_strndup (value, value_len));
+	as_app_changed (app);
 }
 
 /**
@@ -1595,6 +1833,7 @@ as_app_remove_metadata (AsApp *app, const gchar *key)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	g_hash_table_remove (priv->metadata, key);
+	as_app_changed (app);
 }
 
 /**
@@ -1654,7 +1893,7 @@ as_app_subsume_dict (GHashTable *dest, GHashTable *src, gboolean overwrite)
 				continue;
 		}
 		value = g_hash_table_lookup (src, key);
-		g_hash_table_insert (dest, g_strdup (key), g_strdup (value));
+		g_hash_table_insert (dest, (gpointer) as_intern (key, -1), g_strdup (value));
 	}
 }
 
@@ -1676,6 +1915,8 @@ as_app_subsume_private (AsApp *app, AsApp *donor, AsAppSubsumeFlags flags)
 	_cleanup_list_free_ GList *keys;
 
 	overwrite = (flags & AS_APP_SUBSUME_FLAG_NO_OVERWRITE) == 0;
+	as_app_ensure_lazy (app);
+	as_app_ensure_lazy (donor);
 
 	/* pkgnames */
 	for (i = 0; i < priv->pkgnames->len; i++) {
@@ -1709,6 +1950,7 @@ as_app_subsume_private (AsApp *app, AsApp *donor, AsAppSubsumeFlags flags)
 	}
 
 	/* dictionaries */
+	as_app_changed (app);
 	as_app_subsume_dict (papp->names, priv->names, overwrite);
 	as_app_subsume_dict (papp->comments, priv->comments, overwrite);
 	as_app_subsume_dict (papp->developer_names, priv->developer_names, overwrite);
@@ -1829,6 +2071,8 @@ as_app_node_insert (AsApp *app, GNode *parent, gdouble api_version)
 	const gchar *tmp;
 	guint i;
 
+	as_app_ensure_lazy (app);
+
 	/* <component> or <application> */
 	if (api_version >= 0.6) {
 		node_app = as_node_insert (parent, "component", NULL, 0, NULL);
@@ -2040,6 +2284,9 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 	const gchar *tmp;
 	gchar *taken;
 
+	/* any of the indexed values may be replaced */
+	as_app_changed (app);
+
 	switch (as_node_get_tag (n)) {
 
 	/* <id> */
@@ -2063,31 +2310,31 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 
 	/* <name> */
 	case AS_TAG_NAME:
-		taken = as_node_take_attribute (n, "xml:lang");
-		if (taken == NULL)
-			taken = g_strdup ("C");
+		tmp = as_node_get_attribute (n, "xml:lang");
+		if (tmp == NULL)
+			tmp = "C";
 		g_hash_table_insert (priv->names,
-				     taken,
+				     (gpointer) as_intern (tmp, -1),
 				     as_node_take_data (n));
 		break;
 
 	/* <summary> */
 	case AS_TAG_SUMMARY:
-		taken = as_node_take_attribute (n, "xml:lang");
-		if (taken == NULL)
-			taken = g_strdup ("C");
+		tmp = as_node_get_attribute (n, "xml:lang");
+		if (tmp == NULL)
+			tmp = "C";
 		g_hash_table_insert (priv->comments,
-				     taken,
+				     (gpointer) as_intern (tmp, -1),
 				     as_node_take_data (n));
 		break;
 
 	/* <developer_name> */
 	case AS_TAG_DEVELOPER_NAME:
-		taken = as_node_take_attribute (n, "xml:lang");
-		if (taken == NULL)
-			taken = g_strdup ("C");
+		tmp = as_node_get_attribute (n, "xml:lang");
+		if (tmp == NULL)
+			tmp = "C";
 		g_hash_table_insert (priv->developer_names,
-				     taken,
+				     (gpointer) as_intern (tmp, -1),
 				     as_node_take_data (n));
 		break;
 
@@ -2134,7 +2381,8 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_CATEGORY)
 				continue;
-			g_ptr_array_add (priv->categories, as_node_take_data (c));
+			g_ptr_array_add (priv->categories,
+					 (gpointer) as_intern (as_node_get_data (c), -1));
 		}
 		break;
 
@@ -2144,7 +2392,8 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_ARCH)
 				continue;
-			g_ptr_array_add (priv->architectures, as_node_take_data (c));
+			g_ptr_array_add (priv->architectures,
+					 (gpointer) as_intern (as_node_get_data (c), -1));
 		}
 		break;
 
@@ -2164,7 +2413,8 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 		for (c = n->children; c != NULL; c = c->next) {
 			if (as_node_get_tag (c) != AS_TAG_MIMETYPE)
 				continue;
-			g_ptr_array_add (priv->mimetypes, as_node_take_data (c));
+			g_ptr_array_add (priv->mimetypes,
+					 (gpointer) as_intern (as_node_get_data (c), -1));
 		}
 		break;
 
@@ -2201,7 +2451,7 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 	/* <compulsory_for_desktop> */
 	case AS_TAG_COMPULSORY_FOR_DESKTOP:
 		g_ptr_array_add (priv->compulsory_for_desktops,
-				 as_node_take_data (n));
+				 (gpointer) as_intern (as_node_get_data (n), -1));
 		break;
 
 	/* <extends> */
@@ -2268,15 +2518,16 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 	case AS_TAG_METADATA:
 		g_hash_table_remove_all (priv->metadata);
 		for (c = n->children; c != NULL; c = c->next) {
-			gchar *key;
 			if (as_node_get_tag (c) != AS_TAG_VALUE)
 				continue;
-			key = as_node_take_attribute (c, "key");
+			tmp = as_node_get_attribute (c, "key");
+			if (tmp == NULL)
+				continue;
 			taken = as_node_take_data (c);
 			if (taken == NULL)
 				taken = g_strdup ("");
 			g_hash_table_insert (priv->metadata,
-					     key,
+					     (gpointer) as_intern (tmp, -1),
 					     taken);
 		}
 		break;
@@ -2287,26 +2538,43 @@ as_app_node_parse_child (AsApp *app, GNode *n, GError **error)
 }
 
 /**
- * as_app_node_parse:
- * @app: a #AsApp instance.
- * @node: a #GNode.
- * @error: A #GError or %NULL.
+ * as_app_node_is_lazy:
  *
- * Populates the object from a DOM node.
- *
- * Returns: %TRUE for success
- *
- * Since: 0.1.0
+ * Returns %TRUE for the elements that are expensive to parse and are
+ * typically only needed when showing the details of one application.
  **/
-gboolean
-as_app_node_parse (AsApp *app, GNode *node, GError **error)
+static gboolean
+as_app_node_is_lazy (GNode *n)
+{
+	switch (as_node_get_tag (n)) {
+	case AS_TAG_DESCRIPTION:
+	case AS_TAG_SCREENSHOTS:
+	case AS_TAG_RELEASES:
+	case AS_TAG_PROVIDES:
+	case AS_TAG_LANGUAGES:
+		return TRUE;
+	default:
+		break;
+	}
+	return FALSE;
+}
+
+/**
+ * as_app_node_parse_full:
+ **/
+static gboolean
+as_app_node_parse_full (AsApp *app, GNode *node, gboolean lazy, GError **error)
 {
 	AsAppPrivate *priv = GET_PRIVATE (app);
 	GNode *n;
+	GNode *next;
 	const gchar *tmp;
 	guint prio;
 
-	/* new style */
+	/* anything deferred from before has to be parsed first */
+	as_app_ensure_lazy (app);
+
+	/* new style, but not the legacy <application> that shares the tag */
 	if (g_strcmp0 (as_node_get_name (node), "component") == 0) {
 		tmp = as_node_get_attribute (node, "type");
 		if (tmp != NULL)
@@ -2321,13 +2589,449 @@ as_app_node_parse (AsApp *app, GNode *node, GError **error)
 	g_ptr_array_set_size (priv->pkgnames, 0);
 	g_ptr_array_set_size (priv->architectures, 0);
 	g_ptr_array_set_size (priv->extends, 0);
-	for (n = node->children; n != NULL; n = n->next) {
+	for (n = node->children; n != NULL; n = next) {
+		next = n->next;
+
+		/* keep the node for later */
+		if (lazy && as_app_node_is_lazy (n)) {
+			if (priv->lazy_node == NULL)
+				priv->lazy_node = as_node_new ();
+			g_node_unlink (n);
+			g_node_append (priv->lazy_node, n);
+			continue;
+		}
 		if (!as_app_node_parse_child (app, n, error))
 			return FALSE;
 	}
+	if (priv->lazy_node != NULL)
+		g_atomic_int_set (&priv->lazy_pending, 1);
+	return TRUE;
+}
+
+/**
+ * as_app_node_parse:
+ * @app: a #AsApp instance.
+ * @node: a #GNode.
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a DOM node.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+as_app_node_parse (AsApp *app, GNode *node, GError **error)
+{
+	return as_app_node_parse_full (app, node, FALSE, error);
+}
+
+/**
+ * as_app_node_parse_lazy: (skip)
+ * @app: a #AsApp instance.
+ * @node: a #GNode.
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a DOM node, but the description, screenshots,
+ * releases, provides and languages are moved out of @node and only parsed
+ * when they are first used.
+ *
+ * The tree containing @node must not have been parsed into an arena.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.8
+ **/
+gboolean
+as_app_node_parse_lazy (AsApp *app, GNode *node, GError **error)
+{
+	return as_app_node_parse_full (app, node, TRUE, error);
+}
+
+/**
+ * as_app_to_variant_hash:
+ **/
+static void
+as_app_to_variant_hash (GVariantBuilder *builder, GHashTable *hash)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sms}"));
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_variant_builder_add (builder, "{sms}", key, value);
+	g_variant_builder_close (builder);
+}
+
+/**
+ * as_app_to_variant_array:
+ **/
+static void
+as_app_to_variant_array (GVariantBuilder *builder, GPtrArray *array)
+{
+	guint i;
+
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("ams"));
+	for (i = 0; i < array->len; i++)
+		g_variant_builder_add (builder, "ms", g_ptr_array_index (array, i));
+	g_variant_builder_close (builder);
+}
+
+/**
+ * as_app_to_variant_languages:
+ **/
+static void
+as_app_to_variant_languages (GVariantBuilder *builder, GHashTable *hash)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("a{si}"));
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_variant_builder_add (builder, "{si}",
+				       key, GPOINTER_TO_INT (value));
+	}
+	g_variant_builder_close (builder);
+}
+
+typedef GVariant	*(*AsAppToVariantFunc)	(gpointer	 obj);
+
+/**
+ * as_app_to_variant_objects:
+ **/
+static void
+as_app_to_variant_objects (GVariantBuilder *builder,
+			   GPtrArray *array,
+			   const gchar *type_string,
+			   AsAppToVariantFunc to_variant)
+{
+	guint i;
+
+	g_variant_builder_open (builder, G_VARIANT_TYPE (type_string));
+	for (i = 0; i < array->len; i++) {
+		g_variant_builder_add_value (builder,
+					     to_variant (g_ptr_array_index (array, i)));
+	}
+	g_variant_builder_close (builder);
+}
+
+/**
+ * as_app_to_variant: (skip)
+ * @app: a #AsApp instance.
+ *
+ * Serializes the application into a #GVariant of type %AS_APP_VARIANT_TYPE
+ * which can be written to disk and loaded again. Everything is stored
+ * natively, including the screenshots, releases, provides and the problems
+ * found when parsing, so no XML has to be parsed when loading.
+ *
+ * Returns: (transfer full): a floating #GVariant
+ *
+ * Since: 0.1.8
+ **/
+GVariant *
+as_app_to_variant (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	GVariantBuilder builder;
+
+	as_app_ensure_lazy (app);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (AS_APP_VARIANT_TYPE));
+	g_variant_builder_add (&builder, "ms", priv->id_full);
+	g_variant_builder_add (&builder, "u", priv->id_kind);
+	g_variant_builder_add (&builder, "i", priv->priority);
+	g_variant_builder_add (&builder, "u", priv->icon_kind);
+	g_variant_builder_add (&builder, "ms", priv->icon);
+	g_variant_builder_add (&builder, "ms", priv->project_group);
+	g_variant_builder_add (&builder, "ms", priv->project_license);
+	g_variant_builder_add (&builder, "ms", priv->metadata_license);
+	g_variant_builder_add (&builder, "ms", priv->update_contact);
+	as_app_to_variant_hash (&builder, priv->names);
+	as_app_to_variant_hash (&builder, priv->comments);
+	as_app_to_variant_hash (&builder, priv->developer_names);
+	as_app_to_variant_hash (&builder, priv->descriptions);
+	as_app_to_variant_hash (&builder, priv->urls);
+	as_app_to_variant_hash (&builder, priv->metadata);
+	as_app_to_variant_array (&builder, priv->pkgnames);
+	as_app_to_variant_array (&builder, priv->categories);
+	as_app_to_variant_array (&builder, priv->architectures);
+	as_app_to_variant_array (&builder, priv->keywords);
+	as_app_to_variant_array (&builder, priv->mimetypes);
+	as_app_to_variant_array (&builder, priv->compulsory_for_desktops);
+	as_app_to_variant_array (&builder, priv->extends);
+	as_app_to_variant_languages (&builder, priv->languages);
+	as_app_to_variant_objects (&builder, priv->screenshots,
+				   "a" AS_SCREENSHOT_VARIANT_TYPE,
+				   (AsAppToVariantFunc) as_screenshot_to_variant);
+	as_app_to_variant_objects (&builder, priv->releases,
+				   "a" AS_RELEASE_VARIANT_TYPE,
+				   (AsAppToVariantFunc) as_release_to_variant);
+	as_app_to_variant_objects (&builder, priv->provides,
+				   "a" AS_PROVIDE_VARIANT_TYPE,
+				   (AsAppToVariantFunc) as_provide_to_variant);
+	g_variant_builder_add (&builder, "u", (guint32) priv->problems);
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * as_app_from_variant_string:
+ **/
+static gchar *
+as_app_from_variant_string (GVariant *value, gsize idx)
+{
+	const gchar *tmp = NULL;
+	g_variant_get_child (value, idx, "m&s", &tmp);
+	return g_strdup (tmp);
+}
+
+/**
+ * as_app_from_variant_hash:
+ **/
+static void
+as_app_from_variant_hash (GHashTable *hash, GVariant *value, gsize idx)
+{
+	GVariantIter iter;
+	const gchar *key;
+	const gchar *tmp;
+	_cleanup_variant_unref_ GVariant *child = NULL;
+
+	child = g_variant_get_child_value (value, idx);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "{&sm&s}", &key, &tmp))
+		g_hash_table_insert (hash, (gpointer) as_intern (key, -1), g_strdup (tmp));
+}
+
+/**
+ * as_app_from_variant_array:
+ **/
+static void
+as_app_from_variant_array (GPtrArray *array, GVariant *value, gsize idx,
+			   gboolean intern)
+{
+	GVariantIter iter;
+	const gchar *tmp;
+	_cleanup_variant_unref_ GVariant *child = NULL;
+
+	child = g_variant_get_child_value (value, idx);
+	g_variant_iter_init (&iter, child);
+	while (g_variant_iter_next (&iter, "m&s", &tmp)) {
+		if (intern)
+			g_ptr_array_add (array, (gpointer) as_intern (tmp, -1));
+		else
+			g_ptr_array_add (array, g_strdup (tmp));
+	}
+}
+
+/**
+ * as_app_from_variant_heavy:
+ *
+ * Loads the parts of the variant that are deferred in lazy mode.
+ **/
+static void
+as_app_from_variant_heavy (AsApp *app, GVariant *value)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	GVariantIter iter;
+	GVariant *child;
+	const gchar *key;
+	gint percentage;
+	_cleanup_variant_unref_ GVariant *languages = NULL;
+	_cleanup_variant_unref_ GVariant *provides = NULL;
+	_cleanup_variant_unref_ GVariant *releases = NULL;
+	_cleanup_variant_unref_ GVariant *screenshots = NULL;
+
+	/* descriptions */
+	as_app_from_variant_hash (priv->descriptions, value, 12);
+	as_app_localized_changed (app);
+
+	/* languages */
+	languages = g_variant_get_child_value (value, 22);
+	g_variant_iter_init (&iter, languages);
+	while (g_variant_iter_next (&iter, "{&si}", &key, &percentage)) {
+		g_hash_table_insert (priv->languages,
+				     (gpointer) as_intern (key, -1),
+				     GINT_TO_POINTER (percentage));
+	}
+
+	/* screenshots */
+	g_ptr_array_set_size (priv->screenshots, 0);
+	screenshots = g_variant_get_child_value (value, 23);
+	g_variant_iter_init (&iter, screenshots);
+	while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+		AsScreenshot *ss;
+		ss = as_screenshot_new ();
+		as_screenshot_from_variant (ss, child);
+		g_ptr_array_add (priv->screenshots, ss);
+		g_variant_unref (child);
+	}
+
+	/* releases */
+	g_ptr_array_set_size (priv->releases, 0);
+	releases = g_variant_get_child_value (value, 24);
+	g_variant_iter_init (&iter, releases);
+	while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+		AsRelease *r;
+		r = as_release_new ();
+		as_release_from_variant (r, child);
+		g_ptr_array_add (priv->releases, r);
+		g_variant_unref (child);
+	}
+
+	/* provides */
+	g_ptr_array_set_size (priv->provides, 0);
+	provides = g_variant_get_child_value (value, 25);
+	g_variant_iter_init (&iter, provides);
+	while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+		AsProvide *p;
+		p = as_provide_new ();
+		as_provide_from_variant (p, child);
+		g_ptr_array_add (priv->provides, p);
+		g_variant_unref (child);
+	}
+}
+
+/**
+ * as_app_from_variant_full:
+ **/
+static gboolean
+as_app_from_variant_full (AsApp *app,
+			  GVariant *value,
+			  gboolean lazy,
+			  GError **error)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	guint32 problems = 0;
+	_cleanup_free_ gchar *id_full = NULL;
+
+	if (!g_variant_is_of_type (value, G_VARIANT_TYPE (AS_APP_VARIANT_TYPE))) {
+		g_set_error (error,
+			     AS_APP_ERROR,
+			     AS_APP_ERROR_FAILED,
+			     "Invalid variant type %s",
+			     g_variant_get_type_string (value));
+		return FALSE;
+	}
+
+	/* anything deferred from before has to be loaded first */
+	as_app_ensure_lazy (app);
+
+	/* scalars */
+	id_full = as_app_from_variant_string (value, 0);
+	if (id_full != NULL)
+		as_app_set_id_full (app, id_full, -1);
+	g_variant_get_child (value, 1, "u", &priv->id_kind);
+	g_variant_get_child (value, 2, "i", &priv->priority);
+	g_variant_get_child (value, 3, "u", &priv->icon_kind);
+	g_free (priv->icon);
+	priv->icon = as_app_from_variant_string (value, 4);
+	g_free (priv->project_group);
+	priv->project_group = as_app_from_variant_string (value, 5);
+	g_free (priv->project_license);
+	priv->project_license = as_app_from_variant_string (value, 6);
+	g_free (priv->metadata_license);
+	priv->metadata_license = as_app_from_variant_string (value, 7);
+	g_free (priv->update_contact);
+	priv->update_contact = as_app_from_variant_string (value, 8);
+	g_variant_get_child (value, 26, "u", &problems);
+	priv->problems = problems;
+
+	/* dictionaries */
+	as_app_changed (app);
+	as_app_from_variant_hash (priv->names, value, 9);
+	as_app_from_variant_hash (priv->comments, value, 10);
+	as_app_from_variant_hash (priv->developer_names, value, 11);
+	as_app_from_variant_hash (priv->urls, value, 13);
+	as_app_from_variant_hash (priv->metadata, value, 14);
+
+	/* arrays */
+	as_app_from_variant_array (priv->pkgnames, value, 15, FALSE);
+	as_app_from_variant_array (priv->categories, value, 16, TRUE);
+	as_app_from_variant_array (priv->architectures, value, 17, TRUE);
+	as_app_from_variant_array (priv->keywords, value, 18, FALSE);
+	as_app_from_variant_array (priv->mimetypes, value, 19, TRUE);
+	as_app_from_variant_array (priv->compulsory_for_desktops, value, 20, TRUE);
+	as_app_from_variant_array (priv->extends, value, 21, FALSE);
+
+	/* keep a reference to the data rather than copying it */
+	if (lazy) {
+		priv->lazy_variant = g_variant_ref (value);
+		g_atomic_int_set (&priv->lazy_pending, 1);
+		return TRUE;
+	}
+	as_app_from_variant_heavy (app, value);
 	return TRUE;
 }
 
+/**
+ * as_app_from_variant: (skip)
+ * @app: a #AsApp instance.
+ * @value: a #GVariant of type %AS_APP_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a #GVariant created by as_app_to_variant().
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.8
+ **/
+gboolean
+as_app_from_variant (AsApp *app, GVariant *value, GError **error)
+{
+	return as_app_from_variant_full (app, value, FALSE, error);
+}
+
+/**
+ * as_app_from_variant_lazy: (skip)
+ * @app: a #AsApp instance.
+ * @value: a #GVariant of type %AS_APP_VARIANT_TYPE
+ * @error: A #GError or %NULL.
+ *
+ * Populates the object from a #GVariant created by as_app_to_variant(),
+ * but keeps a reference to @value and only loads the description,
+ * screenshots, releases, provides and languages when they are first used.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.8
+ **/
+gboolean
+as_app_from_variant_lazy (AsApp *app, GVariant *value, GError **error)
+{
+	return as_app_from_variant_full (app, value, TRUE, error);
+}
+
+/**
+ * as_app_lazy_load:
+ **/
+static void
+as_app_lazy_load (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+	GNode *n;
+
+	if (priv->lazy_node != NULL) {
+		for (n = priv->lazy_node->children; n != NULL; n = n->next) {
+			_cleanup_error_free_ GError *error = NULL;
+			if (!as_app_node_parse_child (app, n, &error)) {
+				g_warning ("failed to parse %s: %s",
+					   priv->id_full, error->message);
+				break;
+			}
+		}
+		as_node_unref (priv->lazy_node);
+		priv->lazy_node = NULL;
+	}
+	if (priv->lazy_variant != NULL) {
+		as_app_from_variant_heavy (app, priv->lazy_variant);
+		g_variant_unref (priv->lazy_variant);
+		priv->lazy_variant = NULL;
+	}
+}
+
 #if !GLIB_CHECK_VERSION(2,39,1)
 /**
  * as_app_value_tokenize:
@@ -2419,6 +3123,31 @@ as_app_create_token_cache (AsApp *app)
 	}
 }
 
+/**
+ * as_app_get_search_tokens: (skip)
+ * @app: a #AsApp instance.
+ *
+ * Gets the tokens used when searching the application, creating them if
+ * required. The tokens are created only once, and the order of the array
+ * is the order in which as_app_search_matches() checks them.
+ *
+ * Returns: (transfer none): an array of AsAppTokenItem
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_app_get_search_tokens (AsApp *app)
+{
+	AsAppPrivate *priv = GET_PRIVATE (app);
+
+	/* ensure the token cache is created */
+	if (g_once_init_enter (&priv->token_cache_valid)) {
+		as_app_create_token_cache (app);
+		g_once_init_leave (&priv->token_cache_valid, TRUE);
+	}
+	return priv->token_cache;
+}
+
 /**
  * as_app_search_matches:
  * @app: a #AsApp instance.
@@ -2433,23 +3162,18 @@ as_app_create_token_cache (AsApp *app)
 guint
 as_app_search_matches (AsApp *app, const gchar *search)
 {
-	AsAppPrivate *priv = GET_PRIVATE (app);
 	AsAppTokenItem *item;
+	GPtrArray *tokens;
 	guint i, j;
 
 	/* nothing to do */
 	if (search == NULL)
 		return 0;
 
-	/* ensure the token cache is created */
-	if (g_once_init_enter (&priv->token_cache_valid)) {
-		as_app_create_token_cache (app);
-		g_once_init_leave (&priv->token_cache_valid, TRUE);
-	}
-
 	/* find the search term */
-	for (i = 0; i < priv->token_cache->len; i++) {
-		item = g_ptr_array_index (priv->token_cache, i);
+	tokens = as_app_get_search_tokens (app);
+	for (i = 0; i < tokens->len; i++) {
+		item = g_ptr_array_index (tokens, i);
 
 		/* prefer UTF-8 matches */
 		if (item->values_utf8 != NULL) {
@@ -2499,6 +3223,52 @@ as_app_search_matches_all (AsApp *app, gchar **search)
 	return matches_sum;
 }
 
+/**
+ * as_app_resolve_display_info:
+ * @apps: (element-type AsApp): an array of #AsApp instances.
+ * @locale: the locale, or %NULL to use the users default locale.
+ *
+ * Gets the name, summary and icon of each application, which is typically
+ * what is needed to show a list of search results.
+ *
+ * The users locales are only looked up once for all the applications, and
+ * nothing is stored on the applications so this can be used from any thread
+ * that is not also changing them.
+ *
+ * Returns: (transfer full) (element-type AsAppDisplayInfo): the details
+ * of each application in the same order as @apps
+ *
+ * Since: 0.1.8
+ **/
+GArray *
+as_app_resolve_display_info (GPtrArray *apps, const gchar *locale)
+{
+	AsApp *app;
+	AsAppDisplayInfo *info;
+	AsAppPrivate *priv;
+	GArray *array;
+	const gchar * const *locales;
+	const gchar *locales_one[] = { locale, NULL };
+	guint i;
+
+	array = g_array_sized_new (FALSE, TRUE, sizeof (AsAppDisplayInfo), apps->len);
+	g_array_set_size (array, apps->len);
+	if (locale != NULL)
+		locales = locales_one;
+	else
+		locales = g_get_language_names ();
+	for (i = 0; i < apps->len; i++) {
+		app = g_ptr_array_index (apps, i);
+		priv = GET_PRIVATE (app);
+		info = &g_array_index (array, AsAppDisplayInfo, i);
+		info->app = app;
+		info->icon = priv->icon;
+		info->name = as_hash_lookup_by_locales (priv->names, locales);
+		info->comment = as_hash_lookup_by_locales (priv->comments, locales);
+	}
+	return array;
+}
+
 /**
  * as_app_desktop_key_get_locale:
  */
@@ -2908,7 +3678,7 @@ as_app_parse_appdata_file (AsApp *app,
 
 	node = as_node_find (root, "application");
 	if (node == NULL)
-		node = as_node_find (root, "component");
+		node = as_node_find_tag (root, AS_TAG_APPLICATION);
 	if (node == NULL) {
 		g_set_error (error,
 			     AS_APP_ERROR,
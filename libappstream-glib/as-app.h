@@ -118,6 +118,8 @@ typedef enum {
  * @AS_APP_VALIDATE_FLAG_RELAX:			Relax the checks
  * @AS_APP_VALIDATE_FLAG_STRICT:		Make the checks more strict
  * @AS_APP_VALIDATE_FLAG_NO_NETWORK:		Do not use the network
+ * @AS_APP_VALIDATE_FLAG_PARALLEL:		Check all the screenshot URLs at the same time
+ * @AS_APP_VALIDATE_FLAG_USE_CACHE:		Use and update a cache of screenshot URL results
  *
  * The flags to use when validating.
  **/
@@ -126,10 +128,29 @@ typedef enum {
 	AS_APP_VALIDATE_FLAG_RELAX		= 1,	/* Since: 0.1.4 */
 	AS_APP_VALIDATE_FLAG_STRICT		= 2,	/* Since: 0.1.4 */
 	AS_APP_VALIDATE_FLAG_NO_NETWORK		= 4,	/* Since: 0.1.4 */
+	AS_APP_VALIDATE_FLAG_PARALLEL		= 8,	/* Since: 0.1.8 */
+	AS_APP_VALIDATE_FLAG_USE_CACHE		= 16,	/* Since: 0.1.8 */
 	/*< private >*/
 	AS_APP_VALIDATE_FLAG_LAST
 } AsAppValidateFlags;
 
+/**
+ * AsAppDisplayInfo:
+ * @app:		the #AsApp, which is not referenced
+ * @name:		the localized name, or %NULL
+ * @comment:		the localized summary, or %NULL
+ * @icon:		the icon name, or %NULL
+ *
+ * The details needed to show an application in a list. The strings are
+ * owned by @app and are only valid until it is next modified.
+ **/
+typedef struct {
+	AsApp			*app;
+	const gchar		*name;
+	const gchar		*comment;
+	const gchar		*icon;
+} AsAppDisplayInfo;
+
 /**
  * AsAppSourceKind:
  * @AS_APP_SOURCE_KIND_UNKNOWN:			Not sourced from a file
@@ -165,6 +186,7 @@ GPtrArray	*as_app_get_categories		(AsApp		*app);
 GPtrArray	*as_app_get_compulsory_for_desktops (AsApp	*app);
 GPtrArray	*as_app_get_extends		(AsApp		*app);
 GPtrArray	*as_app_get_keywords		(AsApp		*app);
+GPtrArray	*as_app_get_mimetypes		(AsApp		*app);
 GPtrArray	*as_app_get_pkgnames		(AsApp		*app);
 GPtrArray	*as_app_get_architectures	(AsApp		*app);
 GPtrArray	*as_app_get_releases		(AsApp		*app);
@@ -178,6 +200,7 @@ GHashTable	*as_app_get_descriptions	(AsApp		*app);
 GHashTable	*as_app_get_urls		(AsApp		*app);
 const gchar	*as_app_get_icon		(AsApp		*app);
 const gchar	*as_app_get_icon_path		(AsApp		*app);
+const gchar	*as_app_get_source_file		(AsApp		*app);
 const gchar	*as_app_get_id			(AsApp		*app);
 const gchar	*as_app_get_id_full		(AsApp		*app);
 const gchar	*as_app_get_project_group	(AsApp		*app);
@@ -210,6 +233,8 @@ void		 as_app_set_id_kind		(AsApp		*app,
 						 AsIdKind	 id_kind);
 void		 as_app_set_source_kind		(AsApp		*app,
 						 AsAppSourceKind source_kind);
+void		 as_app_set_source_file		(AsApp		*app,
+						 const gchar	*source_file);
 void		 as_app_set_project_group	(AsApp		*app,
 						 const gchar	*project_group,
 						 gssize		 project_group_len);
@@ -296,6 +321,10 @@ void		 as_app_add_extends		(AsApp		*app,
 GPtrArray	*as_app_validate		(AsApp		*app,
 						 AsAppValidateFlags flags,
 						 GError		**error);
+GPtrArray	*as_app_validate_batch		(GPtrArray	*apps,
+						 AsAppValidateFlags flags,
+						 GPtrArray	**errors,
+						 GError		**error);
 void		 as_app_subsume			(AsApp		*app,
 						 AsApp		*donor);
 void		 as_app_subsume_full		(AsApp		*app,
@@ -305,6 +334,8 @@ guint		 as_app_search_matches_all	(AsApp		*app,
 						 gchar		**search);
 guint		 as_app_search_matches		(AsApp		*app,
 						 const gchar	*search);
+GArray		*as_app_resolve_display_info	(GPtrArray	*apps,
+						 const gchar	*locale);
 gboolean	 as_app_parse_file		(AsApp		*app,
 						 const gchar	*filename,
 						 AsAppParseFlags flags,
@@ -0,0 +1,520 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "as-app.h"
+#include "as-cleanup.h"
+#include "as-image.h"
+#include "as-node.h"
+#include "as-release.h"
+#include "as-screenshot.h"
+#include "as-store.h"
+
+/* count every allocation made by the process, including those made by
+ * GLib, by wrapping the C library allocator */
+static volatile gint as_benchmark_allocs = 0;
+
+#ifdef __GLIBC__
+extern void	*__libc_malloc	(size_t size);
+extern void	*__libc_calloc	(size_t nmemb, size_t size);
+extern void	*__libc_realloc	(void *ptr, size_t size);
+extern void	*__libc_memalign (size_t alignment, size_t size);
+extern void	*__libc_valloc	(size_t size);
+extern void	 __libc_free	(void *ptr);
+
+/* not declared by every C library header in -std=gnu99 */
+void	*memalign	(size_t alignment, size_t size);
+void	*aligned_alloc	(size_t alignment, size_t size);
+
+void *
+malloc (size_t size)
+{
+	g_atomic_int_inc (&as_benchmark_allocs);
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	g_atomic_int_inc (&as_benchmark_allocs);
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	g_atomic_int_inc (&as_benchmark_allocs);
+	return __libc_realloc (ptr, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+	g_atomic_int_inc (&as_benchmark_allocs);
+	return __libc_memalign (alignment, size);
+}
+
+void *
+aligned_alloc (size_t alignment, size_t size)
+{
+	g_atomic_int_inc (&as_benchmark_allocs);
+	return __libc_memalign (alignment, size);
+}
+
+int
+posix_memalign (void **memptr, size_t alignment, size_t size)
+{
+	void *ptr;
+
+	/* the same checks as the C library makes */
+	if (alignment % sizeof (void *) != 0 ||
+	    (alignment & (alignment - 1)) != 0 ||
+	    alignment == 0)
+		return EINVAL;
+	g_atomic_int_inc (&as_benchmark_allocs);
+	ptr = __libc_memalign (alignment, size);
+	if (ptr == NULL)
+		return ENOMEM;
+	*memptr = ptr;
+	return 0;
+}
+
+void *
+valloc (size_t size)
+{
+	g_atomic_int_inc (&as_benchmark_allocs);
+	return __libc_valloc (size);
+}
+
+void
+free (void *ptr)
+{
+	__libc_free (ptr);
+}
+#endif
+
+typedef struct {
+	AsStore		*store;
+	GFile		*file;
+	GPtrArray	*apps;
+	gchar		*filename;
+	gchar		**search;
+	gchar		**search_fuzzy;
+} AsBenchmarkContext;
+
+typedef void (*AsBenchmarkFunc)	(AsBenchmarkContext	*ctx);
+
+typedef struct {
+	const gchar	*name;
+	AsBenchmarkFunc	 func;
+	guint		 max_size;	/* 0 for no limit */
+} AsBenchmarkItem;
+
+static const gchar *as_benchmark_words[] = {
+	"audio", "video", "editor", "image", "photo", "music", "player",
+	"office", "document", "spreadsheet", "browser", "web", "mail",
+	"chat", "game", "puzzle", "terminal", "system", "monitor", "disk",
+	"backup", "network", "font", "archive", "calendar", "notes", "map",
+	"weather", "camera", "scanner", "printer", "graphics", "vector",
+	"development", "compiler", "debugger", "science", "education",
+	NULL };
+
+static const gchar *as_benchmark_locales[] = {
+	"de", "en_GB", "es", "fr", "ja", "pl", "pt_BR", "ru", "zh_CN",
+	NULL };
+
+/**
+ * as_benchmark_word:
+ **/
+static const gchar *
+as_benchmark_word (guint idx)
+{
+	return as_benchmark_words[idx % (G_N_ELEMENTS (as_benchmark_words) - 1)];
+}
+
+/**
+ * as_benchmark_create_app:
+ **/
+static AsApp *
+as_benchmark_create_app (guint idx)
+{
+	AsApp *app;
+	guint i;
+	_cleanup_free_ gchar *description = NULL;
+	_cleanup_free_ gchar *id = NULL;
+	_cleanup_free_ gchar *name = NULL;
+	_cleanup_free_ gchar *pkgname = NULL;
+	_cleanup_free_ gchar *summary = NULL;
+	_cleanup_free_ gchar *url = NULL;
+	_cleanup_free_ gchar *version = NULL;
+	_cleanup_object_unref_ AsImage *im = NULL;
+	_cleanup_object_unref_ AsRelease *rel = NULL;
+	_cleanup_object_unref_ AsScreenshot *ss = NULL;
+
+	app = as_app_new ();
+	id = g_strdup_printf ("org.example.App%05u.desktop", idx);
+	as_app_set_id_full (app, id, -1);
+	as_app_set_id_kind (app, AS_ID_KIND_DESKTOP);
+	name = g_strdup_printf ("%s %s %u",
+				as_benchmark_word (idx),
+				as_benchmark_word (idx / 7),
+				idx);
+	as_app_set_name (app, NULL, name, -1);
+	summary = g_strdup_printf ("A %s application for %s",
+				   as_benchmark_word (idx / 3),
+				   as_benchmark_word (idx / 11));
+	as_app_set_comment (app, NULL, summary, -1);
+	description = g_strdup_printf ("<p>%s is a %s tool that can be used "
+				       "with %s files.</p>",
+				       name,
+				       as_benchmark_word (idx / 5),
+				       as_benchmark_word (idx / 13));
+	as_app_set_description (app, NULL, description, -1);
+	for (i = 0; as_benchmark_locales[i] != NULL; i++) {
+		as_app_set_name (app, as_benchmark_locales[i], name, -1);
+		as_app_set_comment (app, as_benchmark_locales[i], summary, -1);
+		as_app_add_language (app, 50 + (idx + i) % 50,
+				     as_benchmark_locales[i], -1);
+	}
+	as_app_set_project_license (app, "GPL-2.0+", -1);
+	as_app_set_icon (app, "application-x-executable", -1);
+	as_app_set_icon_kind (app, AS_ICON_KIND_STOCK);
+	pkgname = g_strdup_printf ("example-app%05u", idx);
+	as_app_add_pkgname (app, pkgname, -1);
+	as_app_add_category (app, idx % 2 == 0 ? "AudioVideo" : "Office", -1);
+	as_app_add_keyword (app, as_benchmark_word (idx / 17), -1);
+	as_app_add_mimetype (app, "text/plain", -1);
+	url = g_strdup_printf ("http://www.example.org/app%05u", idx);
+	as_app_add_url (app, AS_URL_KIND_HOMEPAGE, url, -1);
+
+	/* one screenshot and one release */
+	im = as_image_new ();
+	as_image_set_kind (im, AS_IMAGE_KIND_SOURCE);
+	as_image_set_url (im, url, -1);
+	ss = as_screenshot_new ();
+	as_screenshot_set_kind (ss, AS_SCREENSHOT_KIND_DEFAULT);
+	as_screenshot_add_image (ss, im);
+	as_app_add_screenshot (app, ss);
+	rel = as_release_new ();
+	version = g_strdup_printf ("1.%u", idx % 100);
+	as_release_set_version (rel, version, -1);
+	as_release_set_timestamp (rel, 1400000000 + idx);
+	as_app_add_release (app, rel);
+	return app;
+}
+
+/**
+ * as_benchmark_node_from_file:
+ **/
+static void
+as_benchmark_node_from_file (AsBenchmarkContext *ctx)
+{
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+
+	root = as_node_from_file (ctx->file,
+				  AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
+				  NULL, &error);
+	if (root == NULL)
+		g_error ("failed to parse: %s", error->message);
+}
+
+/**
+ * as_benchmark_store_from_file:
+ **/
+static void
+as_benchmark_store_from_file (AsBenchmarkContext *ctx)
+{
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+
+	store = as_store_new ();
+	if (!as_store_from_file (store, ctx->file, NULL, NULL, &error))
+		g_error ("failed to load: %s", error->message);
+}
+
+/**
+ * as_benchmark_store_to_xml:
+ **/
+static void
+as_benchmark_store_to_xml (AsBenchmarkContext *ctx)
+{
+	GString *xml;
+	xml = as_store_to_xml (ctx->store, AS_NODE_TO_XML_FLAG_NONE);
+	g_string_free (xml, TRUE);
+}
+
+/**
+ * as_benchmark_store_to_file:
+ **/
+static void
+as_benchmark_store_to_file (AsBenchmarkContext *ctx)
+{
+	_cleanup_error_free_ GError *error = NULL;
+
+	if (!as_store_to_file (ctx->store, ctx->file,
+			       AS_NODE_TO_XML_FLAG_ADD_HEADER,
+			       NULL, &error))
+		g_error ("failed to save: %s", error->message);
+}
+
+/**
+ * as_benchmark_search:
+ **/
+static void
+as_benchmark_search (AsBenchmarkContext *ctx)
+{
+	AsApp *app;
+	guint i;
+
+	for (i = 0; i < ctx->apps->len; i++) {
+		app = g_ptr_array_index (ctx->apps, i);
+		as_app_search_matches_all (app, ctx->search);
+	}
+}
+
+/**
+ * as_benchmark_store_search:
+ **/
+static void
+as_benchmark_store_search (AsBenchmarkContext *ctx)
+{
+	GPtrArray *results;
+	results = as_store_search (ctx->store, ctx->search);
+	g_ptr_array_unref (results);
+}
+
+/**
+ * as_benchmark_store_search_fuzzy:
+ **/
+static void
+as_benchmark_store_search_fuzzy (AsBenchmarkContext *ctx)
+{
+	GPtrArray *results;
+	results = as_store_search_full (ctx->store, ctx->search_fuzzy,
+					AS_STORE_SEARCH_FLAG_FUZZY);
+	g_ptr_array_unref (results);
+}
+
+/**
+ * as_benchmark_subsume:
+ **/
+static void
+as_benchmark_subsume (AsBenchmarkContext *ctx)
+{
+	AsApp *app;
+	guint i;
+
+	for (i = 0; i < ctx->apps->len; i++) {
+		_cleanup_object_unref_ AsApp *dest = as_app_new ();
+		app = g_ptr_array_index (ctx->apps, i);
+		as_app_subsume_full (dest, app, AS_APP_SUBSUME_FLAG_NONE);
+	}
+}
+
+/**
+ * as_benchmark_validate:
+ **/
+static void
+as_benchmark_validate (AsBenchmarkContext *ctx)
+{
+	AsApp *app;
+	guint i;
+
+	for (i = 0; i < ctx->apps->len; i++) {
+		_cleanup_error_free_ GError *error = NULL;
+		_cleanup_ptrarray_unref_ GPtrArray *problems = NULL;
+		app = g_ptr_array_index (ctx->apps, i);
+		problems = as_app_validate (app, AS_APP_VALIDATE_FLAG_NO_NETWORK, &error);
+		if (problems == NULL)
+			g_error ("failed to validate: %s", error->message);
+	}
+}
+
+/**
+ * as_benchmark_sort_cb:
+ **/
+static gint
+as_benchmark_sort_cb (gconstpointer a, gconstpointer b)
+{
+	gdouble tmp = *((const gdouble *) a) - *((const gdouble *) b);
+	if (tmp < 0)
+		return -1;
+	if (tmp > 0)
+		return 1;
+	return 0;
+}
+
+/**
+ * as_benchmark_run:
+ **/
+static void
+as_benchmark_run (AsBenchmarkContext *ctx,
+		  const AsBenchmarkItem *item,
+		  guint size,
+		  guint iterations,
+		  GString *out)
+{
+	gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+	gdouble *times;
+	gint allocs;
+	gint allocs_min = G_MAXINT;
+	guint i;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	/* warm up the caches first */
+	item->func (ctx);
+
+	times = g_new0 (gdouble, iterations);
+	timer = g_timer_new ();
+	for (i = 0; i < iterations; i++) {
+		g_atomic_int_set (&as_benchmark_allocs, 0);
+		g_timer_start (timer);
+		item->func (ctx);
+		g_timer_stop (timer);
+		allocs = g_atomic_int_get (&as_benchmark_allocs);
+		times[i] = g_timer_elapsed (timer, NULL) * 1000.f;
+		if (allocs < allocs_min)
+			allocs_min = allocs;
+	}
+	qsort (times, iterations, sizeof (gdouble), as_benchmark_sort_cb);
+
+	if (out->len > 0 && out->str[out->len - 1] == '}')
+		g_string_append (out, ",\n");
+	g_string_append_printf (out, "    { \"test\": \"%s\", \"size\": %u, ",
+				item->name, size);
+	g_string_append_printf (out, "\"min_ms\": %s, ",
+				g_ascii_formatd (buf, sizeof (buf), "%.3f", times[0]));
+	g_string_append_printf (out, "\"median_ms\": %s, ",
+				g_ascii_formatd (buf, sizeof (buf), "%.3f",
+						 times[iterations / 2]));
+	g_string_append_printf (out, "\"allocs\": %i }", allocs_min);
+	g_printerr ("%-20s %7u %10.3f ms %10i allocs\n",
+		    item->name, size, times[iterations / 2], allocs_min);
+	g_free (times);
+}
+
+/**
+ * main:
+ **/
+int
+main (int argc, char **argv)
+{
+	AsBenchmarkContext ctx;
+	GOptionContext *context;
+	const gchar *search[] = { "audio", "editor", NULL };
+	const gchar *search_fuzzy[] = { "auido", "editro", NULL };
+	gint iterations = 5;
+	guint i;
+	guint j;
+	guint size;
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_free_ gchar *output = NULL;
+	_cleanup_free_ gchar *sizes_str = NULL;
+	_cleanup_strv_free_ gchar **sizes = NULL;
+	_cleanup_string_free_ GString *out = NULL;
+	const AsBenchmarkItem items[] = {
+		{ "node-from-file",	as_benchmark_node_from_file,	0 },
+		{ "store-from-file",	as_benchmark_store_from_file,	0 },
+		{ "store-to-xml",	as_benchmark_store_to_xml,	0 },
+		{ "store-to-file",	as_benchmark_store_to_file,	0 },
+		{ "search",		as_benchmark_search,		0 },
+		{ "store-search",	as_benchmark_store_search,	0 },
+		{ "store-search-fuzzy",	as_benchmark_store_search_fuzzy, 0 },
+		{ "subsume",		as_benchmark_subsume,		0 },
+		{ "validate",		as_benchmark_validate,		10000 },
+		{ NULL,			NULL,				0 }
+	};
+	const GOptionEntry options[] = {
+		{ "sizes", 's', 0, G_OPTION_ARG_STRING, &sizes_str,
+			"Comma separated catalog sizes, e.g. 1000,10000", NULL },
+		{ "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+			"Number of times to run each test", NULL },
+		{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+			"Write the results as JSON to a file", NULL },
+		{ NULL}
+	};
+
+	context = g_option_context_new ("AppStream benchmarks");
+	g_option_context_add_main_entries (context, options, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("Failed to parse arguments: %s\n", error->message);
+		g_option_context_free (context);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free (context);
+	if (iterations < 1)
+		iterations = 1;
+	sizes = g_strsplit (sizes_str != NULL ? sizes_str : "1000,10000,100000", ",", -1);
+
+	out = g_string_new ("{\n");
+	g_string_append_printf (out, "  \"version\": \"%s\",\n", PACKAGE_VERSION);
+	g_string_append_printf (out, "  \"iterations\": %i,\n", iterations);
+	g_string_append (out, "  \"results\": [\n");
+	for (i = 0; sizes[i] != NULL; i++) {
+		size = g_ascii_strtoull (sizes[i], NULL, 10);
+		if (size == 0)
+			continue;
+
+		/* create a synthetic catalog and save it to disk */
+		ctx.store = as_store_new ();
+		as_store_set_origin (ctx.store, "benchmark");
+		for (j = 0; j < size; j++) {
+			_cleanup_object_unref_ AsApp *app = as_benchmark_create_app (j);
+			as_store_add_app (ctx.store, app);
+		}
+		ctx.apps = as_store_get_apps (ctx.store);
+		ctx.search = (gchar **) search;
+		ctx.search_fuzzy = (gchar **) search_fuzzy;
+		ctx.filename = g_strdup_printf ("%s/as-benchmark-%u-%i.xml.gz",
+						g_get_tmp_dir (), size, getpid ());
+		ctx.file = g_file_new_for_path (ctx.filename);
+		as_benchmark_store_to_file (&ctx);
+
+		for (j = 0; items[j].name != NULL; j++) {
+			if (items[j].max_size > 0 && size > items[j].max_size)
+				continue;
+			as_benchmark_run (&ctx, &items[j], size, iterations, out);
+		}
+
+		g_unlink (ctx.filename);
+		g_free (ctx.filename);
+		g_object_unref (ctx.file);
+		g_object_unref (ctx.store);
+	}
+	g_string_append (out, "\n  ]\n}\n");
+
+	/* machine readable output */
+	if (output == NULL) {
+		g_print ("%s", out->str);
+	} else if (!g_file_set_contents (output, out->str, -1, &error)) {
+		g_printerr ("Failed to write %s: %s\n", output, error->message);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
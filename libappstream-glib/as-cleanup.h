@@ -57,12 +57,12 @@ GS_DEFINE_CLEANUP_FUNCTION0(GDir*, gs_local_dir_close, g_dir_close)
 GS_DEFINE_CLEANUP_FUNCTION0(GError*, gs_local_free_error, g_error_free)
 GS_DEFINE_CLEANUP_FUNCTION0(GHashTable*, gs_local_hashtable_unref, g_hash_table_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GKeyFile*, gs_local_keyfile_unref, g_key_file_unref)
+GS_DEFINE_CLEANUP_FUNCTION0(GMappedFile*, gs_local_mapped_file_unref, g_mapped_file_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GMarkupParseContext*, gs_local_markup_parse_context_unref, g_markup_parse_context_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GNode*, gs_local_node_unref, as_node_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GObject*, gs_local_obj_unref, g_object_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GPtrArray*, gs_local_ptrarray_unref, g_ptr_array_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GTimer*, gs_local_destroy_timer, g_timer_destroy)
-GS_DEFINE_CLEANUP_FUNCTION0(GVariantBuilder*, gs_local_variant_builder_unref, g_variant_builder_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GVariant*, gs_local_variant_unref, g_variant_unref)
 GS_DEFINE_CLEANUP_FUNCTION0(GVariantIter*, gs_local_variant_iter_free, g_variant_iter_free)
 GS_DEFINE_CLEANUP_FUNCTION0(SoupURI*, gs_local_uri_unref, soup_uri_free)
@@ -85,6 +85,7 @@ GS_DEFINE_CLEANUP_FUNCTION(void*, gs_local_free, g_free)
 #define _cleanup_bytes_unref_ __attribute__ ((cleanup(gs_local_bytes_unref)))
 #define _cleanup_hashtable_unref_ __attribute__ ((cleanup(gs_local_hashtable_unref)))
 #define _cleanup_keyfile_unref_ __attribute__ ((cleanup(gs_local_keyfile_unref)))
+#define _cleanup_mapped_file_unref_ __attribute__ ((cleanup(gs_local_mapped_file_unref)))
 #define _cleanup_markup_parse_context_unref_ __attribute__ ((cleanup(gs_local_markup_parse_context_unref)))
 #define _cleanup_node_unref_ __attribute__ ((cleanup(gs_local_node_unref)))
 #define _cleanup_object_unref_ __attribute__ ((cleanup(gs_local_obj_unref)))
@@ -30,12 +30,17 @@
 
 G_BEGIN_DECLS
 
+#define AS_IMAGE_VARIANT_TYPE	"(umsuu)"
+
 GNode		*as_image_node_insert		(AsImage	*image,
 						 GNode		*parent,
 						 gdouble	 api_version);
 gboolean	 as_image_node_parse		(AsImage	*image,
 						 GNode		*node,
 						 GError		**error);
+GVariant	*as_image_to_variant		(AsImage	*image);
+void		 as_image_from_variant		(AsImage	*image,
+						 GVariant	*value);
 
 G_END_DECLS
 
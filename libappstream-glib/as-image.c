@@ -437,6 +437,53 @@ as_image_node_parse (AsImage *image, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_image_to_variant: (skip)
+ * @image: a #AsImage instance.
+ *
+ * Serializes the image into a #GVariant of type %AS_IMAGE_VARIANT_TYPE.
+ *
+ * Returns: (transfer full): a floating #GVariant
+ *
+ * Since: 0.1.8
+ **/
+GVariant *
+as_image_to_variant (AsImage *image)
+{
+	AsImagePrivate *priv = GET_PRIVATE (image);
+	return g_variant_new (AS_IMAGE_VARIANT_TYPE,
+			      (guint32) priv->kind,
+			      priv->url,
+			      (guint32) priv->width,
+			      (guint32) priv->height);
+}
+
+/**
+ * as_image_from_variant: (skip)
+ * @image: a #AsImage instance.
+ * @value: a #GVariant of type %AS_IMAGE_VARIANT_TYPE.
+ *
+ * Populates the object from a variant created by as_image_to_variant().
+ *
+ * Since: 0.1.8
+ **/
+void
+as_image_from_variant (AsImage *image, GVariant *value)
+{
+	AsImagePrivate *priv = GET_PRIVATE (image);
+	guint32 height;
+	guint32 kind;
+	guint32 width;
+	gchar *url = NULL;
+
+	g_variant_get (value, AS_IMAGE_VARIANT_TYPE, &kind, &url, &width, &height);
+	priv->kind = kind;
+	priv->width = width;
+	priv->height = height;
+	g_free (priv->url);
+	priv->url = url;
+}
+
 /**
  * as_image_load_filename:
  * @image: a #AsImage instance.
@@ -30,6 +30,10 @@
 
 G_BEGIN_DECLS
 
+typedef void (*AsNodeSubtreeFunc)		(GNode		*node,
+						 gpointer	 user_data,
+						 GError		**error);
+
 gchar		*as_node_take_data		(const GNode	*node);
 gchar		*as_node_take_attribute		(const GNode	*node,
 						 const gchar	*key);
@@ -50,6 +54,22 @@ void		 as_node_add_attribute		(GNode		*node,
 						 gssize		 value_len);
 gchar		*as_node_reflow_text		(const gchar	*text,
 						 gssize		 text_len);
+void		 as_node_to_xml_start		(GString	*xml,
+						 const GNode	*node,
+						 AsNodeToXmlFlags flags);
+void		 as_node_to_xml_append		(GString	*xml,
+						 const GNode	*node,
+						 AsNodeToXmlFlags flags);
+void		 as_node_to_xml_end		(GString	*xml,
+						 const GNode	*node,
+						 AsNodeToXmlFlags flags);
+GNode		*as_node_from_file_streaming	(GFile		*file,
+						 AsNodeFromXmlFlags flags,
+						 AsNodeSubtreeFunc func,
+						 gpointer	 user_data,
+						 GCancellable	*cancellable,
+						 GError		**error)
+						 G_GNUC_WARN_UNUSED_RESULT;
 
 G_END_DECLS
 
@@ -36,24 +36,285 @@
 
 #include <glib.h>
 #include <string.h>
+#include <zlib.h>
 
 #include "as-cleanup.h"
 #include "as-node-private.h"
 #include "as-utils-private.h"
 
+/* big enough for a typical component */
+#define AS_NODE_ARENA_CHUNK_SIZE	(64 * 1024)
+#define AS_NODE_ARENA_ALIGN(sz)		(((sz) + 7) & ~((gsize) 7))
+
+typedef struct {
+	gsize		 size;
+	gsize		 used;
+} AsNodeArenaChunk;
+
+typedef struct {
+	GPtrArray	*chunks;	/* of AsNodeArenaChunk, last is current */
+} AsNodeArena;
+
+typedef struct {
+	guint		 chunk;
+	gsize		 used;
+} AsNodeArenaMark;
+
+/* most elements have no more than two attributes, e.g. type and xml:lang */
+#define AS_NODE_ATTRS_INLINE	2
+
+typedef struct {
+	const gchar	*key;		/* interned */
+	gchar		*value;
+} AsNodeAttr;
+
 typedef struct
 {
-	GList		*attrs;
+	AsNodeAttr	*attrs;		/* inline, in the arena or on the heap */
+	guint		 attrs_len;
+	guint		 attrs_size;
 	gchar		*name;		/* only used if tag == AS_TAG_UNKNOWN */
 	gchar		*cdata;
 	gboolean	 cdata_escaped;
 	AsTag		 tag;
+	AsNodeArena	*arena;		/* or NULL if allocated on the heap */
+	AsNodeAttr	 attrs_inline[AS_NODE_ATTRS_INLINE];
 } AsNodeData;
 
 typedef struct {
-	const gchar	*key;
-	gchar		*value;
-} AsNodeAttr;
+	AsTag		 tag;		/* or AS_TAG_LAST for the end */
+	gchar		*name;		/* only used if tag == AS_TAG_UNKNOWN */
+} AsNodePathItem;
+
+/* the number of different paths compiled by as_node_find() to keep */
+#define AS_NODE_PATH_CACHE_MAX	256
+
+/* each thread has its own cache so that looking up a path needs no lock */
+static GPrivate as_node_paths = G_PRIVATE_INIT ((GDestroyNotify) g_hash_table_unref);
+
+/* arena roots have no data, so they are tracked here */
+G_LOCK_DEFINE_STATIC (as_node_arenas);
+static GHashTable *as_node_arenas = NULL;	/* of GNode:AsNodeArena */
+
+/**
+ * as_node_arena_new:
+ **/
+static AsNodeArena *
+as_node_arena_new (void)
+{
+	AsNodeArena *arena;
+	arena = g_slice_new0 (AsNodeArena);
+	arena->chunks = g_ptr_array_new_with_free_func (g_free);
+	return arena;
+}
+
+/**
+ * as_node_arena_free:
+ **/
+static void
+as_node_arena_free (AsNodeArena *arena)
+{
+	g_ptr_array_unref (arena->chunks);
+	g_slice_free (AsNodeArena, arena);
+}
+
+/**
+ * as_node_arena_alloc:
+ *
+ * Returns zeroed memory that is only freed when the arena is destroyed
+ * or reset to an earlier mark.
+ **/
+static gpointer
+as_node_arena_alloc (AsNodeArena *arena, gsize size)
+{
+	AsNodeArenaChunk *chunk = NULL;
+	gchar *mem;
+
+	size = AS_NODE_ARENA_ALIGN (size);
+	if (arena->chunks->len > 0)
+		chunk = g_ptr_array_index (arena->chunks, arena->chunks->len - 1);
+	if (chunk == NULL || chunk->used + size > chunk->size) {
+		gsize chunk_size = MAX (size, AS_NODE_ARENA_CHUNK_SIZE);
+		chunk = g_malloc (sizeof (AsNodeArenaChunk) + chunk_size);
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		g_ptr_array_add (arena->chunks, chunk);
+	}
+	mem = (gchar *) (chunk + 1) + chunk->used;
+	chunk->used += size;
+	memset (mem, 0, size);
+	return mem;
+}
+
+/**
+ * as_node_arena_strndup:
+ **/
+static gchar *
+as_node_arena_strndup (AsNodeArena *arena, const gchar *str, gssize len)
+{
+	gchar *tmp;
+	if (str == NULL)
+		return NULL;
+	if (len < 0)
+		len = strlen (str);
+	tmp = as_node_arena_alloc (arena, len + 1);
+	memcpy (tmp, str, len);
+	return tmp;
+}
+
+/**
+ * as_node_arena_get_mark:
+ **/
+static void
+as_node_arena_get_mark (AsNodeArena *arena, AsNodeArenaMark *mark)
+{
+	AsNodeArenaChunk *chunk;
+	mark->chunk = arena->chunks->len;
+	mark->used = 0;
+	if (arena->chunks->len == 0)
+		return;
+	chunk = g_ptr_array_index (arena->chunks, arena->chunks->len - 1);
+	mark->chunk = arena->chunks->len - 1;
+	mark->used = chunk->used;
+}
+
+/**
+ * as_node_arena_reset:
+ *
+ * Releases everything allocated since @mark was taken.
+ **/
+static void
+as_node_arena_reset (AsNodeArena *arena, AsNodeArenaMark *mark)
+{
+	AsNodeArenaChunk *chunk;
+	if (mark->chunk >= arena->chunks->len) {
+		g_ptr_array_set_size (arena->chunks, mark->chunk);
+		return;
+	}
+	g_ptr_array_set_size (arena->chunks, mark->chunk + 1);
+	chunk = g_ptr_array_index (arena->chunks, mark->chunk);
+	chunk->used = mark->used;
+}
+
+/**
+ * as_node_arena_set_root:
+ **/
+static void
+as_node_arena_set_root (GNode *root, AsNodeArena *arena)
+{
+	G_LOCK (as_node_arenas);
+	if (as_node_arenas == NULL)
+		as_node_arenas = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_hash_table_insert (as_node_arenas, root, arena);
+	G_UNLOCK (as_node_arenas);
+}
+
+/**
+ * as_node_arena_get_root:
+ **/
+static AsNodeArena *
+as_node_arena_get_root (GNode *root, gboolean steal)
+{
+	AsNodeArena *arena = NULL;
+	G_LOCK (as_node_arenas);
+	if (as_node_arenas != NULL) {
+		arena = g_hash_table_lookup (as_node_arenas, root);
+		if (arena != NULL && steal)
+			g_hash_table_remove (as_node_arenas, root);
+	}
+	G_UNLOCK (as_node_arenas);
+	return arena;
+}
+
+/**
+ * as_node_get_arena:
+ **/
+static AsNodeArena *
+as_node_get_arena (GNode *node)
+{
+	AsNodeData *data = node->data;
+	if (data != NULL)
+		return data->arena;
+	return as_node_arena_get_root (node, FALSE);
+}
+
+/**
+ * as_node_data_new:
+ **/
+static AsNodeData *
+as_node_data_new (AsNodeArena *arena)
+{
+	AsNodeData *data;
+	if (arena == NULL)
+		return g_slice_new0 (AsNodeData);
+	data = as_node_arena_alloc (arena, sizeof (AsNodeData));
+	data->arena = arena;
+	return data;
+}
+
+/**
+ * as_node_data_strndup:
+ **/
+static gchar *
+as_node_data_strndup (AsNodeData *data, const gchar *str, gssize len)
+{
+	if (data->arena != NULL)
+		return as_node_arena_strndup (data->arena, str, len);
+	return as_strndup (str, len);
+}
+
+/**
+ * as_node_data_adopt_string:
+ *
+ * Takes ownership of a heap string, copying it into the arena if required.
+ **/
+static gchar *
+as_node_data_adopt_string (AsNodeData *data, gchar *str)
+{
+	gchar *tmp;
+	if (data->arena == NULL)
+		return str;
+	tmp = as_node_arena_strndup (data->arena, str, -1);
+	g_free (str);
+	return tmp;
+}
+
+/**
+ * as_node_data_free_string:
+ **/
+static void
+as_node_data_free_string (AsNodeData *data, gchar *str)
+{
+	if (data->arena == NULL)
+		g_free (str);
+}
+
+/**
+ * as_node_data_steal_string:
+ *
+ * Returns a string the caller can free with g_free().
+ **/
+static gchar *
+as_node_data_steal_string (AsNodeData *data, gchar *str)
+{
+	if (data->arena != NULL)
+		return g_strdup (str);
+	return str;
+}
+
+/**
+ * as_node_append_data:
+ **/
+static GNode *
+as_node_append_data (GNode *parent, AsNodeData *data)
+{
+	GNode *node;
+	if (data->arena == NULL)
+		return g_node_append_data (parent, data);
+	node = as_node_arena_alloc (data->arena, sizeof (GNode));
+	node->data = data;
+	return g_node_append (parent, node);
+}
 
 /**
  * as_node_new: (skip)
@@ -71,13 +332,22 @@ as_node_new (void)
 }
 
 /**
- * as_node_attr_free:
+ * as_node_attr_intern_keys:
+ *
+ * Interns the keys used internally using the string literals themselves, so
+ * that looking these up is normally just a pointer comparison.
  **/
 static void
-as_node_attr_free (AsNodeAttr *attr)
+as_node_attr_intern_keys (void)
 {
-	g_free (attr->value);
-	g_slice_free (AsNodeAttr, attr);
+	static gsize done = 0;
+	if (g_once_init_enter (&done)) {
+		g_intern_static_string ("@comment");
+		g_intern_static_string ("@comment-tmp");
+		g_intern_static_string ("type");
+		g_intern_static_string ("xml:lang");
+		g_once_init_leave (&done, 1);
+	}
 }
 
 /**
@@ -87,25 +357,53 @@ static AsNodeAttr *
 as_node_attr_insert (AsNodeData *data, const gchar *key, const gchar *value)
 {
 	AsNodeAttr *attr;
-	attr = g_slice_new0 (AsNodeAttr);
+	AsNodeAttr *attrs;
+	guint size;
+
+	/* use the inline storage first, then double the size */
+	if (data->attrs == NULL) {
+		data->attrs = data->attrs_inline;
+		data->attrs_size = AS_NODE_ATTRS_INLINE;
+	} else if (data->attrs_len == data->attrs_size) {
+		if (data->attrs_size > G_MAXUINT / 2)
+			g_error ("too many attributes on one element");
+		size = data->attrs_size * 2;
+		if (data->arena != NULL) {
+			attrs = as_node_arena_alloc (data->arena,
+						     size * sizeof (AsNodeAttr));
+			memcpy (attrs, data->attrs,
+				data->attrs_len * sizeof (AsNodeAttr));
+		} else if (data->attrs == data->attrs_inline) {
+			attrs = g_new (AsNodeAttr, size);
+			memcpy (attrs, data->attrs,
+				data->attrs_len * sizeof (AsNodeAttr));
+		} else {
+			attrs = g_renew (AsNodeAttr, data->attrs, size);
+		}
+		data->attrs = attrs;
+		data->attrs_size = size;
+	}
+	as_node_attr_intern_keys ();
+	attr = &data->attrs[data->attrs_len++];
 	attr->key = g_intern_string (key);
-	attr->value = g_strdup (value);
-	data->attrs = g_list_prepend (data->attrs, attr);
+	attr->value = as_node_data_strndup (data, value, -1);
 	return attr;
 }
 
 /**
  * as_node_attr_find:
+ *
+ * Returns the most recently added attribute with the key.
  **/
 static AsNodeAttr *
 as_node_attr_find (AsNodeData *data, const gchar *key)
 {
 	AsNodeAttr *attr;
-	GList *l;
+	guint i;
 
-	for (l = data->attrs; l != NULL; l = l->next) {
-		attr = l->data;
-		if (g_strcmp0 (attr->key, key) == 0)
+	for (i = data->attrs_len; i > 0; i--) {
+		attr = &data->attrs[i - 1];
+		if (attr->key == key || strcmp (attr->key, key) == 0)
 			return attr;
 	}
 	return NULL;
@@ -131,11 +429,15 @@ static gboolean
 as_node_destroy_node_cb (GNode *node, gpointer user_data)
 {
 	AsNodeData *data = node->data;
-	if (data == NULL)
+	guint i;
+	if (data == NULL || data->arena != NULL)
 		return FALSE;
 	g_free (data->name);
 	g_free (data->cdata);
-	g_list_free_full (data->attrs, (GDestroyNotify) as_node_attr_free);
+	for (i = 0; i < data->attrs_len; i++)
+		g_free (data->attrs[i].value);
+	if (data->attrs != data->attrs_inline)
+		g_free (data->attrs);
 	g_slice_free (AsNodeData, data);
 	return FALSE;
 }
@@ -146,11 +448,35 @@ as_node_destroy_node_cb (GNode *node, gpointer user_data)
  *
  * Deallocates all notes in the tree.
  *
+ * Trees parsed using %AS_NODE_FROM_XML_FLAG_ARENA are freed in one step
+ * when the root node is unreffed, and unreffing any other node in such a
+ * tree just unlinks it.
+ *
  * Since: 0.1.0
  **/
 void
 as_node_unref (GNode *node)
 {
+	AsNodeArena *arena;
+	AsNodeData *data = node->data;
+
+	/* the arena owns every node in the tree */
+	if (data != NULL && data->arena != NULL) {
+		g_node_unlink (node);
+		return;
+	}
+
+	/* free every child in one go */
+	if (data == NULL) {
+		arena = as_node_arena_get_root (node, TRUE);
+		if (arena != NULL) {
+			as_node_arena_free (arena);
+			node->children = NULL;
+			g_node_destroy (node);
+			return;
+		}
+	}
+
 	g_node_traverse (node,
 			 G_PRE_ORDER,
 			 G_TRAVERSE_ALL,
@@ -244,11 +570,11 @@ as_node_cdata_to_escaped (AsNodeData *data)
 	if (data->cdata_escaped)
 		return;
 	str = g_string_new (data->cdata);
-	g_free (data->cdata);
+	as_node_data_free_string (data, data->cdata);
 	as_node_string_replace (str, "&", "&amp;");
 	as_node_string_replace (str, "<", "&lt;");
 	as_node_string_replace (str, ">", "&gt;");
-	data->cdata = g_string_free (str, FALSE);
+	data->cdata = as_node_data_adopt_string (data, g_string_free (str, FALSE));
 	data->cdata_escaped = TRUE;
 }
 
@@ -270,12 +596,13 @@ static gchar *
 as_node_get_attr_string (AsNodeData *data)
 {
 	AsNodeAttr *attr;
-	GList *l;
 	GString *str;
+	guint i;
 
+	/* newest first */
 	str = g_string_new ("");
-	for (l = data->attrs; l != NULL; l = l->next) {
-		attr = l->data;
+	for (i = data->attrs_len; i > 0; i--) {
+		attr = &data->attrs[i - 1];
 		if (g_strcmp0 (attr->key, "@comment") == 0 ||
 		    g_strcmp0 (attr->key, "@comment-tmp") == 0)
 			continue;
@@ -305,7 +632,65 @@ as_node_data_set_name (AsNodeData *data, const gchar *name)
 	/* only store the name if the tag is not recognised */
 	data->tag = as_tag_from_string (name);
 	if (data->tag == AS_TAG_UNKNOWN)
-		data->name = g_strdup (name);
+		data->name = as_node_data_strndup (data, name, -1);
+}
+
+/**
+ * as_node_to_xml_string_comment:
+ **/
+static void
+as_node_to_xml_string_comment (GString *xml,
+			       guint depth_offset,
+			       const GNode *n,
+			       AsNodeToXmlFlags flags)
+{
+	const gchar *comment;
+
+	comment = as_node_get_comment (n);
+	if (comment == NULL)
+		return;
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
+		as_node_add_padding (xml, g_node_depth ((GNode *) n) - depth_offset);
+	g_string_append_printf (xml, "<!-- %s -->", comment);
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
+		g_string_append (xml, "\n");
+}
+
+/**
+ * as_node_to_xml_string_open:
+ **/
+static void
+as_node_to_xml_string_open (GString *xml,
+			    guint depth_offset,
+			    const GNode *n,
+			    AsNodeToXmlFlags flags)
+{
+	AsNodeData *data = n->data;
+	gchar *attrs;
+
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
+		as_node_add_padding (xml, g_node_depth ((GNode *) n) - depth_offset);
+	attrs = as_node_get_attr_string (data);
+	g_string_append_printf (xml, "<%s%s>", as_tag_data_get_name (data), attrs);
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
+		g_string_append (xml, "\n");
+	g_free (attrs);
+}
+
+/**
+ * as_node_to_xml_string_close:
+ **/
+static void
+as_node_to_xml_string_close (GString *xml,
+			     guint depth_offset,
+			     const GNode *n,
+			     AsNodeToXmlFlags flags)
+{
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
+		as_node_add_padding (xml, g_node_depth ((GNode *) n) - depth_offset);
+	g_string_append_printf (xml, "</%s>", as_tag_data_get_name (n->data));
+	if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
+		g_string_append (xml, "\n");
 }
 
 /**
@@ -320,19 +705,11 @@ as_node_to_xml_string (GString *xml,
 	AsNodeData *data = n->data;
 	GNode *c;
 	const gchar *tag_str;
-	const gchar *comment;
 	guint depth = g_node_depth ((GNode *) n);
 	gchar *attrs;
 
 	/* comment */
-	comment = as_node_get_comment (n);
-	if (comment != NULL) {
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
-			as_node_add_padding (xml, depth - depth_offset);
-		g_string_append_printf (xml, "<!-- %s -->", comment);
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
-			g_string_append (xml, "\n");
-	}
+	as_node_to_xml_string_comment (xml, depth_offset, n, flags);
 
 	/* root node */
 	if (data == NULL) {
@@ -362,86 +739,109 @@ as_node_to_xml_string (GString *xml,
 
 	/* node with children */
 	} else {
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
-			as_node_add_padding (xml, depth - depth_offset);
-		attrs = as_node_get_attr_string (data);
-		tag_str = as_tag_data_get_name (data);
-		g_string_append_printf (xml, "<%s%s>", tag_str, attrs);
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
-			g_string_append (xml, "\n");
-		g_free (attrs);
-
+		as_node_to_xml_string_open (xml, depth_offset, n, flags);
 		for (c = n->children; c != NULL; c = c->next)
 			as_node_to_xml_string (xml, depth_offset, c, flags);
-
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_INDENT) > 0)
-			as_node_add_padding (xml, depth - depth_offset);
-		g_string_append_printf (xml, "</%s>", tag_str);
-		if ((flags & AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE) > 0)
-			g_string_append (xml, "\n");
+		as_node_to_xml_string_close (xml, depth_offset, n, flags);
 	}
 }
 
 /**
- * as_node_reflow_text:
- * @text: XML text data
- * @text_len: length of @text
+ * as_node_reflow_text_into:
  *
- * Converts pretty-formatted source text into a format suitable for AppStream.
- * This might include joining paragraphs, supressing newlines or doing other
- * sanity checks to the text.
+ * Reflows @text into @dest, which has to be at least @text_len + 1 bytes as
+ * the output is never longer than the input. Each line is stripped in place
+ * rather than being split into a new string.
  *
- * Returns: (transfer full): a new string
- *
- * Since: 0.1.4
+ * Returns: the length of the text written to @dest
  **/
-gchar *
-as_node_reflow_text (const gchar *text, gssize text_len)
+static gsize
+as_node_reflow_text_into (gchar *dest, const gchar *text, gsize text_len)
 {
-	GString *tmp;
-	gchar **split;
-	guint i;
+	const gchar *end = text + text_len;
+	const gchar *line_end;
+	const gchar *start;
+	const gchar *stop;
+	gchar *out = dest;
 	guint newline_count = 0;
 
-	/* split the text into lines */
-	tmp = g_string_sized_new (text_len + 1);
-	split = g_strsplit (text, "\n", -1);
-	for (i = 0; split[i] != NULL; i++) {
+	for (;;) {
+		line_end = memchr (text, '\n', end - text);
+		if (line_end == NULL)
+			line_end = end;
 
 		/* remove leading and trailing whitespace */
-		g_strstrip (split[i]);
+		start = text;
+		stop = line_end;
+		while (start < stop && g_ascii_isspace (*start))
+			start++;
+		while (stop > start && g_ascii_isspace (stop[-1]))
+			stop--;
 
 		/* if this is a blank line we end the paragraph mode
 		 * and swallow the newline. If we see exactly two
 		 * newlines in sequence then do a paragraph break */
-		if (split[i][0] == '\0') {
+		if (start == stop) {
 			newline_count++;
-			continue;
-		}
-
-		/* if the line just before this one was not a newline
-		 * then seporate the words with a space */
-		if (newline_count == 1 && tmp->len > 0)
-			g_string_append (tmp, " ");
-
-		/* if we had more than one newline in sequence add a paragraph
-		 * break */
-		if (newline_count > 1)
-			g_string_append (tmp, "\n\n");
+		} else {
+			/* if the line just before this one was not a newline
+			 * then seporate the words with a space */
+			if (newline_count == 1 && out > dest)
+				*out++ = ' ';
+
+			/* if we had more than one newline in sequence add a
+			 * paragraph break */
+			if (newline_count > 1) {
+				*out++ = '\n';
+				*out++ = '\n';
+			}
 
-		/* add the actual stripped text */
-		g_string_append (tmp, split[i]);
+			/* add the actual stripped text */
+			memcpy (out, start, stop - start);
+			out += stop - start;
 
-		/* this last section was paragraph */
-		newline_count = 1;
+			/* this last section was paragraph */
+			newline_count = 1;
+		}
+		if (line_end == end)
+			break;
+		text = line_end + 1;
 	}
-	g_strfreev (split);
-	return g_string_free (tmp, FALSE);
+	*out = '\0';
+	return out - dest;
+}
+
+/**
+ * as_node_reflow_text:
+ * @text: XML text data
+ * @text_len: length of @text, or -1 if NUL terminated
+ *
+ * Converts pretty-formatted source text into a format suitable for AppStream.
+ * This might include joining paragraphs, supressing newlines or doing other
+ * sanity checks to the text.
+ *
+ * Returns: (transfer full): a new string
+ *
+ * Since: 0.1.4
+ **/
+gchar *
+as_node_reflow_text (const gchar *text, gssize text_len)
+{
+	gchar *tmp;
+	if (text_len < 0)
+		text_len = strlen (text);
+	tmp = g_malloc (text_len + 1);
+	as_node_reflow_text_into (tmp, text, text_len);
+	return tmp;
 }
 
 typedef struct {
 	GNode			*current;
 	AsNodeFromXmlFlags	 flags;
+	AsNodeSubtreeFunc	 subtree_func;
+	gpointer		 subtree_data;
+	AsNodeArena		*arena;
+	AsNodeArenaMark		 subtree_mark;
 } AsNodeToXmlHelper;
 
 /**
@@ -473,6 +873,70 @@ as_node_to_xml (const GNode *node, AsNodeToXmlFlags flags)
 	return xml;
 }
 
+/* streamed elements are formatted as if the entire tree was converted using
+ * as_node_to_xml() on the root node */
+#define AS_NODE_TO_XML_STREAM_DEPTH_OFFSET	2
+
+/**
+ * as_node_to_xml_start: (skip)
+ * @xml: a #GString
+ * @node: a #GNode with data
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_TO_XML_FLAG_ADD_HEADER.
+ *
+ * Appends the opening tag of @node, ignoring any children. Children can then
+ * be added one at a time using as_node_to_xml_append(), and the element
+ * finished with as_node_to_xml_end(), so that a large document can be written
+ * without ever holding all of it in memory.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_node_to_xml_start (GString *xml, const GNode *node, AsNodeToXmlFlags flags)
+{
+	g_return_if_fail (node->data != NULL);
+	if ((flags & AS_NODE_TO_XML_FLAG_ADD_HEADER) > 0)
+		g_string_append (xml, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	as_node_to_xml_string_comment (xml, AS_NODE_TO_XML_STREAM_DEPTH_OFFSET,
+				       node, flags);
+	as_node_to_xml_string_open (xml, AS_NODE_TO_XML_STREAM_DEPTH_OFFSET,
+				    node, flags);
+}
+
+/**
+ * as_node_to_xml_append: (skip)
+ * @xml: a #GString
+ * @node: a #GNode
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_TO_XML_FLAG_FORMAT_INDENT.
+ *
+ * Appends @node and all its children.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_node_to_xml_append (GString *xml, const GNode *node, AsNodeToXmlFlags flags)
+{
+	as_node_to_xml_string (xml, AS_NODE_TO_XML_STREAM_DEPTH_OFFSET,
+			       node, flags);
+}
+
+/**
+ * as_node_to_xml_end: (skip)
+ * @xml: a #GString
+ * @node: a #GNode with data
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_TO_XML_FLAG_FORMAT_INDENT.
+ *
+ * Appends the closing tag of @node.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_node_to_xml_end (GString *xml, const GNode *node, AsNodeToXmlFlags flags)
+{
+	g_return_if_fail (node->data != NULL);
+	as_node_to_xml_string_close (xml, AS_NODE_TO_XML_STREAM_DEPTH_OFFSET,
+				     node, flags);
+}
+
 /**
  * as_node_start_element_cb:
  **/
@@ -490,8 +954,14 @@ as_node_start_element_cb (GMarkupParseContext *context,
 	gchar *tmp;
 	guint i;
 
+	/* everything in a streamed component is released in one go */
+	if (helper->arena != NULL &&
+	    helper->subtree_func != NULL &&
+	    g_node_depth (helper->current) == 2)
+		as_node_arena_get_mark (helper->arena, &helper->subtree_mark);
+
 	/* create the new node data */
-	data = g_slice_new0 (AsNodeData);
+	data = as_node_data_new (helper->arena);
 	as_node_data_set_name (data, element_name);
 	for (i = 0; attribute_names[i] != NULL; i++) {
 		as_node_attr_insert (data,
@@ -500,7 +970,7 @@ as_node_start_element_cb (GMarkupParseContext *context,
 	}
 
 	/* add the node to the DOM */
-	current = g_node_append_data (helper->current, data);
+	current = as_node_append_data (helper->current, data);
 
 	/* transfer the ownership of the comment to the new child */
 	tmp = as_node_take_attribute (helper->current, "@comment-tmp");
@@ -523,7 +993,21 @@ as_node_end_element_cb (GMarkupParseContext *context,
 			GError             **error)
 {
 	AsNodeToXmlHelper *helper = (AsNodeToXmlHelper *) user_data;
-	helper->current = helper->current->parent;
+	GNode *current = helper->current;
+
+	helper->current = current->parent;
+
+	/* hand off each complete top-level component and throw it away */
+	if (helper->subtree_func == NULL)
+		return;
+	if (g_node_depth (current) != 3)
+		return;
+	if (as_node_get_tag (current) != AS_TAG_APPLICATION)
+		return;
+	helper->subtree_func (current, helper->subtree_data, error);
+	as_node_unref (current);
+	if (helper->arena != NULL)
+		as_node_arena_reset (helper->arena, &helper->subtree_mark);
 }
 
 /**
@@ -555,73 +1039,417 @@ as_node_text_cb (GMarkupParseContext *context,
 	/* split up into lines and add each with spaces stripped */
 	data = helper->current->data;
 	if ((helper->flags & AS_NODE_FROM_XML_FLAG_LITERAL_TEXT) > 0) {
-		data->cdata = g_strndup (text, text_len);
+		data->cdata = as_node_data_strndup (data, text, text_len);
+	} else if (data->arena != NULL) {
+		data->cdata = as_node_arena_alloc (data->arena, text_len + 1);
+		as_node_reflow_text_into (data->cdata, text, text_len);
+	} else {
+		data->cdata = g_malloc (text_len + 1);
+		as_node_reflow_text_into (data->cdata, text, text_len);
+	}
+}
+
+/**
+ * as_node_passthrough_cb:
+ **/
+static void
+as_node_passthrough_cb (GMarkupParseContext *context,
+			const gchar         *passthrough_text,
+			gsize                passthrough_len,
+			gpointer             user_data,
+			GError             **error)
+{
+	AsNodeToXmlHelper *helper = (AsNodeToXmlHelper *) user_data;
+	const gchar *tmp;
+	gchar *found;
+	_cleanup_free_ gchar *text = NULL;
+
+	/* only keep comments when told to */
+	if ((helper->flags & AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS) == 0)
+		return;
+
+	/* xml header */
+	if (g_strstr_len (passthrough_text, passthrough_len, "<?xml") != NULL)
+		return;
+
+	/* get stripped comment without '<!--' and '-->' */
+	text = g_strndup (passthrough_text, passthrough_len);
+	if (!g_str_has_prefix (text, "<!--")) {
+		g_warning ("Unexpected input: %s", text);
+		return;
+	}
+	found = g_strrstr (text, "-->");
+	if (found != NULL)
+		*found = '\0';
+	tmp = g_strstrip (text + 4);
+	if (tmp == NULL || tmp[0] == '\0')
+		return;
+	as_node_add_attribute (helper->current, "@comment-tmp", tmp, -1);
+}
+
+/**
+ * as_node_from_xml: (skip)
+ * @data: XML data
+ * @data_len: Length of @data, or -1 if NULL terminated
+ * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
+ * @error: A #GError or %NULL
+ *
+ * Parses XML data into a DOM tree.
+ *
+ * Returns: (transfer full): A populated #GNode tree
+ *
+ * Since: 0.1.0
+ **/
+GNode *
+as_node_from_xml (const gchar *data,
+		  gssize data_len,
+		  AsNodeFromXmlFlags flags,
+		  GError **error)
+{
+	AsNodeToXmlHelper helper;
+	GNode *root = NULL;
+	gboolean ret;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_markup_parse_context_unref_ GMarkupParseContext *ctx = NULL;
+	const GMarkupParser parser = {
+		as_node_start_element_cb,
+		as_node_end_element_cb,
+		as_node_text_cb,
+		as_node_passthrough_cb,
+		NULL };
+
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	root = g_node_new (NULL);
+	helper.flags = flags;
+	helper.current = root;
+	helper.subtree_func = NULL;
+	helper.subtree_data = NULL;
+	helper.arena = NULL;
+	if ((flags & AS_NODE_FROM_XML_FLAG_ARENA) > 0) {
+		helper.arena = as_node_arena_new ();
+		as_node_arena_set_root (root, helper.arena);
+	}
+	ctx = g_markup_parse_context_new (&parser,
+					  G_MARKUP_PREFIX_ERROR_POSITION,
+					  &helper,
+					  NULL);
+	ret = g_markup_parse_context_parse (ctx,
+					    data,
+					    data_len,
+					    &error_local);
+	if (!ret) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     error_local->message);
+		as_node_unref (root);
+		return NULL;
+	}
+
+	/* more opening than closing */
+	if (root != helper.current) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     "Mismatched XML");
+		as_node_unref (root);
+		return NULL;
+	}
+	return root;
+}
+
+/* the decompressed data is parsed in large blocks, and the buffer is reused
+ * for every file that is loaded on the same thread */
+#define AS_NODE_INFLATE_BUFFER_SIZE	(256 * 1024)
+
+static GPrivate as_node_inflate_buffer = G_PRIVATE_INIT (g_free);
+
+typedef enum {
+	AS_NODE_FILE_KIND_UNKNOWN,
+	AS_NODE_FILE_KIND_XML,
+	AS_NODE_FILE_KIND_GZIP,
+	AS_NODE_FILE_KIND_LAST
+} AsNodeFileKind;
+
+/**
+ * as_node_file_kind_from_filename:
+ **/
+static AsNodeFileKind
+as_node_file_kind_from_filename (const gchar *filename)
+{
+	if (filename == NULL)
+		return AS_NODE_FILE_KIND_UNKNOWN;
+	if (g_str_has_suffix (filename, ".xml.gz"))
+		return AS_NODE_FILE_KIND_GZIP;
+	if (g_str_has_suffix (filename, ".xml"))
+		return AS_NODE_FILE_KIND_XML;
+	return AS_NODE_FILE_KIND_UNKNOWN;
+}
+
+/**
+ * as_node_parse_chunk:
+ **/
+static gboolean
+as_node_parse_chunk (GMarkupParseContext *ctx,
+		     const gchar *data,
+		     gssize len,
+		     GError **error)
+{
+	_cleanup_error_free_ GError *error_local = NULL;
+
+	if (!g_markup_parse_context_parse (ctx, data, len, &error_local)) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     error_local->message);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+typedef struct {
+	z_stream	 zs;
+	gchar		*buf;
+	gboolean	 member_end;	/* the last gzip member was complete */
+} AsNodeInflate;
+
+/**
+ * as_node_inflate_init:
+ **/
+static gboolean
+as_node_inflate_init (AsNodeInflate *inflater, GError **error)
+{
+	inflater->buf = g_private_get (&as_node_inflate_buffer);
+	if (inflater->buf == NULL) {
+		inflater->buf = g_malloc (AS_NODE_INFLATE_BUFFER_SIZE);
+		g_private_set (&as_node_inflate_buffer, inflater->buf);
+	}
+	inflater->member_end = FALSE;
+
+	/* adding 16 to the window bits selects the gzip wrapper */
+	memset (&inflater->zs, 0, sizeof (inflater->zs));
+	if (inflateInit2 (&inflater->zs, 16 + MAX_WBITS) != Z_OK) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     "Failed to initialize decompressor");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * as_node_inflate_parse:
+ *
+ * Decompresses and parses the next block of compressed data, which does
+ * not have to end at a gzip member boundary. Each member that follows
+ * another is decompressed in turn, as they are when using gunzip.
+ **/
+static gboolean
+as_node_inflate_parse (AsNodeInflate *inflater,
+		       GMarkupParseContext *ctx,
+		       const gchar *data,
+		       gsize len,
+		       GCancellable *cancellable,
+		       GError **error)
+{
+	gint rc;
+	gsize produced;
+	z_stream *zs = &inflater->zs;
+
+	zs->next_in = (Bytef *) data;
+	zs->avail_in = len;
+	do {
+		/* there may be more than one gzip member */
+		if (inflater->member_end && zs->avail_in > 0) {
+			inflateReset (zs);
+			inflater->member_end = FALSE;
+		}
+		zs->next_out = (Bytef *) inflater->buf;
+		zs->avail_out = AS_NODE_INFLATE_BUFFER_SIZE;
+		rc = inflate (zs, Z_NO_FLUSH);
+		if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+			g_set_error (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     "Failed to decompress: %s",
+				     zs->msg != NULL ? zs->msg : "invalid data");
+			return FALSE;
+		}
+		if (rc == Z_STREAM_END)
+			inflater->member_end = TRUE;
+		produced = AS_NODE_INFLATE_BUFFER_SIZE - zs->avail_out;
+		if (produced > 0 &&
+		    !as_node_parse_chunk (ctx, inflater->buf, produced, error))
+			return FALSE;
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			return FALSE;
+
+		/* a full buffer may mean there is more output pending */
+	} while (zs->avail_in > 0 ||
+		 (produced == AS_NODE_INFLATE_BUFFER_SIZE && !inflater->member_end));
+	return TRUE;
+}
+
+/**
+ * as_node_inflate_end:
+ **/
+static gboolean
+as_node_inflate_end (AsNodeInflate *inflater, gboolean ret, GError **error)
+{
+	inflateEnd (&inflater->zs);
+	if (ret && !inflater->member_end) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     "Compressed data was truncated");
+		return FALSE;
+	}
+	return ret;
+}
+
+/**
+ * as_node_parse_inflate:
+ **/
+static gboolean
+as_node_parse_inflate (GMarkupParseContext *ctx,
+		       const gchar *data,
+		       gsize len,
+		       GCancellable *cancellable,
+		       GError **error)
+{
+	AsNodeInflate inflater;
+	gboolean ret;
+
+	if (!as_node_inflate_init (&inflater, error))
+		return FALSE;
+	ret = as_node_inflate_parse (&inflater, ctx, data, len,
+				     cancellable, error);
+	return as_node_inflate_end (&inflater, ret, error);
+}
+
+/**
+ * as_node_parse_mapped:
+ *
+ * Parses a local file without using the GIO stream classes.
+ **/
+static gboolean
+as_node_parse_mapped (GMarkupParseContext *ctx,
+		      const gchar *filename,
+		      AsNodeFileKind kind,
+		      GCancellable *cancellable,
+		      GError **error)
+{
+	const gchar *data;
+	gsize len;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_mapped_file_unref_ GMappedFile *mapped = NULL;
+
+	mapped = g_mapped_file_new (filename, FALSE, &error_local);
+	if (mapped == NULL) {
+		g_set_error (error,
+			     AS_NODE_ERROR,
+			     AS_NODE_ERROR_FAILED,
+			     "Failed to map %s: %s",
+			     filename, error_local->message);
+		return FALSE;
+	}
+	data = g_mapped_file_get_contents (mapped);
+	len = g_mapped_file_get_length (mapped);
+	if (kind == AS_NODE_FILE_KIND_GZIP)
+		return as_node_parse_inflate (ctx, data, len, cancellable, error);
+	if (len == 0)
+		return TRUE;
+	return as_node_parse_chunk (ctx, data, len, error);
+}
+
+/**
+ * as_node_parse_stream:
+ *
+ * Parses a file using GIO, for instance if it is not local. Compressed
+ * files are decompressed with zlib directly rather than with a
+ * #GZlibDecompressor, which stops after the first gzip member.
+ **/
+static gboolean
+as_node_parse_stream (GMarkupParseContext *ctx,
+		      GFile *file,
+		      GCancellable *cancellable,
+		      GError **error)
+{
+	AsNodeInflate inflater;
+	const gchar *content_type = NULL;
+	gboolean compressed;
+	gboolean ret = TRUE;
+	gsize chunk_size = 32 * 1024;
+	gssize len;
+	_cleanup_free_ gchar *data = NULL;
+	_cleanup_object_unref_ GFileInfo *info = NULL;
+	_cleanup_object_unref_ GInputStream *stream = NULL;
+
+	/* what kind of file is this */
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+				  G_FILE_QUERY_INFO_NONE,
+				  cancellable,
+				  error);
+	if (info == NULL)
+		return FALSE;
+	content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+	if (g_strcmp0 (content_type, "application/gzip") == 0 ||
+	    g_strcmp0 (content_type, "application/x-gzip") == 0) {
+		compressed = TRUE;
+	} else if (g_strcmp0 (content_type, "application/xml") == 0) {
+		compressed = FALSE;
 	} else {
-		data->cdata = as_node_reflow_text (text, text_len);
+		g_set_error (error,
+			     AS_NODE_ERROR,
+			     AS_NODE_ERROR_FAILED,
+			     "cannot process file of type %s",
+			     content_type);
+		return FALSE;
 	}
-}
-
-/**
- * as_node_passthrough_cb:
- **/
-static void
-as_node_passthrough_cb (GMarkupParseContext *context,
-			const gchar         *passthrough_text,
-			gsize                passthrough_len,
-			gpointer             user_data,
-			GError             **error)
-{
-	AsNodeToXmlHelper *helper = (AsNodeToXmlHelper *) user_data;
-	const gchar *tmp;
-	gchar *found;
-	_cleanup_free_ gchar *text = NULL;
-
-	/* only keep comments when told to */
-	if ((helper->flags & AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS) == 0)
-		return;
-
-	/* xml header */
-	if (g_strstr_len (passthrough_text, passthrough_len, "<?xml") != NULL)
-		return;
 
-	/* get stripped comment without '<!--' and '-->' */
-	text = g_strndup (passthrough_text, passthrough_len);
-	if (!g_str_has_prefix (text, "<!--")) {
-		g_warning ("Unexpected input: %s", text);
-		return;
+	stream = G_INPUT_STREAM (g_file_read (file, cancellable, error));
+	if (stream == NULL)
+		return FALSE;
+	if (compressed && !as_node_inflate_init (&inflater, error))
+		return FALSE;
+	data = g_malloc (chunk_size);
+	while ((len = g_input_stream_read (stream,
+					   data,
+					   chunk_size,
+					   cancellable,
+					   error)) > 0) {
+		if (compressed) {
+			ret = as_node_inflate_parse (&inflater, ctx, data, len,
+						     cancellable, error);
+		} else {
+			ret = as_node_parse_chunk (ctx, data, len, error);
+		}
+		if (!ret)
+			break;
 	}
-	found = g_strrstr (text, "-->");
-	if (found != NULL)
-		*found = '\0';
-	tmp = g_strstrip (text + 4);
-	if (tmp == NULL || tmp[0] == '\0')
-		return;
-	as_node_add_attribute (helper->current, "@comment-tmp", tmp, -1);
+	if (len < 0)
+		ret = FALSE;
+	if (compressed)
+		return as_node_inflate_end (&inflater, ret, error);
+	return ret;
 }
 
 /**
- * as_node_from_xml: (skip)
- * @data: XML data
- * @data_len: Length of @data, or -1 if NULL terminated
- * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
- * @error: A #GError or %NULL
- *
- * Parses XML data into a DOM tree.
- *
- * Returns: (transfer full): A populated #GNode tree
- *
- * Since: 0.1.0
+ * as_node_from_file_helper:
  **/
-GNode *
-as_node_from_xml (const gchar *data,
-		  gssize data_len,
-		  AsNodeFromXmlFlags flags,
-		  GError **error)
+static GNode *
+as_node_from_file_helper (GFile *file,
+			  AsNodeToXmlHelper *helper,
+			  GCancellable *cancellable,
+			  GError **error)
 {
-	AsNodeToXmlHelper helper;
+	AsNodeFileKind kind;
 	GNode *root = NULL;
 	gboolean ret;
-	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_free_ gchar *filename = NULL;
 	_cleanup_markup_parse_context_unref_ GMarkupParseContext *ctx = NULL;
 	const GMarkupParser parser = {
 		as_node_start_element_cb,
@@ -630,30 +1458,35 @@ as_node_from_xml (const gchar *data,
 		as_node_passthrough_cb,
 		NULL };
 
-	g_return_val_if_fail (data != NULL, FALSE);
-
+	/* parse */
 	root = g_node_new (NULL);
-	helper.flags = flags;
-	helper.current = root;
+	helper->current = root;
+	helper->arena = NULL;
+	if ((helper->flags & AS_NODE_FROM_XML_FLAG_ARENA) > 0) {
+		helper->arena = as_node_arena_new ();
+		as_node_arena_set_root (root, helper->arena);
+	}
 	ctx = g_markup_parse_context_new (&parser,
 					  G_MARKUP_PREFIX_ERROR_POSITION,
-					  &helper,
+					  helper,
 					  NULL);
-	ret = g_markup_parse_context_parse (ctx,
-					    data,
-					    data_len,
-					    &error_local);
+
+	/* only sniff the content type if the filename is not conclusive */
+	filename = g_file_get_path (file);
+	kind = as_node_file_kind_from_filename (filename);
+	if (kind != AS_NODE_FILE_KIND_UNKNOWN) {
+		ret = as_node_parse_mapped (ctx, filename, kind,
+					    cancellable, error);
+	} else {
+		ret = as_node_parse_stream (ctx, file, cancellable, error);
+	}
 	if (!ret) {
-		g_set_error_literal (error,
-				     AS_NODE_ERROR,
-				     AS_NODE_ERROR_FAILED,
-				     error_local->message);
 		as_node_unref (root);
 		return NULL;
 	}
 
 	/* more opening than closing */
-	if (root != helper.current) {
+	if (root != helper->current) {
 		g_set_error_literal (error,
 				     AS_NODE_ERROR,
 				     AS_NODE_ERROR_FAILED,
@@ -684,124 +1517,115 @@ as_node_from_file (GFile *file,
 		   GError **error)
 {
 	AsNodeToXmlHelper helper;
-	GError *error_local = NULL;
-	GNode *root = NULL;
-	const gchar *content_type = NULL;
-	gboolean ret = TRUE;
-	gsize chunk_size = 32 * 1024;
-	gssize len;
-	_cleanup_free_ gchar *data = NULL;
-	_cleanup_markup_parse_context_unref_ GMarkupParseContext *ctx = NULL;
-	_cleanup_object_unref_ GConverter *conv = NULL;
-	_cleanup_object_unref_ GFileInfo *info = NULL;
-	_cleanup_object_unref_ GInputStream *file_stream = NULL;
-	_cleanup_object_unref_ GInputStream *stream_data = NULL;
-	const GMarkupParser parser = {
-		as_node_start_element_cb,
-		as_node_end_element_cb,
-		as_node_text_cb,
-		as_node_passthrough_cb,
-		NULL };
-
-	/* what kind of file is this */
-	info = g_file_query_info (file,
-				  G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
-				  G_FILE_QUERY_INFO_NONE,
-				  cancellable,
-				  error);
-	if (info == NULL)
-		return NULL;
-
-	/* decompress if required */
-	file_stream = G_INPUT_STREAM (g_file_read (file, cancellable, error));
-	if (file_stream == NULL)
-		return NULL;
-	content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-	if (g_strcmp0 (content_type, "application/gzip") == 0 ||
-	    g_strcmp0 (content_type, "application/x-gzip") == 0) {
-		conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-		stream_data = g_converter_input_stream_new (file_stream, conv);
-	} else if (g_strcmp0 (content_type, "application/xml") == 0) {
-		stream_data = g_object_ref (file_stream);
-	} else {
-		g_set_error (error,
-			     AS_NODE_ERROR,
-			     AS_NODE_ERROR_FAILED,
-			     "cannot process file of type %s",
-			     content_type);
-		return NULL;
-	}
 
-	/* parse */
-	root = g_node_new (NULL);
 	helper.flags = flags;
-	helper.current = root;
-	ctx = g_markup_parse_context_new (&parser,
-					  G_MARKUP_PREFIX_ERROR_POSITION,
-					  &helper,
-					  NULL);
+	helper.subtree_func = NULL;
+	helper.subtree_data = NULL;
+	return as_node_from_file_helper (file, &helper, cancellable, error);
+}
 
-	data = g_malloc (chunk_size);
-	while ((len = g_input_stream_read (stream_data,
-					   data,
-					   chunk_size,
-					   cancellable,
-					   error)) > 0) {
-		ret = g_markup_parse_context_parse (ctx,
-						    data,
-						    len,
-						    &error_local);
-		if (!ret) {
-			g_set_error_literal (error,
-					     AS_NODE_ERROR,
-					     AS_NODE_ERROR_FAILED,
-					     error_local->message);
-			g_error_free (error_local);
-			as_node_unref (root);
-			return NULL;
-		}
-	}
-	if (len < 0) {
-		as_node_unref (root);
-		return NULL;
-	}
+/**
+ * as_node_from_file_streaming: (skip)
+ * @file: file
+ * @flags: #AsNodeFromXmlFlags, e.g. %AS_NODE_FROM_XML_FLAG_NONE
+ * @func: a #AsNodeSubtreeFunc to call for each component
+ * @user_data: user data for @func
+ * @cancellable: A #GCancellable, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Parses an XML file, calling @func as soon as each top-level
+ * <component> or <application> element has been closed. The subtree is
+ * destroyed as soon as @func returns, so only one component is ever held
+ * in memory at a time.
+ *
+ * If @func sets an error then parsing is aborted.
+ *
+ * Returns: (transfer full): The remaining #GNode tree without any components
+ *
+ * Since: 0.1.8
+ **/
+GNode *
+as_node_from_file_streaming (GFile *file,
+			     AsNodeFromXmlFlags flags,
+			     AsNodeSubtreeFunc func,
+			     gpointer user_data,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	AsNodeToXmlHelper helper;
 
-	/* more opening than closing */
-	if (root != helper.current) {
-		g_set_error_literal (error,
-				     AS_NODE_ERROR,
-				     AS_NODE_ERROR_FAILED,
-				     "Mismatched XML");
-		as_node_unref (root);
-		return NULL;
-	}
-	return root;
+	g_return_val_if_fail (func != NULL, NULL);
+
+	helper.flags = flags;
+	helper.subtree_func = func;
+	helper.subtree_data = user_data;
+	return as_node_from_file_helper (file, &helper, cancellable, error);
 }
 
 /**
- * as_node_get_child_node:
+ * as_node_get_child_node_full:
+ *
+ * Finds the first child with @tag, comparing @name only for unknown tags.
  **/
 static GNode *
-as_node_get_child_node (const GNode *root, const gchar *name)
+as_node_get_child_node_full (const GNode *root, AsTag tag, const gchar *name)
 {
 	AsNodeData *data;
 	GNode *node;
 
 	/* invalid */
-	if (name == NULL || name[0] == '\0')
+	if (tag == AS_TAG_UNKNOWN && (name == NULL || name[0] == '\0'))
 		return NULL;
 
-	/* find a node called name */
+	/* find a node with the tag */
 	for (node = root->children; node != NULL; node = node->next) {
 		data = node->data;
 		if (data == NULL)
 			return NULL;
-		if (g_strcmp0 (as_tag_data_get_name (data), name) == 0)
-			return node;
+		if (data->tag != tag)
+			continue;
+		if (tag == AS_TAG_UNKNOWN && g_strcmp0 (data->name, name) != 0)
+			continue;
+		return node;
 	}
 	return NULL;
 }
 
+/**
+ * as_node_path_free:
+ **/
+static void
+as_node_path_free (AsNodePathItem *items)
+{
+	guint i;
+	for (i = 0; items[i].tag != AS_TAG_LAST; i++)
+		g_free (items[i].name);
+	g_free (items);
+}
+
+/**
+ * as_node_path_compile:
+ *
+ * Splits a path and converts each section to a tag where possible.
+ **/
+static AsNodePathItem *
+as_node_path_compile (const gchar *path)
+{
+	AsNodePathItem *items;
+	guint i;
+	_cleanup_strv_free_ gchar **split = NULL;
+
+	split = g_strsplit (path, "/", -1);
+	items = g_new0 (AsNodePathItem, g_strv_length (split) + 1);
+	for (i = 0; split[i] != NULL; i++) {
+		items[i].tag = as_tag_from_string (split[i]);
+		if (items[i].tag == AS_TAG_UNKNOWN)
+			items[i].name = g_strdup (split[i]);
+	}
+	items[i].tag = AS_TAG_LAST;
+	return items;
+}
+
 /**
  * as_node_get_name:
  * @node: a #GNode
@@ -844,7 +1668,7 @@ as_node_set_name (GNode *node, const gchar *name)
 		return;
 
 	/* overwrite */
-	g_free (data->name);
+	as_node_data_free_string (data, data->name);
 	data->name = NULL;
 	as_node_data_set_name (data, name);
 }
@@ -945,8 +1769,8 @@ as_node_set_data (GNode *node,
 		return;
 
 	data = (AsNodeData *) node->data;
-	g_free (data->cdata);
-	data->cdata = as_strndup (cdata, cdata_len);
+	as_node_data_free_string (data, data->cdata);
+	data->cdata = as_node_data_strndup (data, cdata, cdata_len);
 	data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 }
 
@@ -989,7 +1813,7 @@ as_node_take_data (const GNode *node)
 	if (data->cdata == NULL || data->cdata[0] == '\0')
 		return NULL;
 	as_node_cdata_to_raw (data);
-	tmp = data->cdata;
+	tmp = as_node_data_steal_string (data, data->cdata);
 	data->cdata = NULL;
 	return tmp;
 }
@@ -1075,7 +1899,7 @@ as_node_take_attribute (const GNode *node, const gchar *key)
 	attr = as_node_attr_find (data, key);
 	if (attr == NULL)
 		return NULL;
-	tmp = attr->value;
+	tmp = as_node_data_steal_string (data, attr->value);
 	attr->value = NULL;
 	return tmp;
 }
@@ -1107,7 +1931,7 @@ as_node_add_attribute (GNode *node,
 		return;
 	data = (AsNodeData *) node->data;
 	attr = as_node_attr_insert (data, key, NULL);
-	attr->value = as_strndup (value, value_len);
+	attr->value = as_node_data_strndup (data, value, value_len);
 }
 
 /**
@@ -1124,21 +1948,60 @@ as_node_add_attribute (GNode *node,
 GNode *
 as_node_find (GNode *root, const gchar *path)
 {
+	AsNodePathItem *items;
+	AsNodePathItem *items_tmp = NULL;
+	GHashTable *paths;
 	GNode *node = root;
 	guint i;
-	_cleanup_strv_free_ gchar **split = NULL;
 
 	g_return_val_if_fail (path != NULL, NULL);
 
-	split = g_strsplit (path, "/", -1);
-	for (i = 0; split[i] != NULL; i++) {
-		node = as_node_get_child_node (node, split[i]);
+	/* paths are normally constants, so only compile each one once */
+	paths = g_private_get (&as_node_paths);
+	if (paths == NULL) {
+		paths = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free,
+					       (GDestroyNotify) as_node_path_free);
+		g_private_set (&as_node_paths, paths);
+	}
+	items = g_hash_table_lookup (paths, path);
+	if (items == NULL) {
+		items = as_node_path_compile (path);
+		if (g_hash_table_size (paths) < AS_NODE_PATH_CACHE_MAX)
+			g_hash_table_insert (paths, g_strdup (path), items);
+		else
+			items_tmp = items;
+	}
+
+	for (i = 0; items[i].tag != AS_TAG_LAST; i++) {
+		node = as_node_get_child_node_full (node, items[i].tag, items[i].name);
 		if (node == NULL)
-			return NULL;
+			break;
 	}
+	if (items_tmp != NULL)
+		as_node_path_free (items_tmp);
 	return node;
 }
 
+/**
+ * as_node_find_tag: (skip)
+ * @root: a root node
+ * @tag: a #AsTag, e.g. %AS_TAG_SCREENSHOTS
+ *
+ * Gets the first child node with a known tag without any string comparisons.
+ *
+ * Return value: A #GNode, or %NULL if not found
+ *
+ * Since: 0.1.8
+ **/
+GNode *
+as_node_find_tag (GNode *root, AsTag tag)
+{
+	g_return_val_if_fail (root != NULL, NULL);
+	g_return_val_if_fail (tag != AS_TAG_UNKNOWN, NULL);
+	return as_node_get_child_node_full (root, tag, NULL);
+}
+
 /**
  * as_node_insert: (skip)
  * @parent: a parent #GNode.
@@ -1166,10 +2029,10 @@ as_node_insert (GNode *parent,
 	guint i;
 	va_list args;
 
-	data = g_slice_new0 (AsNodeData);
+	data = as_node_data_new (as_node_get_arena (parent));
 	as_node_data_set_name (data, name);
 	if (cdata != NULL)
-		data->cdata = g_strdup (cdata);
+		data->cdata = as_node_data_strndup (data, cdata, -1);
 	data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 
 	/* process the attrs valist */
@@ -1185,7 +2048,7 @@ as_node_insert (GNode *parent,
 	}
 	va_end (args);
 
-	return g_node_insert_data (parent, -1, data);
+	return as_node_append_data (parent, data);
 }
 
 /**
@@ -1214,6 +2077,7 @@ as_node_insert_localized (GNode *parent,
 			  GHashTable *localized,
 			  AsNodeInsertFlags insert_flags)
 {
+	AsNodeArena *arena;
 	AsNodeData *data;
 	GList *l;
 	const gchar *key;
@@ -1225,16 +2089,18 @@ as_node_insert_localized (GNode *parent,
 	value_c = g_hash_table_lookup (localized, "C");
 	if (value_c == NULL)
 		return;
-	data = g_slice_new0 (AsNodeData);
+	arena = as_node_get_arena (parent);
+	data = as_node_data_new (arena);
 	as_node_data_set_name (data, name);
 	if (insert_flags & AS_NODE_INSERT_FLAG_NO_MARKUP) {
-		data->cdata = as_markup_convert_simple (value_c, -1, NULL);
+		data->cdata = as_node_data_adopt_string (data,
+							 as_markup_convert_simple (value_c, -1, NULL));
 		data->cdata_escaped = FALSE;
 	} else {
-		data->cdata = g_strdup (value_c);
+		data->cdata = as_node_data_strndup (data, value_c, -1);
 		data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 	}
-	g_node_insert_data (parent, -1, data);
+	as_node_append_data (parent, data);
 
 	/* add the other localized values */
 	list = g_hash_table_get_keys (localized);
@@ -1251,17 +2117,18 @@ as_node_insert_localized (GNode *parent,
 		if ((insert_flags & AS_NODE_INSERT_FLAG_DEDUPE_LANG) > 0 &&
 		    g_strcmp0 (value_c, value) == 0)
 			continue;
-		data = g_slice_new0 (AsNodeData);
+		data = as_node_data_new (arena);
 		as_node_attr_insert (data, "xml:lang", key);
 		as_node_data_set_name (data, name);
 		if (insert_flags & AS_NODE_INSERT_FLAG_NO_MARKUP) {
-			data->cdata = as_markup_convert_simple (value, -1, NULL);
+			data->cdata = as_node_data_adopt_string (data,
+								 as_markup_convert_simple (value, -1, NULL));
 			data->cdata_escaped = FALSE;
 		} else {
-			data->cdata = g_strdup (value);
+			data->cdata = as_node_data_strndup (data, value, -1);
 			data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 		}
-		g_node_insert_data (parent, -1, data);
+		as_node_append_data (parent, data);
 	}
 }
 
@@ -1284,6 +2151,7 @@ as_node_insert_hash (GNode *parent,
 		     GHashTable *hash,
 		     AsNodeInsertFlags insert_flags)
 {
+	AsNodeArena *arena;
 	AsNodeData *data;
 	GList *l;
 	GList *list;
@@ -1291,14 +2159,15 @@ as_node_insert_hash (GNode *parent,
 	const gchar *value;
 	gboolean swapped = (insert_flags & AS_NODE_INSERT_FLAG_SWAPPED) > 0;
 
+	arena = as_node_get_arena (parent);
 	list = g_hash_table_get_keys (hash);
 	list = g_list_sort (list, as_node_list_sort_cb);
 	for (l = list; l != NULL; l = l->next) {
 		key = l->data;
 		value = g_hash_table_lookup (hash, key);
-		data = g_slice_new0 (AsNodeData);
+		data = as_node_data_new (arena);
 		as_node_data_set_name (data, name);
-		data->cdata = g_strdup (!swapped ? value : key);
+		data->cdata = as_node_data_strndup (data, !swapped ? value : key, -1);
 		data->cdata_escaped = insert_flags & AS_NODE_INSERT_FLAG_PRE_ESCAPED;
 		if (!swapped) {
 			if (key != NULL && key[0] != '\0')
@@ -1307,24 +2176,16 @@ as_node_insert_hash (GNode *parent,
 			if (value != NULL && value[0] != '\0')
 				as_node_attr_insert (data, attr_key, value);
 		}
-		g_node_insert_data (parent, -1, data);
+		as_node_append_data (parent, data);
 	}
 	g_list_free (list);
 }
 
 /**
- * as_node_get_localized:
- * @node: a #GNode
- * @key: the key to use, e.g. "copyright"
- *
- * Extracts localized values from the DOM tree
- *
- * Return value: (transfer full): A hash table with the locale (e.g. en_GB) as the key
- *
- * Since: 0.1.0
+ * as_node_get_localized_full:
  **/
-GHashTable *
-as_node_get_localized (const GNode *node, const gchar *key)
+static GHashTable *
+as_node_get_localized_full (const GNode *node, AsTag tag, const gchar *name)
 {
 	AsNodeData *data;
 	const gchar *xml_lang;
@@ -1334,12 +2195,12 @@ as_node_get_localized (const GNode *node, const gchar *key)
 	GNode *tmp;
 
 	/* does it exist? */
-	tmp = as_node_get_child_node (node, key);
+	tmp = as_node_get_child_node_full (node, tag, name);
 	if (tmp == NULL)
 		return NULL;
 	data_unlocalized = as_node_get_data (tmp);
 
-	/* find a node called name */
+	/* find a node with the tag */
 	hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	for (tmp = node->children; tmp != NULL; tmp = tmp->next) {
 		data = tmp->data;
@@ -1347,7 +2208,9 @@ as_node_get_localized (const GNode *node, const gchar *key)
 			continue;
 		if (data->cdata == NULL)
 			continue;
-		if (g_strcmp0 (as_tag_data_get_name (data), key) != 0)
+		if (data->tag != tag)
+			continue;
+		if (tag == AS_TAG_UNKNOWN && g_strcmp0 (data->name, name) != 0)
 			continue;
 		xml_lang = as_node_attr_lookup (data, "xml:lang");
 
@@ -1362,6 +2225,44 @@ as_node_get_localized (const GNode *node, const gchar *key)
 	return hash;
 }
 
+/**
+ * as_node_get_localized:
+ * @node: a #GNode
+ * @key: the key to use, e.g. "copyright"
+ *
+ * Extracts localized values from the DOM tree
+ *
+ * Return value: (transfer full): A hash table with the locale (e.g. en_GB) as the key
+ *
+ * Since: 0.1.0
+ **/
+GHashTable *
+as_node_get_localized (const GNode *node, const gchar *key)
+{
+	if (key == NULL)
+		return NULL;
+	return as_node_get_localized_full (node, as_tag_from_string (key), key);
+}
+
+/**
+ * as_node_get_localized_by_tag: (skip)
+ * @node: a #GNode
+ * @tag: a #AsTag, e.g. %AS_TAG_CAPTION
+ *
+ * Extracts localized values from the DOM tree for a known tag, without
+ * comparing the element names.
+ *
+ * Return value: (transfer full): A hash table with the locale (e.g. en_GB) as the key
+ *
+ * Since: 0.1.8
+ **/
+GHashTable *
+as_node_get_localized_by_tag (const GNode *node, AsTag tag)
+{
+	g_return_val_if_fail (tag != AS_TAG_UNKNOWN, NULL);
+	return as_node_get_localized_full (node, tag, NULL);
+}
+
 /**
  * as_node_get_localized_best:
  * @node: a #GNode.
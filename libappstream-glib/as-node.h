@@ -59,6 +59,7 @@ typedef enum {
  * @AS_NODE_FROM_XML_FLAG_NONE:			No extra flags to use
  * @AS_NODE_FROM_XML_FLAG_LITERAL_TEXT:		Treat the text as an exact string
  * @AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS:	Retain comments in the XML file
+ * @AS_NODE_FROM_XML_FLAG_ARENA:		Allocate the whole tree from one arena
  *
  * The flags for converting from XML.
  **/
@@ -66,6 +67,7 @@ typedef enum {
 	AS_NODE_FROM_XML_FLAG_NONE		= 0,	/* Since: 0.1.0 */
 	AS_NODE_FROM_XML_FLAG_LITERAL_TEXT	= 1,	/* Since: 0.1.3 */
 	AS_NODE_FROM_XML_FLAG_KEEP_COMMENTS	= 2,	/* Since: 0.1.6 */
+	AS_NODE_FROM_XML_FLAG_ARENA		= 4,	/* Since: 0.1.8 */
 	/*< private >*/
 	AS_NODE_FROM_XML_FLAG_LAST
 } AsNodeFromXmlFlags;
@@ -116,6 +118,8 @@ const gchar	*as_node_get_attribute		(const GNode	*node,
 						 const gchar	*key);
 GHashTable	*as_node_get_localized		(const GNode	*node,
 						 const gchar	*key);
+GHashTable	*as_node_get_localized_by_tag	(const GNode	*node,
+						 AsTag		 tag);
 const gchar	*as_node_get_localized_best	(const GNode	*node,
 						 const gchar	*key);
 GHashTable	*as_node_get_localized_unwrap	(const GNode	*node,
@@ -137,6 +141,9 @@ GNode		*as_node_from_file		(GFile		*file,
 GNode		*as_node_find			(GNode		*root,
 						 const gchar	*path)
 						 G_GNUC_WARN_UNUSED_RESULT;
+GNode		*as_node_find_tag		(GNode		*root,
+						 AsTag		 tag)
+						 G_GNUC_WARN_UNUSED_RESULT;
 
 GNode		*as_node_insert			(GNode		*parent,
 						 const gchar	*name,
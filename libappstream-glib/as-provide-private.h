@@ -30,12 +30,17 @@
 
 G_BEGIN_DECLS
 
+#define AS_PROVIDE_VARIANT_TYPE	"(ums)"
+
 GNode		*as_provide_node_insert		(AsProvide	*provide,
 						 GNode		*parent,
 						 gdouble	 api_version);
 gboolean	 as_provide_node_parse		(AsProvide	*provide,
 						 GNode		*node,
 						 GError		**error);
+GVariant	*as_provide_to_variant		(AsProvide	*provide);
+void		 as_provide_from_variant	(AsProvide	*provide,
+						 GVariant	*value);
 
 G_END_DECLS
 
@@ -260,6 +260,45 @@ as_provide_node_parse (AsProvide *provide, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_provide_to_variant: (skip)
+ * @provide: a #AsProvide instance.
+ *
+ * Serializes the provide into a #GVariant of type %AS_PROVIDE_VARIANT_TYPE.
+ *
+ * Returns: (transfer full): a floating #GVariant
+ *
+ * Since: 0.1.8
+ **/
+GVariant *
+as_provide_to_variant (AsProvide *provide)
+{
+	AsProvidePrivate *priv = GET_PRIVATE (provide);
+	return g_variant_new (AS_PROVIDE_VARIANT_TYPE,
+			      (guint32) priv->kind,
+			      priv->value);
+}
+
+/**
+ * as_provide_from_variant: (skip)
+ * @provide: a #AsProvide instance.
+ * @value: a #GVariant of type %AS_PROVIDE_VARIANT_TYPE.
+ *
+ * Populates the object from a variant created by as_provide_to_variant().
+ *
+ * Since: 0.1.8
+ **/
+void
+as_provide_from_variant (AsProvide *provide, GVariant *value)
+{
+	AsProvidePrivate *priv = GET_PRIVATE (provide);
+	guint32 kind;
+
+	g_free (priv->value);
+	g_variant_get (value, AS_PROVIDE_VARIANT_TYPE, &kind, &priv->value);
+	priv->kind = kind;
+}
+
 /**
  * as_provide_new:
  *
@@ -30,12 +30,17 @@
 
 G_BEGIN_DECLS
 
+#define AS_RELEASE_VARIANT_TYPE	"(msta{ss})"
+
 GNode		*as_release_node_insert		(AsRelease	*release,
 						 GNode		*parent,
 						 gdouble	 api_version);
 gboolean	 as_release_node_parse		(AsRelease	*release,
 						 GNode		*node,
 						 GError		**error);
+GVariant	*as_release_to_variant		(AsRelease	*release);
+void		 as_release_from_variant	(AsRelease	*release,
+						 GVariant	*value);
 
 G_END_DECLS
 
@@ -287,6 +287,68 @@ as_release_node_parse (AsRelease *release, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_release_to_variant: (skip)
+ * @release: a #AsRelease instance.
+ *
+ * Serializes the release, including the descriptions, into a #GVariant of
+ * type %AS_RELEASE_VARIANT_TYPE.
+ *
+ * Returns: (transfer full): a floating #GVariant
+ *
+ * Since: 0.1.8
+ **/
+GVariant *
+as_release_to_variant (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key;
+	gpointer value;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (AS_RELEASE_VARIANT_TYPE));
+	g_variant_builder_add (&builder, "ms", priv->version);
+	g_variant_builder_add (&builder, "t", priv->timestamp);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{ss}"));
+	if (priv->descriptions != NULL) {
+		g_hash_table_iter_init (&iter, priv->descriptions);
+		while (g_hash_table_iter_next (&iter, &key, &value))
+			g_variant_builder_add (&builder, "{ss}", key, value);
+	}
+	g_variant_builder_close (&builder);
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * as_release_from_variant: (skip)
+ * @release: a #AsRelease instance.
+ * @value: a #GVariant of type %AS_RELEASE_VARIANT_TYPE.
+ *
+ * Populates the object from a variant created by as_release_to_variant().
+ *
+ * Since: 0.1.8
+ **/
+void
+as_release_from_variant (AsRelease *release, GVariant *value)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	GVariantIter iter;
+	const gchar *description;
+	const gchar *locale;
+	_cleanup_variant_unref_ GVariant *descriptions = NULL;
+
+	g_free (priv->version);
+	g_variant_get_child (value, 0, "ms", &priv->version);
+	g_variant_get_child (value, 1, "t", &priv->timestamp);
+
+	/* descriptions are translated and optional */
+	descriptions = g_variant_get_child_value (value, 2);
+	g_variant_iter_init (&iter, descriptions);
+	while (g_variant_iter_next (&iter, "{&s&s}", &locale, &description))
+		as_release_set_description (release, locale, description, -1);
+}
+
 /**
  * as_release_new:
  *
@@ -28,16 +28,22 @@
 
 #include <glib-object.h>
 
+#include "as-image-private.h"
 #include "as-screenshot.h"
 
 G_BEGIN_DECLS
 
+#define AS_SCREENSHOT_VARIANT_TYPE	"(ua{ss}a" AS_IMAGE_VARIANT_TYPE ")"
+
 GNode		*as_screenshot_node_insert	(AsScreenshot	*screenshot,
 						 GNode		*parent,
 						 gdouble	 api_version);
 gboolean	 as_screenshot_node_parse	(AsScreenshot	*screenshot,
 						 GNode		*node,
 						 GError		**error);
+GVariant	*as_screenshot_to_variant	(AsScreenshot	*screenshot);
+void		 as_screenshot_from_variant	(AsScreenshot	*screenshot,
+						 GVariant	*value);
 
 G_END_DECLS
 
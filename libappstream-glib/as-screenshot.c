@@ -337,7 +337,7 @@ as_screenshot_node_parse (AsScreenshot *screenshot, GNode *node, GError **error)
 	}
 
 	/* add captions */
-	captions = as_node_get_localized (node, "caption");
+	captions = as_node_get_localized_by_tag (node, AS_TAG_CAPTION);
 	if (captions != NULL) {
 		_cleanup_list_free_ GList *keys;
 		keys = g_hash_table_get_keys (captions);
@@ -379,6 +379,85 @@ as_screenshot_node_parse (AsScreenshot *screenshot, GNode *node, GError **error)
 	return TRUE;
 }
 
+/**
+ * as_screenshot_to_variant: (skip)
+ * @screenshot: a #AsScreenshot instance.
+ *
+ * Serializes the screenshot, including the captions and images, into a
+ * #GVariant of type %AS_SCREENSHOT_VARIANT_TYPE.
+ *
+ * Returns: (transfer full): a floating #GVariant
+ *
+ * Since: 0.1.8
+ **/
+GVariant *
+as_screenshot_to_variant (AsScreenshot *screenshot)
+{
+	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	GHashTableIter iter;
+	GVariantBuilder builder;
+	gpointer key;
+	gpointer value;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (AS_SCREENSHOT_VARIANT_TYPE));
+	g_variant_builder_add (&builder, "u", (guint32) priv->kind);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{ss}"));
+	g_hash_table_iter_init (&iter, priv->captions);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_variant_builder_add (&builder, "{ss}", key, value);
+	g_variant_builder_close (&builder);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a" AS_IMAGE_VARIANT_TYPE));
+	for (i = 0; i < priv->images->len; i++) {
+		g_variant_builder_add_value (&builder,
+					     as_image_to_variant (g_ptr_array_index (priv->images, i)));
+	}
+	g_variant_builder_close (&builder);
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * as_screenshot_from_variant: (skip)
+ * @screenshot: a #AsScreenshot instance.
+ * @value: a #GVariant of type %AS_SCREENSHOT_VARIANT_TYPE.
+ *
+ * Populates the object from a variant created by as_screenshot_to_variant().
+ *
+ * Since: 0.1.8
+ **/
+void
+as_screenshot_from_variant (AsScreenshot *screenshot, GVariant *value)
+{
+	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	GVariantIter iter;
+	GVariant *child;
+	const gchar *caption;
+	const gchar *locale;
+	guint32 kind;
+	_cleanup_variant_unref_ GVariant *captions = NULL;
+	_cleanup_variant_unref_ GVariant *images = NULL;
+
+	g_variant_get_child (value, 0, "u", &kind);
+	priv->kind = kind;
+
+	/* captions */
+	captions = g_variant_get_child_value (value, 1);
+	g_variant_iter_init (&iter, captions);
+	while (g_variant_iter_next (&iter, "{&s&s}", &locale, &caption))
+		as_screenshot_set_caption (screenshot, locale, caption, -1);
+
+	/* images */
+	images = g_variant_get_child_value (value, 2);
+	g_variant_iter_init (&iter, images);
+	while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+		AsImage *image;
+		image = as_image_new ();
+		as_image_from_variant (image, child);
+		g_ptr_array_add (priv->images, image);
+		g_variant_unref (child);
+	}
+}
+
 /**
  * as_screenshot_new:
  *
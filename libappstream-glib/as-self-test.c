@@ -21,8 +21,12 @@
 
 #include "config.h"
 
+#include <gdk-pixbuf/gdk-pixbuf.h>
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <libsoup/soup.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "as-app-private.h"
 #include "as-cleanup.h"
@@ -54,6 +58,29 @@ as_test_get_filename (const gchar *filename)
 	return g_strdup (full_tmp);
 }
 
+/**
+ * as_test_rmtree:
+ **/
+static void
+as_test_rmtree (const gchar *directory)
+{
+	const gchar *filename;
+	_cleanup_dir_close_ GDir *dir = NULL;
+
+	dir = g_dir_open (directory, 0, NULL);
+	if (dir == NULL)
+		return;
+	while ((filename = g_dir_read_name (dir)) != NULL) {
+		_cleanup_free_ gchar *path = NULL;
+		path = g_build_filename (directory, filename, NULL);
+		if (g_file_test (path, G_FILE_TEST_IS_DIR))
+			as_test_rmtree (path);
+		else
+			g_unlink (path);
+	}
+	g_rmdir (directory);
+}
+
 static void
 ch_test_tag_func (void)
 {
@@ -365,6 +392,8 @@ ch_test_app_func (void)
 		"</metadata>"
 		"</component>";
 	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_object_unref_ AsApp *app2 = NULL;
+	_cleanup_variant_unref_ GVariant *value = NULL;
 
 	app = as_app_new ();
 
@@ -408,6 +437,19 @@ ch_test_app_func (void)
 	g_string_free (xml, TRUE);
 	as_node_unref (root);
 
+	/* round trip through a variant */
+	value = g_variant_ref_sink (as_app_to_variant (app));
+	app2 = as_app_new ();
+	ret = as_app_from_variant (app2, value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	root = as_node_new ();
+	n = as_app_node_insert (app2, root, 0.7);
+	xml = as_node_to_xml (n, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml->str, ==, src);
+	g_string_free (xml, TRUE);
+	as_node_unref (root);
+
 	/* test contact demunging */
 	as_app_set_update_contact (app, "richard_at_hughsie_dot_co_dot_uk", -1);
 	g_assert_cmpstr (as_app_get_update_contact (app), ==, "richard@hughsie.co.uk");
@@ -536,6 +578,240 @@ ch_test_app_validate_metainfo_good_func (void)
 	g_ptr_array_unref (probs);
 }
 
+static void
+ch_test_app_validate_batch_func (void)
+{
+	AsProblem *problem;
+	AsProblem *problem_batch;
+	GError *error = NULL;
+	GPtrArray *probs_batch;
+	const gchar *filenames[] = { "success.appdata.xml",
+				     "broken.appdata.xml",
+				     "example.metainfo.xml",
+				     "success.appdata.xml",
+				     NULL };
+	gboolean ret;
+	guint i;
+	guint j;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *errors = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *results = NULL;
+
+	/* load some good and bad files */
+	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; filenames[i] != NULL; i++) {
+		AsApp *app;
+		_cleanup_free_ gchar *filename = NULL;
+		filename = as_test_get_filename (filenames[i]);
+		app = as_app_new ();
+		ret = as_app_parse_file (app, filename, AS_APP_PARSE_FLAG_NONE, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_ptr_array_add (apps, app);
+	}
+
+	/* the results are in order and match validating each in turn */
+	results = as_app_validate_batch (apps, AS_APP_VALIDATE_FLAG_NO_NETWORK,
+					 &errors, &error);
+	g_assert_no_error (error);
+	g_assert (results != NULL);
+	g_assert_cmpint (results->len, ==, apps->len);
+	g_assert_cmpint (errors->len, ==, apps->len);
+	for (i = 0; i < apps->len; i++) {
+		g_assert (g_ptr_array_index (errors, i) == NULL);
+	}
+	for (i = 0; i < apps->len; i++) {
+		_cleanup_ptrarray_unref_ GPtrArray *probs = NULL;
+		probs = as_app_validate (g_ptr_array_index (apps, i),
+					 AS_APP_VALIDATE_FLAG_NO_NETWORK, &error);
+		g_assert_no_error (error);
+		g_assert (probs != NULL);
+		probs_batch = g_ptr_array_index (results, i);
+		g_assert_cmpint (probs_batch->len, ==, probs->len);
+		for (j = 0; j < probs->len; j++) {
+			problem = g_ptr_array_index (probs, j);
+			problem_batch = g_ptr_array_index (probs_batch, j);
+			g_assert_cmpint (as_problem_get_kind (problem_batch), ==,
+					 as_problem_get_kind (problem));
+			g_assert_cmpstr (as_problem_get_message (problem_batch), ==,
+					 as_problem_get_message (problem));
+		}
+	}
+	probs_batch = g_ptr_array_index (results, 1);
+	g_assert_cmpint (probs_batch->len, >, 0);
+}
+
+typedef struct {
+	GMainContext		*context;
+	GMainLoop		*loop;
+	gchar			*data;
+	gsize			 len;
+	gint			 count_ok;
+	gint			 count_not_modified;
+	gint			 count_not_found;
+} AsTestServer;
+
+static void
+as_test_server_cb (SoupServer *server, SoupMessage *msg, const char *path,
+		   GHashTable *query, SoupClientContext *client, gpointer user_data)
+{
+	AsTestServer *ts = (AsTestServer *) user_data;
+	const gchar *etag;
+
+	if (!g_str_has_prefix (path, "/screenshot-")) {
+		g_atomic_int_inc (&ts->count_not_found);
+		soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+		return;
+	}
+	etag = soup_message_headers_get_one (msg->request_headers, "If-None-Match");
+	if (g_strcmp0 (etag, "\"as-test\"") == 0) {
+		g_atomic_int_inc (&ts->count_not_modified);
+		soup_message_set_status (msg, SOUP_STATUS_NOT_MODIFIED);
+		return;
+	}
+	g_atomic_int_inc (&ts->count_ok);
+	soup_message_headers_append (msg->response_headers, "ETag", "\"as-test\"");
+	soup_message_set_response (msg, "image/png", SOUP_MEMORY_COPY, ts->data, ts->len);
+	soup_message_set_status (msg, SOUP_STATUS_OK);
+}
+
+static gpointer
+as_test_server_thread_cb (gpointer user_data)
+{
+	AsTestServer *ts = (AsTestServer *) user_data;
+	g_main_context_push_thread_default (ts->context);
+	g_main_loop_run (ts->loop);
+	g_main_context_pop_thread_default (ts->context);
+	return NULL;
+}
+
+static void
+ch_test_app_validate_screenshots_func (void)
+{
+	AsProblem *problem;
+	AsTestServer ts;
+	GError *error = NULL;
+	GThread *thread;
+	gboolean ret;
+	guint i;
+	guint j;
+	const gchar *paths[] = { "screenshot", "missing", NULL };
+	_cleanup_free_ gchar *cache_data = NULL;
+	_cleanup_free_ gchar *cache_fn = NULL;
+	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_object_unref_ AsScreenshot *ss = NULL;
+	_cleanup_object_unref_ GdkPixbuf *pixbuf = NULL;
+	_cleanup_object_unref_ SoupServer *server = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *errors = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *results = NULL;
+
+	/* serve a screenshot from a local server */
+	memset (&ts, 0, sizeof (ts));
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 624, 351);
+	gdk_pixbuf_fill (pixbuf, 0x336699ff);
+	ret = gdk_pixbuf_save_to_buffer (pixbuf, &ts.data, &ts.len, "png", &error, NULL);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ts.context = g_main_context_new ();
+	ts.loop = g_main_loop_new (ts.context, FALSE);
+	server = soup_server_new (SOUP_SERVER_PORT, SOUP_ADDRESS_ANY_PORT,
+				  SOUP_SERVER_ASYNC_CONTEXT, ts.context,
+				  NULL);
+	g_assert (server != NULL);
+	soup_server_add_handler (server, NULL, as_test_server_cb, &ts, NULL);
+	soup_server_run_async (server);
+	thread = g_thread_new ("as-test-server", as_test_server_thread_cb, &ts);
+
+	/* add a default screenshot with two sizes */
+	app = as_app_new ();
+	as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
+	ss = as_screenshot_new ();
+	as_screenshot_set_kind (ss, AS_SCREENSHOT_KIND_DEFAULT);
+	for (i = 0; paths[i] != NULL; i++) {
+		_cleanup_free_ gchar *url = NULL;
+		_cleanup_object_unref_ AsImage *im = NULL;
+		url = g_strdup_printf ("http://127.0.0.1:%u/%s-1.png",
+				       soup_server_get_port (server),
+				       paths[i]);
+		im = as_image_new ();
+		as_image_set_url (im, url, -1);
+		as_screenshot_add_image (ss, im);
+	}
+	as_app_add_screenshot (app, ss);
+
+	/* check all the URLs at the same time, and then again using the
+	 * results saved from the first run */
+	for (i = 0; i < 2; i++) {
+		guint cnt_not_found = 0;
+		_cleanup_ptrarray_unref_ GPtrArray *probs = NULL;
+		probs = as_app_validate (app,
+					 AS_APP_VALIDATE_FLAG_PARALLEL |
+					 AS_APP_VALIDATE_FLAG_USE_CACHE,
+					 &error);
+		g_assert_no_error (error);
+		g_assert (probs != NULL);
+		for (j = 0; j < probs->len; j++) {
+			problem = g_ptr_array_index (probs, j);
+			g_assert_cmpstr (as_problem_get_message (problem), !=,
+					 "<screenshot> failed to load image");
+			if (g_strcmp0 (as_problem_get_message (problem),
+				       "<screenshot> url not found") == 0)
+				cnt_not_found++;
+		}
+		g_assert_cmpint (cnt_not_found, ==, 1);
+	}
+	g_assert_cmpint (ts.count_ok, ==, 1);
+	g_assert_cmpint (ts.count_not_modified, ==, 1);
+
+	/* the results are saved in the temporary cache, without the URLs */
+	cache_fn = g_build_filename (g_get_user_cache_dir (),
+				     "appstream-glib",
+				     "validate-urls.cache",
+				     NULL);
+	g_assert (g_str_has_prefix (cache_fn, g_getenv ("XDG_CACHE_HOME")));
+	ret = g_file_get_contents (cache_fn, &cache_data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (strstr (cache_data, "Checked=") != NULL);
+	g_assert (strstr (cache_data, "127.0.0.1") == NULL);
+
+	/* applications validated in one batch share the downloads, even
+	 * without the saved results */
+	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < 8; i++)
+		g_ptr_array_add (apps, g_object_ref (app));
+	ts.count_ok = 0;
+	ts.count_not_modified = 0;
+	ts.count_not_found = 0;
+	results = as_app_validate_batch (apps, AS_APP_VALIDATE_FLAG_PARALLEL,
+					 &errors, &error);
+	g_assert_no_error (error);
+	g_assert (results != NULL);
+	for (i = 0; i < apps->len; i++) {
+		GPtrArray *probs = g_ptr_array_index (results, i);
+		guint cnt_not_found = 0;
+		g_assert (g_ptr_array_index (errors, i) == NULL);
+		for (j = 0; j < probs->len; j++) {
+			problem = g_ptr_array_index (probs, j);
+			if (g_strcmp0 (as_problem_get_message (problem),
+				       "<screenshot> url not found") == 0)
+				cnt_not_found++;
+		}
+		g_assert_cmpint (cnt_not_found, ==, 1);
+	}
+	g_assert_cmpint (ts.count_ok, ==, 1);
+	g_assert_cmpint (ts.count_not_modified, ==, 0);
+	g_assert_cmpint (ts.count_not_found, ==, 1);
+
+	soup_server_quit (server);
+	g_main_loop_quit (ts.loop);
+	g_thread_join (thread);
+	g_main_loop_unref (ts.loop);
+	g_main_context_unref (ts.context);
+	g_free (ts.data);
+}
+
 static void
 ch_test_app_validate_intltool_func (void)
 {
@@ -600,7 +876,9 @@ ch_test_app_validate_file_bad_func (void)
 	guint i;
 	_cleanup_free_ gchar *filename = NULL;
 	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_object_unref_ AsApp *app2 = NULL;
 	_cleanup_ptrarray_unref_ GPtrArray *probs = NULL;
+	_cleanup_variant_unref_ GVariant *value = NULL;
 
 	/* open file */
 	app = as_app_new ();
@@ -609,6 +887,15 @@ ch_test_app_validate_file_bad_func (void)
 	g_assert_no_error (error);
 	g_assert (ret);
 
+	/* the problems found when parsing survive a round trip */
+	value = g_variant_ref_sink (as_app_to_variant (app));
+	app2 = as_app_new ();
+	ret = as_app_from_variant (app2, value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_app_get_problems (app), !=, 0);
+	g_assert_cmpint (as_app_get_problems (app2), ==, as_app_get_problems (app));
+
 	g_assert_cmpstr (as_app_get_description (app, "C"), !=, NULL);
 	g_assert_cmpint (as_app_get_description_size (app), ==, 1);
 
@@ -782,6 +1069,7 @@ ch_test_app_no_markup_func (void)
 		"<description>Software is awesome:\n\n * Bada\n * Boom!</description>"
 		"</application>";
 	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_object_unref_ AsApp *app_legacy = NULL;
 
 	app = as_app_new ();
 
@@ -810,6 +1098,21 @@ ch_test_app_no_markup_func (void)
 	g_assert_cmpstr (xml->str, ==, src);
 	g_string_free (xml, TRUE);
 	as_node_unref (root);
+
+	/* only <component> has the priority and type attributes */
+	root = as_node_from_xml ("<application type=\"font\" priority=\"5\">"
+				 "<id type=\"desktop\">a.desktop</id>"
+				 "</application>", -1,
+				 AS_NODE_FROM_XML_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	app_legacy = as_app_new ();
+	ret = as_app_node_parse (app_legacy, root->children, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_app_get_priority (app_legacy), ==, 0);
+	g_assert_cmpint (as_app_get_id_kind (app_legacy), ==, AS_ID_KIND_DESKTOP);
+	as_node_unref (root);
 }
 
 static void
@@ -841,6 +1144,21 @@ ch_test_node_reflow_text_func (void)
 		"  Okay!\n", -1);
 	g_assert_cmpstr (tmp, ==, "Dave: Software is awesome.\n\nOkay!");
 	g_free (tmp);
+
+	/* only the given length is used */
+	tmp = as_node_reflow_text ("Dave\n  Software\n\nignored", 15);
+	g_assert_cmpstr (tmp, ==, "Dave Software");
+	g_free (tmp);
+
+	/* carriage returns and tabs are whitespace */
+	tmp = as_node_reflow_text ("\tDave\r\n\t\r\n\tSoftware\r\n", -1);
+	g_assert_cmpstr (tmp, ==, "Dave\n\nSoftware");
+	g_free (tmp);
+
+	/* all whitespace */
+	tmp = as_node_reflow_text (" \n\t\n ", -1);
+	g_assert_cmpstr (tmp, ==, "");
+	g_free (tmp);
 }
 
 static void
@@ -1162,6 +1480,157 @@ ch_test_app_subsume_func (void)
 	g_assert_cmpstr (as_app_get_metadata_item (donor, "recipient"), ==, "true");
 }
 
+static void
+ch_test_app_display_info_func (void)
+{
+	AsAppDisplayInfo *info;
+	_cleanup_array_unref_ GArray *infos = NULL;
+	_cleanup_array_unref_ GArray *infos_locale = NULL;
+	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_object_unref_ AsApp *donor = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+
+	/* the best name follows the changes */
+	app = as_app_new ();
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, NULL);
+	as_app_set_name (app, NULL, "One", -1);
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "One");
+	as_app_set_name (app, NULL, "Two", -1);
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "Two");
+	as_app_set_name (app, "xx_XX", "Deux", -1);
+	g_assert_cmpstr (as_app_get_name (app, "xx_XX"), ==, "Deux");
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "Two");
+
+	/* and values copied from another application */
+	g_assert_cmpstr (as_app_get_comment (app, NULL), ==, NULL);
+	donor = as_app_new ();
+	as_app_set_comment (donor, NULL, "Summary", -1);
+	as_app_set_icon (donor, "gtk-find", -1);
+	as_app_subsume (app, donor);
+	g_assert_cmpstr (as_app_get_comment (app, NULL), ==, "Summary");
+	as_app_set_comment (app, NULL, "Better summary", -1);
+	g_assert_cmpstr (as_app_get_comment (app, NULL), ==, "Better summary");
+	g_assert_cmpstr (as_app_get_description (app, NULL), ==, NULL);
+	as_app_set_description (app, NULL, "<p>Old</p>", -1);
+	g_assert_cmpstr (as_app_get_description (app, NULL), ==, "<p>Old</p>");
+	as_app_set_description (app, NULL, "<p>New</p>", -1);
+	g_assert_cmpstr (as_app_get_description (app, NULL), ==, "<p>New</p>");
+
+	/* resolve several at once */
+	apps = g_ptr_array_new ();
+	g_ptr_array_add (apps, app);
+	g_ptr_array_add (apps, donor);
+	infos = as_app_resolve_display_info (apps, NULL);
+	g_assert_cmpint (infos->len, ==, 2);
+	info = &g_array_index (infos, AsAppDisplayInfo, 0);
+	g_assert (info->app == app);
+	g_assert_cmpstr (info->name, ==, "Two");
+	g_assert_cmpstr (info->comment, ==, "Better summary");
+	g_assert_cmpstr (info->icon, ==, "gtk-find");
+	info = &g_array_index (infos, AsAppDisplayInfo, 1);
+	g_assert (info->app == donor);
+	g_assert_cmpstr (info->name, ==, NULL);
+	g_assert_cmpstr (info->comment, ==, "Summary");
+
+	/* or for a specific locale */
+	infos_locale = as_app_resolve_display_info (apps, "xx_XX");
+	info = &g_array_index (infos_locale, AsAppDisplayInfo, 0);
+	g_assert_cmpstr (info->name, ==, "Deux");
+	g_assert_cmpstr (info->comment, ==, NULL);
+}
+
+static void
+ch_test_app_lazy_func (void)
+{
+	GError *error = NULL;
+	GNode *n;
+	GNode *root;
+	gboolean ret;
+	const gchar *src =
+		"<component type=\"desktop\">"
+		"<id>gnome-software.desktop</id>"
+		"<name>Software</name>"
+		"<description><p>Software allows you to find stuff</p></description>"
+		"<screenshots>"
+		"<screenshot type=\"default\">"
+		"<image type=\"source\">http://a.png</image>"
+		"</screenshot>"
+		"</screenshots>"
+		"<releases>"
+		"<release version=\"3.11.90\" timestamp=\"1392724800\"/>"
+		"</releases>"
+		"<languages>"
+		"<lang percentage=\"90\">en_GB</lang>"
+		"</languages>"
+		"</component>";
+	_cleanup_object_unref_ AsApp *app = NULL;
+	_cleanup_object_unref_ AsApp *app2 = NULL;
+	_cleanup_variant_unref_ GVariant *value = NULL;
+
+	/* the deferred elements have to outlive the tree */
+	root = as_node_from_xml (src, -1, 0, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	n = as_node_find (root, "component");
+	g_assert (n != NULL);
+	app = as_app_new ();
+	ret = as_app_node_parse_lazy (app, n, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	as_node_unref (root);
+
+	/* cheap properties do not need the deferred data */
+	g_assert_cmpstr (as_app_get_id_full (app), ==, "gnome-software.desktop");
+	g_assert_cmpstr (as_app_get_name (app, NULL), ==, "Software");
+
+	/* parsed on first access */
+	g_assert_cmpstr (as_app_get_description (app, NULL), ==,
+			 "<p>Software allows you to find stuff</p>");
+	g_assert_cmpint (as_app_get_screenshots(app)->len, ==, 1);
+	g_assert_cmpint (as_app_get_releases(app)->len, ==, 1);
+	g_assert_cmpint (as_app_get_language (app, "en_GB"), ==, 90);
+
+	/* and from a variant */
+	value = g_variant_ref_sink (as_app_to_variant (app));
+	app2 = as_app_new ();
+	ret = as_app_from_variant_lazy (app2, value, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpstr (as_app_get_id_full (app2), ==, "gnome-software.desktop");
+	g_assert_cmpint (as_app_get_screenshots(app2)->len, ==, 1);
+	g_assert_cmpint (as_app_get_releases(app2)->len, ==, 1);
+	g_assert_cmpint (as_app_get_language (app2, "en_GB"), ==, 90);
+	g_assert_cmpstr (as_app_get_description (app2, NULL), ==,
+			 "<p>Software allows you to find stuff</p>");
+}
+
+static void
+ch_test_app_intern_func (void)
+{
+	guint hits1 = 0;
+	guint hits2 = 0;
+	gsize saved1 = 0;
+	gsize saved2 = 0;
+	_cleanup_object_unref_ AsApp *app1 = NULL;
+	_cleanup_object_unref_ AsApp *app2 = NULL;
+
+	app1 = as_app_new ();
+	as_app_add_category (app1, "AudioVideo", -1);
+	as_app_set_name (app1, "en_GB", "Colour", -1);
+
+	/* the second copy of each string is shared */
+	as_utils_get_intern_stats (NULL, &hits1, &saved1);
+	app2 = as_app_new ();
+	as_app_add_category (app2, "AudioVideo", -1);
+	as_app_set_name (app2, "en_GB", "Color", -1);
+	as_utils_get_intern_stats (NULL, &hits2, &saved2);
+	g_assert_cmpint (hits2, >=, hits1 + 2);
+	g_assert_cmpint (saved2, >=, saved1 + strlen ("AudioVideo") + strlen ("en_GB") + 2);
+	g_assert (g_ptr_array_index (as_app_get_categories (app1), 0) ==
+		  g_ptr_array_index (as_app_get_categories (app2), 0));
+	g_assert_cmpstr (as_app_get_name (app2, "en_GB"), ==, "Color");
+}
+
 static void
 ch_test_app_search_func (void)
 {
@@ -1451,102 +1920,538 @@ ch_test_store_origin_func (void)
 }
 
 static void
-ch_test_store_speed_func (void)
+ch_test_node_streaming_cb (GNode *node, gpointer user_data, GError **error)
+{
+	guint *cnt = (guint *) user_data;
+	g_assert_cmpstr (as_node_get_name (node), ==, "application");
+	g_assert_cmpstr (as_node_get_attribute (node->parent, "origin"), ==, "fedora-21");
+	g_assert_cmpstr (as_node_get_data (as_node_find (node, "id")), ==, "test.desktop");
+	(*cnt)++;
+}
+
+static void
+ch_test_node_streaming_func (void)
 {
 	GError *error = NULL;
-	gboolean ret;
-	guint i;
-	guint loops = 10;
+	GNode *apps;
+	guint cnt = 0;
 	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
 	_cleanup_object_unref_ GFile *file = NULL;
-	_cleanup_timer_destroy_ GTimer *timer = NULL;
 
-	filename = as_test_get_filename ("example-v04.xml.gz");
+	/* each component is handed over and then discarded */
+	filename = as_test_get_filename ("origin.xml");
 	file = g_file_new_for_path (filename);
-	timer = g_timer_new ();
-	for (i = 0; i < loops; i++) {
-		_cleanup_object_unref_ AsStore *store;
-		store = as_store_new ();
-		ret = as_store_from_file (store, file, NULL, NULL, &error);
+	root = as_node_from_file_streaming (file,
+					    AS_NODE_FROM_XML_FLAG_NONE,
+					    ch_test_node_streaming_cb,
+					    &cnt,
+					    NULL,
+					    &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	g_assert_cmpint (cnt, ==, 1);
+	apps = as_node_find (root, "applications");
+	g_assert (apps != NULL);
+	g_assert (apps->children == NULL);
+}
+
+static void
+ch_test_node_attributes_func (void)
+{
+	const gchar *xml_src = "<a one=\"1\" two=\"2\" three=\"3\" four=\"4\" five=\"5\"/>";
+	AsNodeFromXmlFlags flags[] = { AS_NODE_FROM_XML_FLAG_NONE,
+				       AS_NODE_FROM_XML_FLAG_ARENA };
+	GError *error = NULL;
+	GNode *n;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (flags); i++) {
+		_cleanup_free_ gchar *tmp = NULL;
+		_cleanup_node_unref_ GNode *root = NULL;
+		_cleanup_string_free_ GString *xml = NULL;
+
+		/* more attributes than fit inline */
+		root = as_node_from_xml (xml_src, -1, flags[i], &error);
 		g_assert_no_error (error);
-		g_assert (ret);
-		g_assert_cmpint (as_store_get_apps (store)->len, >=, 1415);
-		g_assert (as_store_get_app_by_id (store, "org.gnome.Software.desktop") != NULL);
-		g_assert (as_store_get_app_by_pkgname (store, "gnome-software") != NULL);
+		g_assert (root != NULL);
+		n = as_node_find (root, "a");
+		g_assert (n != NULL);
+		g_assert_cmpstr (as_node_get_attribute (n, "one"), ==, "1");
+		g_assert_cmpstr (as_node_get_attribute (n, "five"), ==, "5");
+		g_assert_cmpstr (as_node_get_attribute (n, "six"), ==, NULL);
+
+		/* the newest value wins */
+		as_node_add_attribute (n, "one", "uno", -1);
+		g_assert_cmpstr (as_node_get_attribute (n, "one"), ==, "uno");
+
+		/* the output order is unchanged */
+		xml = as_node_to_xml (root, AS_NODE_TO_XML_FLAG_NONE);
+		g_assert_cmpstr (xml->str, ==,
+			"<a one=\"uno\" five=\"5\" four=\"4\" "
+			"three=\"3\" two=\"2\" one=\"1\"/>");
+
+		/* taking the value leaves the key */
+		tmp = as_node_take_attribute (n, "one");
+		g_assert_cmpstr (tmp, ==, "uno");
+		g_assert_cmpstr (as_node_get_attribute (n, "one"), ==, NULL);
 	}
-	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
 }
 
 static void
-ch_test_utils_spdx_token_func (void)
+ch_test_node_attributes_many_func (void)
 {
-	gchar **tok;
-	gchar *tmp;
-
-	/* simple */
-	tok = as_utils_spdx_license_tokenize ("GPL");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "GPL");
-	g_strfreev (tok);
-	g_free (tmp);
+	AsNodeFromXmlFlags flags[] = { AS_NODE_FROM_XML_FLAG_NONE,
+				       AS_NODE_FROM_XML_FLAG_ARENA };
+	GError *error = NULL;
+	GNode *n;
+	GString *xml_src;
+	guint i;
 
-	/* empty */
-	tok = as_utils_spdx_license_tokenize ("");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "");
-	g_strfreev (tok);
-	g_free (tmp);
+	/* more than fit in a 16 bit count */
+	xml_src = g_string_new ("<a");
+	for (i = 0; i < 70000; i++)
+		g_string_append_printf (xml_src, " k%u=\"%u\"", i, i);
+	g_string_append (xml_src, "/>");
 
-	/* multiple licences */
-	tok = as_utils_spdx_license_tokenize ("GPL and MPL and CDL");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "GPL|# and |MPL|# and |CDL");
-	g_strfreev (tok);
-	g_free (tmp);
+	for (i = 0; i < G_N_ELEMENTS (flags); i++) {
+		_cleanup_node_unref_ GNode *root = NULL;
+		root = as_node_from_xml (xml_src->str, -1, flags[i], &error);
+		g_assert_no_error (error);
+		g_assert (root != NULL);
+		n = as_node_find (root, "a");
+		g_assert (n != NULL);
+		g_assert_cmpstr (as_node_get_attribute (n, "k0"), ==, "0");
+		g_assert_cmpstr (as_node_get_attribute (n, "k32768"), ==, "32768");
+		g_assert_cmpstr (as_node_get_attribute (n, "k69999"), ==, "69999");
+	}
+	g_string_free (xml_src, TRUE);
+}
 
-	/* multiple licences */
-	tok = as_utils_spdx_license_tokenize ("GPL and MPL or BSD and MPL");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "GPL|# and |MPL|# or |BSD|# and |MPL");
-	g_strfreev (tok);
-	g_free (tmp);
+static void
+ch_test_node_find_tag_func (void)
+{
+	const gchar *xml =
+		"<components>"
+		"<component>"
+		"<id>a.desktop</id>"
+		"<foo><bar>baz</bar></foo>"
+		"<screenshots>"
+		"<screenshot>"
+		"<caption>Hello</caption>"
+		"<caption xml:lang=\"fr\">Bonjour</caption>"
+		"</screenshot>"
+		"</screenshots>"
+		"</component>"
+		"</components>";
+	GError *error = NULL;
+	GNode *n;
+	guint i;
+	_cleanup_hashtable_unref_ GHashTable *hash = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
 
-	/* brackets */
-	tok = as_utils_spdx_license_tokenize ("LGPLv2+ and (QPL or GPLv2) and MIT");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "LGPLv2+|# and (|QPL|# or |GPLv2|#) and |MIT");
-	g_strfreev (tok);
-	g_free (tmp);
+	root = as_node_from_xml (xml, -1, AS_NODE_FROM_XML_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
 
-	/* leading brackets */
-	tok = as_utils_spdx_license_tokenize ("(MPLv1.1 or LGPLv3+) and LGPLv3");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "#(|MPLv1.1|# or |LGPLv3+|#) and |LGPLv3");
-	g_strfreev (tok);
-	g_free (tmp);
+	/* find known tags */
+	n = as_node_find_tag (root, AS_TAG_APPLICATIONS);
+	g_assert (n != NULL);
+	n = as_node_find_tag (n, AS_TAG_APPLICATION);
+	g_assert (n != NULL);
+	g_assert (as_node_find_tag (n, AS_TAG_ICON) == NULL);
+	g_assert_cmpstr (as_node_get_data (as_node_find_tag (n, AS_TAG_ID)), ==, "a.desktop");
+
+	/* compiled paths give the same results each time */
+	for (i = 0; i < 2; i++) {
+		n = as_node_find (root, "components/component/foo/bar");
+		g_assert (n != NULL);
+		g_assert_cmpstr (as_node_get_data (n), ==, "baz");
+		g_assert (as_node_find (root, "components/component/foo/baz") == NULL);
+		g_assert (as_node_find (root, "components//component") == NULL);
+	}
 
-	/*  trailing brackets */
-	tok = as_utils_spdx_license_tokenize ("MPLv1.1 and (LGPLv3 or GPLv3)");
-	tmp = g_strjoinv ("|", tok);
-	g_assert_cmpstr (tmp, ==, "MPLv1.1|# and (|LGPLv3|# or |GPLv3|#)");
-	g_strfreev (tok);
-	g_free (tmp);
+	/* localized values by tag */
+	n = as_node_find (root, "components/component/screenshots/screenshot");
+	g_assert (n != NULL);
+	hash = as_node_get_localized_by_tag (n, AS_TAG_CAPTION);
+	g_assert (hash != NULL);
+	g_assert_cmpint (g_hash_table_size (hash), ==, 2);
+	g_assert_cmpstr (g_hash_table_lookup (hash, "C"), ==, "Hello");
+	g_assert_cmpstr (g_hash_table_lookup (hash, "fr"), ==, "Bonjour");
+	g_assert (as_node_get_localized_by_tag (n, AS_TAG_NAME) == NULL);
 }
 
 static void
-ch_test_utils_func (void)
+ch_test_node_gzip_func (void)
 {
-	gboolean ret;
-	gchar *tmp;
 	GError *error = NULL;
+	gboolean ret;
+	gsize len;
+	_cleanup_free_ gchar *data = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *filename_sniff = NULL;
+	_cleanup_free_ gchar *filename_trunc = NULL;
+	_cleanup_node_unref_ GNode *root1 = NULL;
+	_cleanup_node_unref_ GNode *root2 = NULL;
+	_cleanup_node_unref_ GNode *root3 = NULL;
+	_cleanup_object_unref_ GFile *file1 = NULL;
+	_cleanup_object_unref_ GFile *file2 = NULL;
+	_cleanup_object_unref_ GFile *file3 = NULL;
+	_cleanup_string_free_ GString *xml1 = NULL;
+	_cleanup_string_free_ GString *xml2 = NULL;
+
+	/* decompressed directly from the mapped file */
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file1 = g_file_new_for_path (filename);
+	root1 = as_node_from_file (file1, AS_NODE_FROM_XML_FLAG_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (root1 != NULL);
 
-	/* as_strndup */
-	tmp = as_strndup ("dave", 2);
-	g_assert_cmpstr (tmp, ==, "da");
-	g_free (tmp);
-	tmp = as_strndup ("dave", 4);
-	g_assert_cmpstr (tmp, ==, "dave");
-	g_free (tmp);
+	/* the same data without a useful suffix has to be sniffed */
+	ret = g_file_get_contents (filename, &data, &len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	filename_sniff = g_build_filename (g_get_tmp_dir (), "as-self-test-gzip", NULL);
+	ret = g_file_set_contents (filename_sniff, data, len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file2 = g_file_new_for_path (filename_sniff);
+	root2 = as_node_from_file (file2, AS_NODE_FROM_XML_FLAG_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (root2 != NULL);
+	xml1 = as_node_to_xml (root1, AS_NODE_TO_XML_FLAG_NONE);
+	xml2 = as_node_to_xml (root2, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml1->str, ==, xml2->str);
+	g_unlink (filename_sniff);
+
+	/* truncated data is an error */
+	filename_trunc = g_build_filename (g_get_tmp_dir (), "as-self-test-trunc.xml.gz", NULL);
+	ret = g_file_set_contents (filename_trunc, data, len / 2, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file3 = g_file_new_for_path (filename_trunc);
+	root3 = as_node_from_file (file3, AS_NODE_FROM_XML_FLAG_NONE, NULL, &error);
+	g_assert_error (error, AS_NODE_ERROR, AS_NODE_ERROR_FAILED);
+	g_assert (root3 == NULL);
+	g_clear_error (&error);
+	g_unlink (filename_trunc);
+}
+
+/**
+ * as_test_gzip_append:
+ *
+ * Appends @data to @buf as a complete gzip member.
+ **/
+static void
+as_test_gzip_append (GString *buf, const gchar *data)
+{
+	GError *error = NULL;
+	gboolean ret;
+	_cleanup_object_unref_ GConverter *conv = NULL;
+	_cleanup_object_unref_ GOutputStream *out = NULL;
+	_cleanup_object_unref_ GOutputStream *stream = NULL;
+
+	out = g_memory_output_stream_new_resizable ();
+	conv = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+	stream = g_converter_output_stream_new (out, conv);
+	ret = g_output_stream_write_all (stream, data, strlen (data),
+					 NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = g_output_stream_close (stream, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_string_append_len (buf,
+			     g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out)),
+			     g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out)));
+}
+
+static void
+ch_test_node_gzip_members_func (void)
+{
+	GError *error = NULL;
+	GNode *n;
+	gboolean ret;
+	guint i;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *filename_sniff = NULL;
+	_cleanup_node_unref_ GNode *root1 = NULL;
+	_cleanup_node_unref_ GNode *root2 = NULL;
+	_cleanup_object_unref_ GFile *file1 = NULL;
+	_cleanup_object_unref_ GFile *file2 = NULL;
+	_cleanup_string_free_ GString *buf = NULL;
+
+	/* one document split across several gzip members */
+	buf = g_string_new ("");
+	as_test_gzip_append (buf, "<components><component><id>a</id></component>");
+	as_test_gzip_append (buf, "<component><id>b</id>");
+	as_test_gzip_append (buf, "</component></components>");
+
+	/* from the mapped file */
+	filename = g_build_filename (g_get_tmp_dir (), "as-self-test-members.xml.gz", NULL);
+	ret = g_file_set_contents (filename, buf->str, buf->len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file1 = g_file_new_for_path (filename);
+	root1 = as_node_from_file (file1, AS_NODE_FROM_XML_FLAG_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (root1 != NULL);
+	g_unlink (filename);
+
+	/* from the GInputStream, as the file has to be sniffed */
+	filename_sniff = g_build_filename (g_get_tmp_dir (), "as-self-test-members", NULL);
+	ret = g_file_set_contents (filename_sniff, buf->str, buf->len, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file2 = g_file_new_for_path (filename_sniff);
+	root2 = as_node_from_file (file2, AS_NODE_FROM_XML_FLAG_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (root2 != NULL);
+	g_unlink (filename_sniff);
+
+	/* both components were parsed */
+	for (i = 0; i < 2; i++) {
+		n = as_node_find (i == 0 ? root1 : root2, "components");
+		g_assert (n != NULL);
+		g_assert_cmpint (g_node_n_children (n), ==, 2);
+		g_assert_cmpstr (as_node_get_data (as_node_find (n->children->next, "id")), ==, "b");
+	}
+}
+
+static void
+ch_test_node_arena_func (void)
+{
+	GError *error = NULL;
+	GNode *n;
+	GNode *root;
+	GString *xml;
+	gchar *tmp;
+	const gchar *src =
+		"<components origin=\"fedora\">"
+		"<component type=\"desktop\">"
+		"<id>gnome-software.desktop</id>"
+		"<name xml:lang=\"en_GB\">Software</name>"
+		"<unknown>Dave &amp; Jane</unknown>"
+		"</component>"
+		"</components>";
+
+	/* parse into the arena */
+	root = as_node_from_xml (src, -1, AS_NODE_FROM_XML_FLAG_ARENA, &error);
+	g_assert_no_error (error);
+	g_assert (root != NULL);
+	n = as_node_find (root, "components/component/unknown");
+	g_assert (n != NULL);
+	g_assert_cmpstr (as_node_get_name (n), ==, "unknown");
+	g_assert_cmpstr (as_node_get_data (n), ==, "Dave & Jane");
+
+	/* taken strings are owned by the caller */
+	n = as_node_find (root, "components/component/name");
+	tmp = as_node_take_attribute (n, "xml:lang");
+	g_assert_cmpstr (tmp, ==, "en_GB");
+	g_free (tmp);
+	tmp = as_node_take_data (n);
+	g_assert_cmpstr (tmp, ==, "Software");
+	g_free (tmp);
+
+	/* the tree can still be modified */
+	n = as_node_find (root, "components/component");
+	as_node_insert (n, "pkgname", "gnome-software", 0, NULL);
+	n = as_node_find (root, "components/component/id");
+	as_node_set_data (n, "gedit.desktop", -1, 0);
+	as_node_add_attribute (n, "type", "desktop", -1);
+	n = as_node_find (root, "components/component/name");
+	as_node_unref (n);
+	xml = as_node_to_xml (root, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml->str, ==,
+		"<components origin=\"fedora\">"
+		"<component type=\"desktop\">"
+		"<id type=\"desktop\">gedit.desktop</id>"
+		"<unknown>Dave &amp; Jane</unknown>"
+		"<pkgname>gnome-software</pkgname>"
+		"</component>"
+		"</components>");
+	g_string_free (xml, TRUE);
+	as_node_unref (root);
+}
+
+static void
+ch_test_store_speed_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	guint loops = 10;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_timer_destroy_ GTimer *timer = NULL;
+
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	file = g_file_new_for_path (filename);
+	timer = g_timer_new ();
+	for (i = 0; i < loops; i++) {
+		_cleanup_object_unref_ AsStore *store;
+		store = as_store_new ();
+		ret = as_store_from_file (store, file, NULL, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+		g_assert_cmpint (as_store_get_apps (store)->len, >=, 1415);
+		g_assert (as_store_get_app_by_id (store, "org.gnome.Software.desktop") != NULL);
+		g_assert (as_store_get_app_by_pkgname (store, "gnome-software") != NULL);
+	}
+	g_print ("%.0f ms: ", g_timer_elapsed (timer, NULL) * 1000 / loops);
+}
+
+static void
+ch_test_utils_spdx_token_func (void)
+{
+	gchar **tok;
+	gchar *tmp;
+
+	/* simple */
+	tok = as_utils_spdx_license_tokenize ("GPL");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "GPL");
+	g_strfreev (tok);
+	g_free (tmp);
+
+	/* empty */
+	tok = as_utils_spdx_license_tokenize ("");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "");
+	g_strfreev (tok);
+	g_free (tmp);
+
+	/* multiple licences */
+	tok = as_utils_spdx_license_tokenize ("GPL and MPL and CDL");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "GPL|# and |MPL|# and |CDL");
+	g_strfreev (tok);
+	g_free (tmp);
+
+	/* multiple licences */
+	tok = as_utils_spdx_license_tokenize ("GPL and MPL or BSD and MPL");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "GPL|# and |MPL|# or |BSD|# and |MPL");
+	g_strfreev (tok);
+	g_free (tmp);
+
+	/* brackets */
+	tok = as_utils_spdx_license_tokenize ("LGPLv2+ and (QPL or GPLv2) and MIT");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "LGPLv2+|# and (|QPL|# or |GPLv2|#) and |MIT");
+	g_strfreev (tok);
+	g_free (tmp);
+
+	/* leading brackets */
+	tok = as_utils_spdx_license_tokenize ("(MPLv1.1 or LGPLv3+) and LGPLv3");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "#(|MPLv1.1|# or |LGPLv3+|#) and |LGPLv3");
+	g_strfreev (tok);
+	g_free (tmp);
+
+	/*  trailing brackets */
+	tok = as_utils_spdx_license_tokenize ("MPLv1.1 and (LGPLv3 or GPLv3)");
+	tmp = g_strjoinv ("|", tok);
+	g_assert_cmpstr (tmp, ==, "MPLv1.1|# and (|LGPLv3|# or |GPLv3|#)");
+	g_strfreev (tok);
+	g_free (tmp);
+}
+
+static void
+ch_test_utils_spdx_parse_func (void)
+{
+	AsSpdxExpression *expr;
+	const AsSpdxNode *node;
+	GError *error = NULL;
+	const gchar *license = "MIT or GPL-2.0+ and LGPL-2.1";
+	guint i;
+	struct {
+		const gchar	*license;
+		const gchar	*normalized;
+	} valid[] = {
+		{ "GPL-2.0+",			"GPL-2.0+" },
+		{ "GPL-2.0+ and GFDL-1.3",	"GPL-2.0+ AND GFDL-1.3" },
+		{ "  MIT  OR  ((BSD-2-Clause))",	"MIT OR BSD-2-Clause" },
+		{ "LGPL-2.0+ and (QPL-1.0 or GPL-2.0) and MIT",
+		  "LGPL-2.0+ AND (QPL-1.0 OR GPL-2.0) AND MIT" },
+		{ "MIT or (GPL-2.0 and LGPL-2.1)", "MIT OR GPL-2.0 AND LGPL-2.1" },
+		{ "GPL-2.0 WITH Classpath-exception-2.0 or MIT",
+		  "GPL-2.0 WITH Classpath-exception-2.0 OR MIT" },
+		{ NULL, NULL } };
+	const gchar *invalid[] = { "", "(MIT", "MIT)", "MIT and", "and MIT",
+				   "MIT GPL-2.0", "(MIT) WITH X", "CC1",
+				   "GPL-2.0 WITH Foo-exception", NULL };
+	_cleanup_string_free_ GString *many = NULL;
+
+	/* AND binds more tightly than OR */
+	expr = as_utils_spdx_parse (license, AS_SPDX_PARSE_FLAG_NONE, &error);
+	g_assert_no_error (error);
+	g_assert (expr != NULL);
+	g_assert_cmpint (as_utils_spdx_expression_get_size (expr), ==, 5);
+	node = as_utils_spdx_expression_get_node (expr, as_utils_spdx_expression_get_root (expr));
+	g_assert_cmpint (node->kind, ==, AS_SPDX_NODE_KIND_OR);
+	g_assert_cmpint (as_utils_spdx_expression_get_node (expr, node->left)->kind, ==, AS_SPDX_NODE_KIND_LICENSE);
+	node = as_utils_spdx_expression_get_node (expr, node->right);
+	g_assert_cmpint (node->kind, ==, AS_SPDX_NODE_KIND_AND);
+	node = as_utils_spdx_expression_get_node (expr, node->left);
+	g_assert_cmpint (node->kind, ==, AS_SPDX_NODE_KIND_LICENSE);
+	g_assert_cmpint (node->id_len, ==, 7);
+	g_assert (strncmp (node->id, "GPL-2.0", node->id_len) == 0);
+	g_assert (node->id == license + 7);
+	g_assert (node->or_later);
+	g_assert (as_utils_spdx_expression_get_node (expr, 5) == NULL);
+	as_utils_spdx_expression_free (expr);
+
+	/* normalize */
+	for (i = 0; valid[i].license != NULL; i++) {
+		_cleanup_free_ gchar *tmp = NULL;
+		expr = as_utils_spdx_parse (valid[i].license,
+					    AS_SPDX_PARSE_FLAG_VALIDATE,
+					    &error);
+		g_assert_no_error (error);
+		g_assert (expr != NULL);
+		tmp = as_utils_spdx_to_string (expr);
+		g_assert_cmpstr (tmp, ==, valid[i].normalized);
+		as_utils_spdx_expression_free (expr);
+	}
+
+	/* no limit on the number of licenses */
+	many = g_string_new ("");
+	for (i = 0; i < 100; i++)
+		g_string_append (many, "MIT OR ");
+	g_string_append (many, "GPL-2.0");
+	expr = as_utils_spdx_parse (many->str, AS_SPDX_PARSE_FLAG_VALIDATE, &error);
+	g_assert_no_error (error);
+	g_assert (expr != NULL);
+	g_assert_cmpint (as_utils_spdx_expression_get_size (expr), ==, 201);
+	as_utils_spdx_expression_free (expr);
+
+	/* errors */
+	for (i = 0; invalid[i] != NULL; i++) {
+		expr = as_utils_spdx_parse (invalid[i],
+					    AS_SPDX_PARSE_FLAG_VALIDATE,
+					    &error);
+		g_assert_error (error, AS_NODE_ERROR, AS_NODE_ERROR_FAILED);
+		g_assert (expr == NULL);
+		g_clear_error (&error);
+	}
+}
+
+static void
+ch_test_utils_func (void)
+{
+	gboolean ret;
+	gchar *tmp;
+	GError *error = NULL;
+
+	/* as_strndup */
+	tmp = as_strndup ("dave", 2);
+	g_assert_cmpstr (tmp, ==, "da");
+	g_free (tmp);
+	tmp = as_strndup ("dave", 4);
+	g_assert_cmpstr (tmp, ==, "dave");
+	g_free (tmp);
 	tmp = as_strndup ("dave", -1);
 	g_assert_cmpstr (tmp, ==, "dave");
 	g_free (tmp);
@@ -1559,6 +2464,14 @@ ch_test_utils_func (void)
 	g_assert (as_utils_is_stock_icon_name ("insert-image"));
 	g_assert (as_utils_is_stock_icon_name ("zoom-out"));
 
+	/* as_utils_is_spdx_license_id */
+	g_assert (!as_utils_is_spdx_license_id (NULL));
+	g_assert (!as_utils_is_spdx_license_id (""));
+	g_assert (!as_utils_is_spdx_license_id ("GPL"));
+	g_assert (!as_utils_is_spdx_license_id ("CC-BY-SA-3.0 AND MIT"));
+	g_assert (as_utils_is_spdx_license_id ("CC-BY-SA-3.0"));
+	g_assert (as_utils_is_spdx_license_id ("GPL-2.0+"));
+
 	/* valid description markup */
 	tmp = as_markup_convert_simple ("<p>Hello world!</p>", -1, &error);
 	g_assert_no_error (error);
@@ -1616,6 +2529,676 @@ ch_test_store_app_install_func (void)
 	g_assert (ret);
 }
 
+static void
+ch_test_store_search_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	guint score;
+	guint score_last = G_MAXUINT;
+	const gchar *all[] = { "gnome", "install", "software", NULL };
+	const gchar *none[] = { "gnome", "xxx", "software", NULL };
+	const gchar *soft[] = { "soft", NULL };
+	const gchar *xml =
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\">"
+		"<id>gnome-software.desktop</id>"
+		"<name>GNOME Software</name>"
+		"<summary>Install and remove software</summary>"
+		"<mimetypes><mimetype>application/x-rpm</mimetype></mimetypes>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>software-center.desktop</id>"
+		"<name>Software Center</name>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>gedit.desktop</id>"
+		"<name>Editor</name>"
+		"<keywords><keyword>soft</keyword></keywords>"
+		"</component>"
+		"</components>";
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps1 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps2 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps3 = NULL;
+
+	store = as_store_new ();
+	ret = as_store_from_xml (store, xml, -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* all terms have to match */
+	apps1 = as_store_search (store, (gchar **) all);
+	g_assert_cmpint (apps1->len, ==, 1);
+	app = g_ptr_array_index (apps1, 0);
+	g_assert_cmpstr (as_app_get_id (app), ==, "gnome-software.desktop");
+	apps2 = as_store_search (store, (gchar **) none);
+	g_assert_cmpint (apps2->len, ==, 0);
+
+	/* the scores are the same as a linear search, best first */
+	apps3 = as_store_search (store, (gchar **) soft);
+	g_assert_cmpint (apps3->len, ==, 3);
+	for (i = 0; i < apps3->len; i++) {
+		app = g_ptr_array_index (apps3, i);
+		score = as_app_search_matches_all (app, (gchar **) soft);
+		g_assert_cmpint (score, >, 0);
+		g_assert_cmpint (score, <=, score_last);
+		score_last = score;
+	}
+	app = g_ptr_array_index (apps3, 2);
+	g_assert_cmpstr (as_app_get_id (app), ==, "gedit.desktop");
+}
+
+static void
+ch_test_store_search_fuzzy_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	const gchar *both[] = { "gnome", "sofware", NULL };
+	const gchar *editor[] = { "editr", NULL };
+	const gchar *none[] = { "xxxxxx", NULL };
+	const gchar *redaktor[] = { "рэдактяр", NULL };
+	const gchar *sofware[] = { "sofware", NULL };
+	const gchar *xml =
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\">"
+		"<id>gnome-software.desktop</id>"
+		"<name>GNOME Software</name>"
+		"<summary>Install and remove software</summary>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>software-center.desktop</id>"
+		"<name>Software Center</name>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>gedit.desktop</id>"
+		"<name>Editor</name>"
+		"<keywords><keyword>sofware</keyword></keywords>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>kolourpaint.desktop</id>"
+		"<name>Редактор</name>"
+		"</component>"
+		"</components>";
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps1 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps2 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps3 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps4 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps5 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps6 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps7 = NULL;
+
+	store = as_store_new ();
+	ret = as_store_from_xml (store, xml, -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* only the keyword is spelled this way */
+	apps1 = as_store_search (store, (gchar **) sofware);
+	g_assert_cmpint (apps1->len, ==, 1);
+
+	/* the IDs and names are close enough */
+	apps2 = as_store_search_full (store, (gchar **) sofware,
+				      AS_STORE_SEARCH_FLAG_FUZZY);
+	g_assert_cmpint (apps2->len, ==, 3);
+
+	/* all terms still have to match */
+	apps3 = as_store_search_full (store, (gchar **) both,
+				      AS_STORE_SEARCH_FLAG_FUZZY);
+	g_assert_cmpint (apps3->len, ==, 1);
+	app = g_ptr_array_index (apps3, 0);
+	g_assert_cmpstr (as_app_get_id (app), ==, "gnome-software.desktop");
+	apps4 = as_store_search_full (store, (gchar **) editor,
+				      AS_STORE_SEARCH_FLAG_FUZZY);
+	g_assert_cmpint (apps4->len, ==, 1);
+	apps5 = as_store_search_full (store, (gchar **) none,
+				      AS_STORE_SEARCH_FLAG_FUZZY);
+	g_assert_cmpint (apps5->len, ==, 0);
+
+	/* two edits that each change every byte of a character */
+	apps6 = as_store_search (store, (gchar **) redaktor);
+	g_assert_cmpint (apps6->len, ==, 0);
+	apps7 = as_store_search_full (store, (gchar **) redaktor,
+				      AS_STORE_SEARCH_FLAG_FUZZY);
+	g_assert_cmpint (apps7->len, ==, 1);
+	app = g_ptr_array_index (apps7, 0);
+	g_assert_cmpstr (as_app_get_id_full (app), ==, "kolourpaint.desktop");
+}
+
+static void
+ch_test_store_load_parallel_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	guint j;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_object_unref_ AsStore *store1 = NULL;
+	_cleanup_object_unref_ AsStore *store2 = NULL;
+	_cleanup_string_free_ GString *xml1 = NULL;
+	_cleanup_string_free_ GString *xml2 = NULL;
+
+	/* write several AppStream files to the temporary per-user location,
+	 * all of them with a copy of the same application */
+	path = g_build_filename (g_get_user_data_dir (), "app-info", "xmls", NULL);
+	g_assert (g_str_has_prefix (path, g_getenv ("XDG_DATA_HOME")));
+	g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+	for (i = 0; i < 8; i++) {
+		_cleanup_free_ gchar *filename = NULL;
+		_cleanup_free_ gchar *tmp = NULL;
+		_cleanup_string_free_ GString *xml = NULL;
+		xml = g_string_new ("<components version=\"0.6\">");
+		for (j = 0; j < 5; j++) {
+			g_string_append_printf (xml,
+				"<component type=\"desktop\">"
+				"<id>app-%u-%u.desktop</id><name>App %u %u</name>"
+				"</component>", i, j, i, j);
+		}
+		g_string_append_printf (xml,
+			"<component type=\"desktop\" priority=\"%u\">"
+			"<id>shared.desktop</id><name>Shared %u</name>"
+			"</component></components>", i, i);
+		tmp = g_strdup_printf ("test-%u.xml", i);
+		filename = g_build_filename (path, tmp, NULL);
+		ret = g_file_set_contents (filename, xml->str, -1, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+
+	/* load serially */
+	store1 = as_store_new ();
+	ret = as_store_load (store1, AS_STORE_LOAD_FLAG_APP_INFO_USER, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store1), ==, 8 * 5 + 1);
+	app = as_store_get_app_by_id (store1, "shared.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_name (app, "C"), ==, "Shared 7");
+
+	/* load in parallel, which has to give the same result */
+	store2 = as_store_new ();
+	ret = as_store_load (store2,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_PARALLEL,
+			     NULL,
+			     &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store2), ==, as_store_get_size (store1));
+	for (i = 0; i < 8; i++) {
+		for (j = 0; j < 5; j++) {
+			_cleanup_free_ gchar *id = NULL;
+			id = g_strdup_printf ("app-%u-%u.desktop", i, j);
+			g_assert (as_store_get_app_by_id (store2, id) != NULL);
+		}
+	}
+	app = as_store_get_app_by_id (store2, "shared.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_name (app, "C"), ==, "Shared 7");
+	xml1 = as_store_to_xml (store1, AS_NODE_TO_XML_FLAG_NONE);
+	xml2 = as_store_to_xml (store2, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml1->str, ==, xml2->str);
+
+	/* do not affect the other tests */
+	g_clear_object (&store1);
+	g_clear_object (&store2);
+	as_test_rmtree (g_getenv ("XDG_DATA_HOME"));
+	g_assert_cmpint (g_mkdir_with_parents (g_getenv ("XDG_DATA_HOME"), 0700), ==, 0);
+}
+
+static ino_t
+as_test_get_inode (const gchar *filename)
+{
+	GStatBuf st;
+	if (g_stat (filename, &st) != 0)
+		return 0;
+	return st.st_ino;
+}
+
+static void
+ch_test_store_load_cache_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	ino_t inode;
+	_cleanup_free_ gchar *cache_fn = NULL;
+	_cleanup_free_ gchar *checksum = NULL;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_free_ gchar *tmp = NULL;
+	_cleanup_object_unref_ AsStore *store1 = NULL;
+	_cleanup_object_unref_ AsStore *store2 = NULL;
+	_cleanup_object_unref_ AsStore *store3 = NULL;
+	_cleanup_string_free_ GString *xml1 = NULL;
+	_cleanup_string_free_ GString *xml2 = NULL;
+
+	/* write an AppStream file to the temporary per-user location */
+	path = g_build_filename (g_get_user_data_dir (), "app-info", "xmls", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+	filename = g_build_filename (path, "cache-test.xml", NULL);
+	ret = g_file_set_contents (filename,
+		"<components version=\"0.6\" origin=\"cached\">"
+		"<component type=\"desktop\"><id>a.desktop</id><name>A</name>"
+		"<description><p>Long</p></description>"
+		"<releases><release version=\"1.0\" timestamp=\"123\"/></releases>"
+		"</component>"
+		"<component type=\"desktop\"><id>b.desktop</id><name>B</name></component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* the first load parses the XML and writes the temporary cache */
+	store1 = as_store_new ();
+	ret = as_store_load (store1,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_USE_CACHE,
+			     NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store1), ==, 2);
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, filename, -1);
+	tmp = g_strdup_printf ("%s.cache", checksum);
+	cache_fn = g_build_filename (g_getenv ("XDG_CACHE_HOME"),
+				     "appstream-glib", tmp, NULL);
+	g_assert (g_file_test (cache_fn, G_FILE_TEST_EXISTS));
+	inode = as_test_get_inode (cache_fn);
+
+	/* the second load uses the cache without writing it again */
+	store2 = as_store_new ();
+	ret = as_store_load (store2,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_USE_CACHE,
+			     NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_test_get_inode (cache_fn), ==, inode);
+	g_assert_cmpstr (as_store_get_origin (store2), ==, "cached");
+	app = as_store_get_app_by_id (store2, "a.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_description (app, "C"), ==, "<p>Long</p>");
+	g_assert_cmpint (as_app_get_releases(app)->len, ==, 1);
+	xml1 = as_store_to_xml (store1, AS_NODE_TO_XML_FLAG_NONE);
+	xml2 = as_store_to_xml (store2, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert_cmpstr (xml1->str, ==, xml2->str);
+
+	/* editing the source makes the cache out of date */
+	ret = g_file_set_contents (filename,
+		"<components version=\"0.6\" origin=\"cached\">"
+		"<component type=\"desktop\"><id>a.desktop</id><name>Apple</name>"
+		"</component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	store3 = as_store_new ();
+	ret = as_store_load (store3,
+			     AS_STORE_LOAD_FLAG_APP_INFO_USER |
+			     AS_STORE_LOAD_FLAG_USE_CACHE,
+			     NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store3), ==, 1);
+	app = as_store_get_app_by_id (store3, "a.desktop");
+	g_assert (app != NULL);
+	g_assert_cmpstr (as_app_get_name (app, "C"), ==, "Apple");
+	g_assert_cmpint (as_test_get_inode (cache_fn), !=, inode);
+
+	/* do not affect the other tests */
+	g_clear_object (&store1);
+	g_clear_object (&store2);
+	g_clear_object (&store3);
+	as_test_rmtree (g_getenv ("XDG_DATA_HOME"));
+	g_assert_cmpint (g_mkdir_with_parents (g_getenv ("XDG_DATA_HOME"), 0700), ==, 0);
+}
+
+static void
+ch_test_store_reload_app_cb (AsStore *store, AsApp *app, guint *cnt)
+{
+	(*cnt)++;
+}
+
+static void
+ch_test_store_reload_func (void)
+{
+	GError *error = NULL;
+	gboolean ret;
+	guint cnt_added = 0;
+	guint cnt_changed = 0;
+	guint cnt_removed = 0;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *filename_high = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GFile *file_high = NULL;
+
+	filename = g_build_filename (g_get_tmp_dir (), "as-self-test-reload.xml", NULL);
+	ret = g_file_set_contents (filename,
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\"><id>a.desktop</id><name>A</name></component>"
+		"<component type=\"desktop\"><id>b.desktop</id><name>B</name></component>"
+		"<component type=\"desktop\"><id>c.desktop</id><name>C</name></component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	store = as_store_new ();
+	file = g_file_new_for_path (filename);
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store), ==, 3);
+	g_assert_cmpstr (as_app_get_source_file (as_store_get_app_by_id (store, "a.desktop")), ==, filename);
+	g_signal_connect (store, "app-added",
+			  G_CALLBACK (ch_test_store_reload_app_cb), &cnt_added);
+	g_signal_connect (store, "app-removed",
+			  G_CALLBACK (ch_test_store_reload_app_cb), &cnt_removed);
+	g_signal_connect (store, "app-changed",
+			  G_CALLBACK (ch_test_store_reload_app_cb), &cnt_changed);
+
+	/* one app unchanged, one changed, one removed and one added */
+	ret = g_file_set_contents (filename,
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\"><id>a.desktop</id><name>A</name></component>"
+		"<component type=\"desktop\"><id>b.desktop</id><name>Bee</name></component>"
+		"<component type=\"desktop\"><id>d.desktop</id><name>D</name></component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = as_store_reload_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (cnt_added, ==, 1);
+	g_assert_cmpint (cnt_changed, ==, 1);
+	g_assert_cmpint (cnt_removed, ==, 1);
+	g_assert_cmpint (as_store_get_size (store), ==, 3);
+	g_assert_cmpstr (as_app_get_name (as_store_get_app_by_id (store, "b.desktop"), NULL), ==, "Bee");
+	g_assert (as_store_get_app_by_id (store, "c.desktop") == NULL);
+	g_assert (as_store_get_app_by_id (store, "d.desktop") != NULL);
+
+	/* deleting the file removes everything it provided */
+	g_unlink (filename);
+	ret = as_store_reload_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (cnt_removed, ==, 4);
+	g_assert_cmpint (as_store_get_size (store), ==, 0);
+
+	/* a higher priority file replaces an application from another file */
+	ret = g_file_set_contents (filename,
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\"><id>a.desktop</id><name>Low</name></component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	filename_high = g_build_filename (g_get_tmp_dir (), "as-self-test-reload-high.xml", NULL);
+	ret = g_file_set_contents (filename_high,
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\" priority=\"5\"><id>a.desktop</id><name>High</name></component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	file_high = g_file_new_for_path (filename_high);
+	ret = as_store_reload_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	ret = as_store_reload_file (store, file_high, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store), ==, 1);
+	g_assert_cmpstr (as_app_get_name (as_store_get_app_by_id (store, "a.desktop"), NULL), ==, "High");
+
+	/* removing the winner brings back the other application */
+	cnt_changed = 0;
+	cnt_removed = 0;
+	g_unlink (filename_high);
+	ret = as_store_reload_file (store, file_high, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (cnt_changed, ==, 1);
+	g_assert_cmpint (cnt_removed, ==, 0);
+	g_assert_cmpint (as_store_get_size (store), ==, 1);
+	g_assert_cmpstr (as_app_get_name (as_store_get_app_by_id (store, "a.desktop"), NULL), ==, "Low");
+	g_unlink (filename);
+}
+
+static void
+ch_test_store_monitor_changed_cb (AsStore *store, GMainLoop *loop)
+{
+	g_main_loop_quit (loop);
+}
+
+static gboolean
+ch_test_store_monitor_timeout_cb (gpointer user_data)
+{
+	g_main_loop_quit ((GMainLoop *) user_data);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+ch_test_store_monitor_func (void)
+{
+	GError *error = NULL;
+	GMainLoop *loop;
+	gboolean ret;
+	guint cnt_added = 0;
+	guint cnt_changed = 0;
+	guint cnt_removed = 0;
+	guint timeout_id;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_free_ gchar *path = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+
+	/* watch an empty per-user location */
+	path = g_build_filename (g_get_user_data_dir (), "app-info", "xmls", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (path, 0700), ==, 0);
+	store = as_store_new ();
+	ret = as_store_load (store, AS_STORE_LOAD_FLAG_APP_INFO_USER, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store), ==, 0);
+	loop = g_main_loop_new (NULL, FALSE);
+	g_signal_connect (store, "app-added",
+			  G_CALLBACK (ch_test_store_reload_app_cb), &cnt_added);
+	g_signal_connect (store, "app-removed",
+			  G_CALLBACK (ch_test_store_reload_app_cb), &cnt_removed);
+	g_signal_connect (store, "app-changed",
+			  G_CALLBACK (ch_test_store_reload_app_cb), &cnt_changed);
+	g_signal_connect (store, "changed",
+			  G_CALLBACK (ch_test_store_monitor_changed_cb), loop);
+
+	/* this is written to a temporary file which is then renamed */
+	filename = g_build_filename (path, "monitor.xml", NULL);
+	ret = g_file_set_contents (filename,
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\"><id>a.desktop</id><name>A</name></component>"
+		"</components>", -1, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* wait for the reload, and then a little more for anything else */
+	timeout_id = g_timeout_add_seconds (10, ch_test_store_monitor_timeout_cb, loop);
+	g_main_loop_run (loop);
+	g_source_remove (timeout_id);
+	g_timeout_add (500, ch_test_store_monitor_timeout_cb, loop);
+	g_main_loop_run (loop);
+
+	/* only the real file was loaded */
+	g_assert_cmpint (cnt_added, ==, 1);
+	g_assert_cmpint (cnt_removed, ==, 0);
+	g_assert_cmpint (cnt_changed, ==, 0);
+	g_assert_cmpint (as_store_get_size (store), ==, 1);
+	g_assert_cmpstr (as_app_get_source_file (as_store_get_app_by_id (store, "a.desktop")), ==, filename);
+
+	/* do not affect the other tests */
+	g_signal_handlers_disconnect_by_data (store, loop);
+	g_main_loop_unref (loop);
+	g_clear_object (&store);
+	as_test_rmtree (g_getenv ("XDG_DATA_HOME"));
+	g_assert_cmpint (g_mkdir_with_parents (g_getenv ("XDG_DATA_HOME"), 0700), ==, 0);
+}
+
+static void
+ch_test_store_to_file_func (void)
+{
+	AsApp *app;
+	AsNodeToXmlFlags flags;
+	GError *error = NULL;
+	gboolean ret;
+	gchar buf[1024];
+	gssize len;
+	guint i;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GConverter *conv = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GInputStream *stream = NULL;
+	_cleanup_object_unref_ GInputStream *stream_data = NULL;
+	_cleanup_string_free_ GString *xml_file = NULL;
+	_cleanup_string_free_ GString *xml = NULL;
+
+	store = as_store_new ();
+	as_store_set_origin (store, "test");
+	for (i = 0; i < 3; i++) {
+		_cleanup_free_ gchar *id = g_strdup_printf ("app%u.desktop", i);
+		app = as_app_new ();
+		as_app_set_id_full (app, id, -1);
+		as_app_set_id_kind (app, AS_ID_KIND_DESKTOP);
+		as_app_set_name (app, NULL, "Name", -1);
+		as_app_add_category (app, "Game", -1);
+		as_store_add_app (store, app);
+		g_object_unref (app);
+	}
+
+	/* each component is written in turn */
+	flags = AS_NODE_TO_XML_FLAG_ADD_HEADER |
+		AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE |
+		AS_NODE_TO_XML_FLAG_FORMAT_INDENT;
+	filename = g_build_filename (g_get_tmp_dir (), "as-self-test-store.xml.gz", NULL);
+	file = g_file_new_for_path (filename);
+	ret = as_store_to_file (store, file, flags, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* which has to be identical to building the whole document */
+	stream = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+	g_assert_no_error (error);
+	g_assert (stream != NULL);
+	conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+	stream_data = g_converter_input_stream_new (stream, conv);
+	xml_file = g_string_new ("");
+	while ((len = g_input_stream_read (stream_data, buf, sizeof (buf), NULL, &error)) > 0)
+		g_string_append_len (xml_file, buf, len);
+	g_assert_no_error (error);
+	xml = as_store_to_xml (store, flags);
+	g_assert_cmpstr (xml_file->str, ==, xml->str);
+	g_unlink (filename);
+}
+
+static void
+ch_test_store_to_file_parallel_func (void)
+{
+	AsApp *app;
+	AsNodeToXmlFlags flags;
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ AsStore *store_file = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+	_cleanup_object_unref_ GFileInfo *info = NULL;
+	_cleanup_string_free_ GString *xml_file = NULL;
+	_cleanup_string_free_ GString *xml = NULL;
+
+	/* enough applications to need several gzip members */
+	store = as_store_new ();
+	as_store_set_origin (store, "test");
+	as_store_set_compression_level (store, 9);
+	g_assert_cmpint (as_store_get_compression_level (store), ==, 9);
+	for (i = 0; i < 2000; i++) {
+		_cleanup_free_ gchar *id = g_strdup_printf ("app%04u.desktop", i);
+		app = as_app_new ();
+		as_app_set_id_full (app, id, -1);
+		as_app_set_id_kind (app, AS_ID_KIND_DESKTOP);
+		as_app_set_name (app, NULL, "Name", -1);
+		as_app_set_comment (app, NULL, "A longer comment", -1);
+		as_app_add_category (app, "Game", -1);
+		as_store_add_app (store, app);
+		g_object_unref (app);
+	}
+	flags = AS_NODE_TO_XML_FLAG_ADD_HEADER |
+		AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE |
+		AS_NODE_TO_XML_FLAG_FORMAT_INDENT;
+	xml = as_store_to_xml (store, flags);
+	g_assert_cmpint (xml->len, >, 128 * 1024);
+
+	filename = g_build_filename (g_get_tmp_dir (), "as-self-test-parallel.xml.gz", NULL);
+	file = g_file_new_for_path (filename);
+	as_store_set_write_flags (store,
+				  AS_STORE_WRITE_FLAG_PARALLEL |
+				  AS_STORE_WRITE_FLAG_COMPRESS_PARALLEL);
+	ret = as_store_to_file (store, file, flags, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				  G_FILE_QUERY_INFO_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (g_file_info_get_size (info), <, xml->len);
+
+	/* all the members are read back */
+	store_file = as_store_new ();
+	ret = as_store_from_file (store_file, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store_file), ==, 2000);
+	xml_file = as_store_to_xml (store_file, flags);
+	g_assert_cmpstr (xml_file->str, ==, xml->str);
+	g_unlink (filename);
+}
+
+static void
+ch_test_store_to_xml_parallel_func (void)
+{
+	AsNodeToXmlFlags flags[] = {
+		AS_NODE_TO_XML_FLAG_NONE,
+		AS_NODE_TO_XML_FLAG_ADD_HEADER |
+		AS_NODE_TO_XML_FLAG_FORMAT_MULTILINE |
+		AS_NODE_TO_XML_FLAG_FORMAT_INDENT };
+	GError *error = NULL;
+	gboolean ret;
+	guint i;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+
+	/* load a file with a decent number of applications */
+	filename = as_test_get_filename ("example-v04.xml.gz");
+	g_assert (filename != NULL);
+	file = g_file_new_for_path (filename);
+	store = as_store_new ();
+	ret = as_store_from_file (store, file, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert_cmpint (as_store_get_size (store), >, 1);
+
+	/* converting in parallel has to give the same output */
+	for (i = 0; i < G_N_ELEMENTS (flags); i++) {
+		_cleanup_string_free_ GString *xml = NULL;
+		_cleanup_string_free_ GString *xml_parallel = NULL;
+		as_store_set_write_flags (store, AS_STORE_WRITE_FLAG_NONE);
+		xml = as_store_to_xml (store, flags[i]);
+		as_store_set_write_flags (store, AS_STORE_WRITE_FLAG_PARALLEL);
+		g_assert_cmpint (as_store_get_write_flags (store), ==, AS_STORE_WRITE_FLAG_PARALLEL);
+		xml_parallel = as_store_to_xml (store, flags[i]);
+		g_assert_cmpstr (xml->str, ==, xml_parallel->str);
+	}
+}
+
 static void
 ch_test_store_metadata_func (void)
 {
@@ -1649,9 +3232,255 @@ ch_test_store_metadata_func (void)
 	g_ptr_array_unref (apps);
 }
 
+static void
+ch_test_store_replace_func (void)
+{
+	AsApp *app;
+	guint i;
+	_cleanup_object_unref_ AsApp *app_new = NULL;
+	_cleanup_object_unref_ AsStore *store = NULL;
+
+	store = as_store_new ();
+	for (i = 0; i < 3; i++) {
+		_cleanup_free_ gchar *id = NULL;
+		_cleanup_free_ gchar *pkgname = NULL;
+		id = g_strdup_printf ("app%u.desktop", i);
+		pkgname = g_strdup_printf ("app%u", i);
+		app = as_app_new ();
+		as_app_set_id_full (app, id, -1);
+		as_app_add_pkgname (app, pkgname, -1);
+		as_store_add_app (store, app);
+		g_object_unref (app);
+	}
+
+	/* replace with a higher priority application */
+	app_new = as_app_new ();
+	as_app_set_id_full (app_new, "app1.desktop", -1);
+	as_app_set_priority (app_new, 1);
+	as_app_add_pkgname (app_new, "app1-new", -1);
+	as_store_add_app (store, app_new);
+	g_assert_cmpint (as_store_get_size (store), ==, 3);
+	g_assert (g_ptr_array_index (as_store_get_apps (store), 1) == app_new);
+	g_assert (as_store_get_app_by_id (store, "app1.desktop") == app_new);
+	g_assert (as_store_get_app_by_pkgname (store, "app1") == NULL);
+	g_assert (as_store_get_app_by_pkgname (store, "app1-new") == app_new);
+
+	/* remove from the start, and then remove again */
+	app = as_store_get_app_by_id (store, "app0.desktop");
+	g_object_ref (app);
+	as_store_remove_app (store, app);
+	as_store_remove_app (store, app);
+	g_object_unref (app);
+	g_assert_cmpint (as_store_get_size (store), ==, 2);
+	g_assert (as_store_get_app_by_id (store, "app0.desktop") == NULL);
+	g_assert (as_store_get_app_by_pkgname (store, "app0") == NULL);
+
+	/* the moved application can still be removed */
+	app = as_store_get_app_by_id (store, "app2.desktop");
+	as_store_remove_app (store, app);
+	as_store_remove_app (store, app_new);
+	g_assert_cmpint (as_store_get_size (store), ==, 0);
+	g_assert (as_store_get_app_by_pkgname (store, "app1-new") == NULL);
+}
+
+/**
+ * ch_test_store_sorted_add:
+ **/
+static AsApp *
+ch_test_store_sorted_add (AsStore *store,
+			  const gchar *id,
+			  const gchar *name,
+			  gint priority)
+{
+	_cleanup_object_unref_ AsApp *app = NULL;
+
+	app = as_app_new ();
+	as_app_set_id_full (app, id, -1);
+	as_app_set_name (app, NULL, name, -1);
+	as_app_set_priority (app, priority);
+	as_store_add_app (store, app);
+	return app;
+}
+
+static void
+ch_test_store_sorted_func (void)
+{
+	AsApp *app;
+	GPtrArray *by_id;
+	GPtrArray *by_name;
+	GPtrArray *by_priority;
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_string_free_ GString *xml = NULL;
+
+	store = as_store_new ();
+	ch_test_store_sorted_add (store, "a.desktop", "Cherry", 0);
+	ch_test_store_sorted_add (store, "c.desktop", "Apple", 5);
+	ch_test_store_sorted_add (store, "b.desktop", "Banana", -5);
+
+	by_id = as_store_get_apps_sorted (store, AS_STORE_SORT_KIND_ID);
+	by_name = as_store_get_apps_sorted (store, AS_STORE_SORT_KIND_NAME);
+	by_priority = as_store_get_apps_sorted (store, AS_STORE_SORT_KIND_PRIORITY);
+	g_assert_cmpint (by_id->len, ==, 3);
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_id, 0), NULL), ==, "Cherry");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_id, 1), NULL), ==, "Banana");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_id, 2), NULL), ==, "Apple");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_name, 0), NULL), ==, "Apple");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_name, 1), NULL), ==, "Banana");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_name, 2), NULL), ==, "Cherry");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_priority, 0), NULL), ==, "Apple");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_priority, 1), NULL), ==, "Cherry");
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_priority, 2), NULL), ==, "Banana");
+
+	/* the views are kept up to date */
+	app = ch_test_store_sorted_add (store, "d.desktop", "Blueberry", 1);
+	g_assert (as_store_get_apps_sorted (store, AS_STORE_SORT_KIND_NAME) == by_name);
+	g_assert_cmpint (by_name->len, ==, 4);
+	g_assert (g_ptr_array_index (by_id, 3) == app);
+	g_assert (g_ptr_array_index (by_name, 1) == app);
+	g_assert (g_ptr_array_index (by_priority, 1) == app);
+
+	/* changing the application after it was added does not lose it */
+	as_app_set_name (app, NULL, "Zucchini", -1);
+	as_store_remove_app (store, app);
+	g_assert_cmpint (by_id->len, ==, 3);
+	g_assert_cmpint (by_name->len, ==, 3);
+	g_assert_cmpint (by_priority->len, ==, 3);
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_name, 1), NULL), ==, "Banana");
+
+	/* changed applications are moved when the view is next requested */
+	app = g_ptr_array_index (by_priority, 0);
+	as_app_set_priority (app, -10);
+	g_assert (as_store_get_apps_sorted (store, AS_STORE_SORT_KIND_PRIORITY) == by_priority);
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_priority, 2), NULL), ==, "Apple");
+	as_app_set_name (app, NULL, "Damson", -1);
+	as_store_get_apps_sorted (store, AS_STORE_SORT_KIND_NAME);
+	g_assert_cmpstr (as_app_get_name (g_ptr_array_index (by_name, 2), NULL), ==, "Damson");
+
+	/* applications with the same ID stay in the order they were added */
+	ch_test_store_sorted_add (store, "e.desktop", "Elder", 0);
+	ch_test_store_sorted_add (store, "e.addon", "Elder", 0);
+	g_assert_cmpint (by_id->len, ==, 5);
+	g_assert_cmpstr (as_app_get_id_full (g_ptr_array_index (by_id, 3)), ==, "e.desktop");
+	g_assert_cmpstr (as_app_get_id_full (g_ptr_array_index (by_id, 4)), ==, "e.addon");
+	g_assert_cmpstr (as_app_get_id_full (g_ptr_array_index (by_name, 3)), ==, "e.desktop");
+	g_assert_cmpstr (as_app_get_id_full (g_ptr_array_index (by_name, 4)), ==, "e.addon");
+	xml = as_store_to_xml (store, AS_NODE_TO_XML_FLAG_NONE);
+	g_assert (strstr (xml->str, "e.desktop") < strstr (xml->str, "e.addon"));
+}
+
+static void
+ch_test_store_indexes_func (void)
+{
+	AsApp *app;
+	GError *error = NULL;
+	gboolean ret;
+	const gchar *xml =
+		"<components version=\"0.6\">"
+		"<component type=\"desktop\">"
+		"<id>gimp.desktop</id>"
+		"<project_group>GNOME</project_group>"
+		"<categories>"
+		"<category>Graphics</category>"
+		"</categories>"
+		"<mimetypes>"
+		"<mimetype>image/png</mimetype>"
+		"</mimetypes>"
+		"<provides>"
+		"<binary>/usr/bin/gimp</binary>"
+		"</provides>"
+		"</component>"
+		"<component type=\"desktop\">"
+		"<id>eog.desktop</id>"
+		"<project_group>GNOME</project_group>"
+		"<categories>"
+		"<category>Graphics</category>"
+		"<category>Viewer</category>"
+		"</categories>"
+		"<mimetypes>"
+		"<mimetype>image/png</mimetype>"
+		"<mimetype>image/jpeg</mimetype>"
+		"</mimetypes>"
+		"</component>"
+		"</components>";
+	_cleanup_object_unref_ AsStore *store = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps1 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps2 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps3 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps4 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps5 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps6 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps7 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps8 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps9 = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps10 = NULL;
+
+	store = as_store_new ();
+	ret = as_store_from_xml (store, xml, -1, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	apps1 = as_store_get_apps_by_category (store, "Graphics");
+	g_assert_cmpint (apps1->len, ==, 2);
+	apps2 = as_store_get_apps_by_mimetype (store, "image/jpeg");
+	g_assert_cmpint (apps2->len, ==, 1);
+	app = g_ptr_array_index (apps2, 0);
+	g_assert_cmpstr (as_app_get_id (app), ==, "eog.desktop");
+	apps3 = as_store_get_apps_by_project_group (store, "GNOME");
+	g_assert_cmpint (apps3->len, ==, 2);
+	apps4 = as_store_get_apps_by_provide (store, AS_PROVIDE_KIND_BINARY,
+					      "/usr/bin/gimp");
+	g_assert_cmpint (apps4->len, ==, 1);
+	apps5 = as_store_get_apps_by_category (store, "Office");
+	g_assert_cmpint (apps5->len, ==, 0);
+
+	/* the indexes are updated when the store changes */
+	app = as_store_get_app_by_id (store, "gimp.desktop");
+	as_store_remove_app (store, app);
+	apps6 = as_store_get_apps_by_mimetype (store, "image/png");
+	g_assert_cmpint (apps6->len, ==, 1);
+	app = as_app_new ();
+	as_app_set_id_full (app, "inkscape.desktop", -1);
+	as_app_add_category (app, "Graphics", -1);
+	as_store_add_app (store, app);
+	g_object_unref (app);
+	apps7 = as_store_get_apps_by_category (store, "Graphics");
+	g_assert_cmpint (apps7->len, ==, 2);
+
+	/* and when an application in the store changes */
+	app = as_store_get_app_by_id (store, "eog.desktop");
+	as_app_add_category (app, "Office", -1);
+	as_app_add_metadata (app, "foo", "bar", -1);
+	apps8 = as_store_get_apps_by_category (store, "Office");
+	g_assert_cmpint (apps8->len, ==, 1);
+	apps9 = as_store_get_apps_by_metadata (store, "foo", "bar");
+	g_assert_cmpint (apps9->len, ==, 1);
+
+	/* no value finds the applications without the key */
+	apps10 = as_store_get_apps_by_metadata (store, "foo", NULL);
+	g_assert_cmpint (apps10->len, ==, 1);
+	app = g_ptr_array_index (apps10, 0);
+	g_assert_cmpstr (as_app_get_id_full (app), ==, "inkscape.desktop");
+}
+
 int
 main (int argc, char **argv)
 {
+	int rc;
+	_cleanup_free_ gchar *cache_dir = NULL;
+	_cleanup_free_ gchar *data_dir = NULL;
+	_cleanup_free_ gchar *tmp_dir = NULL;
+
+	/* do not use or change the caches or data of the user running the
+	 * tests, or load the AppStream files installed on the host */
+	tmp_dir = g_dir_make_tmp ("as-self-test-XXXXXX", NULL);
+	g_assert (tmp_dir != NULL);
+	cache_dir = g_build_filename (tmp_dir, "cache", NULL);
+	data_dir = g_build_filename (tmp_dir, "data", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (cache_dir, 0700), ==, 0);
+	g_assert_cmpint (g_mkdir_with_parents (data_dir, 0700), ==, 0);
+	g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+	g_setenv ("XDG_DATA_HOME", data_dir, TRUE);
+
 	g_test_init (&argc, &argv, NULL);
 
 	/* only critical and error are fatal */
@@ -1671,9 +3500,14 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/app{validate-metainfo-good}", ch_test_app_validate_metainfo_good_func);
 	g_test_add_func ("/AppStream/app{validate-file-bad}", ch_test_app_validate_file_bad_func);
 	g_test_add_func ("/AppStream/app{validate-intltool}", ch_test_app_validate_intltool_func);
+	g_test_add_func ("/AppStream/app{validate-batch}", ch_test_app_validate_batch_func);
+	g_test_add_func ("/AppStream/app{validate-screenshots}", ch_test_app_validate_screenshots_func);
 	g_test_add_func ("/AppStream/app{parse-file}", ch_test_app_parse_file_func);
 	g_test_add_func ("/AppStream/app{no-markup}", ch_test_app_no_markup_func);
 	g_test_add_func ("/AppStream/app{subsume}", ch_test_app_subsume_func);
+	g_test_add_func ("/AppStream/app{lazy}", ch_test_app_lazy_func);
+	g_test_add_func ("/AppStream/app{display-info}", ch_test_app_display_info_func);
+	g_test_add_func ("/AppStream/app{intern}", ch_test_app_intern_func);
 	g_test_add_func ("/AppStream/app{search}", ch_test_app_search_func);
 	g_test_add_func ("/AppStream/node", ch_test_node_func);
 	g_test_add_func ("/AppStream/node{reflow}", ch_test_node_reflow_text_func);
@@ -1683,16 +3517,38 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/node{localized}", ch_test_node_localized_func);
 	g_test_add_func ("/AppStream/node{localized-wrap}", ch_test_node_localized_wrap_func);
 	g_test_add_func ("/AppStream/node{localized-wrap2}", ch_test_node_localized_wrap2_func);
+	g_test_add_func ("/AppStream/node{streaming}", ch_test_node_streaming_func);
+	g_test_add_func ("/AppStream/node{arena}", ch_test_node_arena_func);
+	g_test_add_func ("/AppStream/node{attributes}", ch_test_node_attributes_func);
+	g_test_add_func ("/AppStream/node{attributes-many}", ch_test_node_attributes_many_func);
+	g_test_add_func ("/AppStream/node{find-tag}", ch_test_node_find_tag_func);
+	g_test_add_func ("/AppStream/node{gzip}", ch_test_node_gzip_func);
+	g_test_add_func ("/AppStream/node{gzip-members}", ch_test_node_gzip_members_func);
 	g_test_add_func ("/AppStream/utils", ch_test_utils_func);
 	g_test_add_func ("/AppStream/utils{spdx-token}", ch_test_utils_spdx_token_func);
+	g_test_add_func ("/AppStream/utils{spdx-parse}", ch_test_utils_spdx_parse_func);
 	g_test_add_func ("/AppStream/store", ch_test_store_func);
 	g_test_add_func ("/AppStream/store{addons}", ch_test_store_addons_func);
 	g_test_add_func ("/AppStream/store{versions}", ch_test_store_versions_func);
 	g_test_add_func ("/AppStream/store{origin}", ch_test_store_origin_func);
 	g_test_add_func ("/AppStream/store{app-install}", ch_test_store_app_install_func);
+	g_test_add_func ("/AppStream/store{search}", ch_test_store_search_func);
+	g_test_add_func ("/AppStream/store{search-fuzzy}", ch_test_store_search_fuzzy_func);
+	g_test_add_func ("/AppStream/store{load-parallel}", ch_test_store_load_parallel_func);
+	g_test_add_func ("/AppStream/store{load-cache}", ch_test_store_load_cache_func);
+	g_test_add_func ("/AppStream/store{reload}", ch_test_store_reload_func);
+	g_test_add_func ("/AppStream/store{monitor}", ch_test_store_monitor_func);
+	g_test_add_func ("/AppStream/store{to-file}", ch_test_store_to_file_func);
+	g_test_add_func ("/AppStream/store{to-xml-parallel}", ch_test_store_to_xml_parallel_func);
+	g_test_add_func ("/AppStream/store{to-file-parallel}", ch_test_store_to_file_parallel_func);
 	g_test_add_func ("/AppStream/store{metadata}", ch_test_store_metadata_func);
+	g_test_add_func ("/AppStream/store{replace}", ch_test_store_replace_func);
+	g_test_add_func ("/AppStream/store{indexes}", ch_test_store_indexes_func);
+	g_test_add_func ("/AppStream/store{sorted}", ch_test_store_sorted_func);
 	g_test_add_func ("/AppStream/store{speed}", ch_test_store_speed_func);
 
-	return g_test_run ();
+	rc = g_test_run ();
+	as_test_rmtree (tmp_dir);
+	return rc;
 }
 
@@ -36,6 +36,10 @@
 
 #include "config.h"
 
+#include <glib/gstdio.h>
+#include <string.h>
+#include <zlib.h>
+
 #include "as-app-private.h"
 #include "as-cleanup.h"
 #include "as-node-private.h"
@@ -44,21 +48,78 @@
 
 #define AS_API_VERSION_NEWEST	0.6
 
+/* bump this if the format of the cache changes */
+#define AS_STORE_CACHE_VERSION	3
+#define AS_STORE_CACHE_TYPE	"(stutmsmsa" AS_APP_VARIANT_TYPE ")"
+
+typedef struct {
+	const gchar	*token;
+	AsApp		*app;
+	guint		 rank;
+	guint		 score;
+} AsStoreSearchToken;
+
+typedef struct {
+	gchar		*id;
+	gchar		*name_key;
+	gint		 priority;
+	guint		 sequence;	/* the order the application was added */
+	guint		 serial;	/* the application changed serial */
+} AsStoreSortKey;
+
+/* the shortest and longest terms that are matched with misspellings */
+#define AS_STORE_FUZZY_TERM_MIN		4
+#define AS_STORE_FUZZY_TERM_MAX		64
+
+typedef struct {
+	const gchar	*token;
+	guint		 start;		/* in the search index */
+	guint		 end;
+} AsStoreFuzzyToken;
+
 typedef struct _AsStorePrivate	AsStorePrivate;
 struct _AsStorePrivate
 {
 	gchar			*origin;
 	gdouble			 api_version;
+	gint			 compression_level;
+	AsStoreWriteFlags	 write_flags;
 	GPtrArray		*array;		/* of AsApp */
+	GHashTable		*hash_position;	/* of AsApp:index in array */
+	GHashTable		*hash_sequence;	/* of AsApp:order added */
+	guint			 sequence;
 	GHashTable		*hash_id;	/* of AsApp{id_full} */
+	GHashTable		*hash_shadowed;	/* of id_full:GPtrArray of AsApp */
 	GHashTable		*hash_pkgname;	/* of AsApp{pkgname} */
 	GPtrArray		*file_monitors;	/* of GFileMonitor */
+	GArray			*search_index;	/* of AsStoreSearchToken */
+	gboolean		 search_index_valid;
+	GArray			*fuzzy_tokens;	/* of AsStoreFuzzyToken */
+	GHashTable		*fuzzy_trigrams; /* of trigram:GArray of token index */
+	gboolean		 fuzzy_index_valid;
+	GHashTable		*index_metadata;	/* of key:{value:{AsApp}} */
+	GHashTable		*index_category;	/* of category:{AsApp} */
+	GHashTable		*index_mimetype;	/* of mimetype:{AsApp} */
+	GHashTable		*index_project_group;	/* of group:{AsApp} */
+	GHashTable		*index_provide[AS_PROVIDE_KIND_LAST]; /* of value:{AsApp} */
+	GHashTable		*index_buckets;		/* of AsApp:GPtrArray of {AsApp} */
+	GHashTable		*index_serials;		/* of AsApp:changed serial */
+	gboolean		 indexes_valid;
+	guint			 indexes_serial;
+	GPtrArray		*sorted[AS_STORE_SORT_KIND_LAST]; /* of AsApp, or NULL */
+	GHashTable		*sort_keys;	/* of AsApp:AsStoreSortKey */
+	gchar			*sort_locales;
+	guint			 sort_serial;
+	AsStoreLoadFlags	 load_flags;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsStore, as_store, G_TYPE_OBJECT)
 
 enum {
 	SIGNAL_CHANGED,
+	SIGNAL_APP_ADDED,
+	SIGNAL_APP_REMOVED,
+	SIGNAL_APP_CHANGED,
 	SIGNAL_LAST
 };
 
@@ -90,12 +151,34 @@ as_store_finalize (GObject *object)
 {
 	AsStore *store = AS_STORE (object);
 	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
 
 	g_free (priv->origin);
 	g_ptr_array_unref (priv->array);
+	g_hash_table_unref (priv->hash_position);
+	g_hash_table_unref (priv->hash_sequence);
 	g_ptr_array_unref (priv->file_monitors);
+	g_array_unref (priv->search_index);
+	g_array_unref (priv->fuzzy_tokens);
+	g_hash_table_unref (priv->fuzzy_trigrams);
 	g_hash_table_unref (priv->hash_id);
+	g_hash_table_unref (priv->hash_shadowed);
 	g_hash_table_unref (priv->hash_pkgname);
+	g_hash_table_unref (priv->index_metadata);
+	g_hash_table_unref (priv->index_category);
+	g_hash_table_unref (priv->index_mimetype);
+	g_hash_table_unref (priv->index_project_group);
+	for (i = 0; i < AS_PROVIDE_KIND_LAST; i++)
+		g_hash_table_unref (priv->index_provide[i]);
+	g_hash_table_unref (priv->index_buckets);
+	g_hash_table_unref (priv->index_serials);
+	for (i = 0; i < AS_STORE_SORT_KIND_LAST; i++) {
+		if (priv->sorted[i] != NULL)
+			g_ptr_array_unref (priv->sorted[i]);
+	}
+	if (priv->sort_keys != NULL)
+		g_hash_table_unref (priv->sort_keys);
+	g_free (priv->sort_locales);
 
 	G_OBJECT_CLASS (as_store_parent_class)->finalize (object);
 }
@@ -107,17 +190,59 @@ static void
 as_store_init (AsStore *store)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
+	guint i;
+
 	priv->api_version = AS_API_VERSION_NEWEST;
+	priv->compression_level = Z_DEFAULT_COMPRESSION;
 	priv->array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	priv->hash_position = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->hash_sequence = g_hash_table_new (g_direct_hash, g_direct_equal);
 	priv->hash_id = g_hash_table_new_full (g_str_hash,
 					       g_str_equal,
 					       NULL,
 					       NULL);
+	priv->hash_shadowed = g_hash_table_new_full (g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     (GDestroyNotify) g_ptr_array_unref);
 	priv->hash_pkgname = g_hash_table_new_full (g_str_hash,
 						    g_str_equal,
 						    g_free,
 						    (GDestroyNotify) g_object_unref);
 	priv->file_monitors = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	priv->search_index = g_array_new (FALSE, FALSE, sizeof (AsStoreSearchToken));
+	priv->fuzzy_tokens = g_array_new (FALSE, FALSE, sizeof (AsStoreFuzzyToken));
+	priv->fuzzy_trigrams = g_hash_table_new_full (g_direct_hash,
+						      g_direct_equal,
+						      NULL,
+						      (GDestroyNotify) g_array_unref);
+	priv->index_metadata = g_hash_table_new_full (g_str_hash,
+						      g_str_equal,
+						      g_free,
+						      (GDestroyNotify) g_hash_table_unref);
+	priv->index_category = g_hash_table_new_full (g_str_hash,
+						      g_str_equal,
+						      g_free,
+						      (GDestroyNotify) g_hash_table_unref);
+	priv->index_mimetype = g_hash_table_new_full (g_str_hash,
+						      g_str_equal,
+						      g_free,
+						      (GDestroyNotify) g_hash_table_unref);
+	priv->index_project_group = g_hash_table_new_full (g_str_hash,
+							   g_str_equal,
+							   g_free,
+							   (GDestroyNotify) g_hash_table_unref);
+	for (i = 0; i < AS_PROVIDE_KIND_LAST; i++) {
+		priv->index_provide[i] = g_hash_table_new_full (g_str_hash,
+								g_str_equal,
+								g_free,
+								(GDestroyNotify) g_hash_table_unref);
+	}
+	priv->index_buckets = g_hash_table_new_full (g_direct_hash,
+						     g_direct_equal,
+						     NULL,
+						     (GDestroyNotify) g_ptr_array_unref);
+	priv->index_serials = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 /**
@@ -135,6 +260,11 @@ as_store_class_init (AsStoreClass *klass)
 	 * The ::changed signal is emitted when the files backing the store
 	 * have changed.
 	 *
+	 * If only an AppStream file has changed then the store has already
+	 * been updated when this is emitted, and the applications that were
+	 * affected have been signalled using ::app-added, ::app-removed and
+	 * ::app-changed.
+	 *
 	 * Since: 0.1.2
 	 **/
 	signals [SIGNAL_CHANGED] =
@@ -144,6 +274,58 @@ as_store_class_init (AsStoreClass *klass)
 			      NULL, NULL, g_cclosure_marshal_VOID__VOID,
 			      G_TYPE_NONE, 0);
 
+	/**
+	 * AsStore::app-added:
+	 * @device: the #AsStore instance that emitted the signal
+	 * @app: the #AsApp that was added
+	 *
+	 * The ::app-added signal is emitted when an application has been
+	 * added to the store after an AppStream file has been reloaded.
+	 *
+	 * Since: 0.1.8
+	 **/
+	signals [SIGNAL_APP_ADDED] =
+		g_signal_new ("app-added",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (AsStoreClass, app_added),
+			      NULL, NULL, g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE, 1, AS_TYPE_APP);
+
+	/**
+	 * AsStore::app-removed:
+	 * @device: the #AsStore instance that emitted the signal
+	 * @app: the #AsApp that was removed
+	 *
+	 * The ::app-removed signal is emitted when an application has been
+	 * removed from the store after an AppStream file has been reloaded.
+	 *
+	 * Since: 0.1.8
+	 **/
+	signals [SIGNAL_APP_REMOVED] =
+		g_signal_new ("app-removed",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (AsStoreClass, app_removed),
+			      NULL, NULL, g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE, 1, AS_TYPE_APP);
+
+	/**
+	 * AsStore::app-changed:
+	 * @device: the #AsStore instance that emitted the signal
+	 * @app: the new #AsApp
+	 *
+	 * The ::app-changed signal is emitted when an application has been
+	 * replaced with a different version after an AppStream file has been
+	 * reloaded.
+	 *
+	 * Since: 0.1.8
+	 **/
+	signals [SIGNAL_APP_CHANGED] =
+		g_signal_new ("app-changed",
+			      G_TYPE_FROM_CLASS (object_class), G_SIGNAL_RUN_LAST,
+			      G_STRUCT_OFFSET (AsStoreClass, app_changed),
+			      NULL, NULL, g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE, 1, AS_TYPE_APP);
+
 	object_class->finalize = as_store_finalize;
 }
 
@@ -172,6 +354,12 @@ as_store_get_size (AsStore *store)
  *
  * Gets an array of all the valid applications in the store.
  *
+ * The applications are in the order they were added until one is removed,
+ * as as_store_remove_app() moves the last application into the place of
+ * the one removed. An application that replaces a lower priority one with
+ * the same ID also takes its place. Use as_store_get_apps_sorted() if a
+ * stable order is needed.
+ *
  * Returns: (element-type AsApp) (transfer none): an array
  *
  * Since: 0.1.0
@@ -185,154 +373,248 @@ as_store_get_apps (AsStore *store)
 }
 
 /**
- * as_store_get_apps_by_metadata:
- * @store: a #AsStore instance.
- * @key: metadata key
- * @value: metadata value
- *
- * Gets an array of all the applications that match a specific metadata element.
+ * as_store_index_add:
+ **/
+static void
+as_store_index_add (GHashTable *index,
+		    const gchar *key,
+		    AsApp *app,
+		    GPtrArray *buckets)
+{
+	GHashTable *apps;
+
+	if (key == NULL)
+		return;
+	apps = g_hash_table_lookup (index, key);
+	if (apps == NULL) {
+		apps = g_hash_table_new (g_direct_hash, g_direct_equal);
+		g_hash_table_insert (index, g_strdup (key), apps);
+	}
+	g_hash_table_add (apps, app);
+	g_ptr_array_add (buckets, apps);
+}
+
+/**
+ * as_store_index_app:
  *
- * Returns: (element-type AsApp) (transfer container): an array
+ * Adds the application to each of the indexes. The indexes do not take a
+ * reference as every application in them is also in the store array.
  *
- * Since: 0.1.4
+ * Each set the application was added to is recorded so it can be removed
+ * again without looking at the application, which may have changed since.
  **/
-GPtrArray *
-as_store_get_apps_by_metadata (AsStore *store,
-			       const gchar *key,
-			       const gchar *value)
+static void
+as_store_index_app (AsStore *store, AsApp *app)
 {
-	AsApp *app;
+	AsProvide *provide;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GPtrArray *apps;
+	GHashTable *values;
+	GHashTableIter iter;
+	GPtrArray *array;
+	GPtrArray *buckets;
+	gpointer key;
+	gpointer value;
 	guint i;
 
-	g_return_val_if_fail (AS_IS_STORE (store), NULL);
-
-	/* find all the apps with this specific metadata key */
-	apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-	for (i = 0; i < priv->array->len; i++) {
-		app = g_ptr_array_index (priv->array, i);
-		if (g_strcmp0 (as_app_get_metadata_item (app, key), value) != 0)
+	buckets = g_ptr_array_new ();
+	g_hash_table_insert (priv->index_buckets, app, buckets);
+	g_hash_table_iter_init (&iter, as_app_get_metadata (app));
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		values = g_hash_table_lookup (priv->index_metadata, key);
+		if (values == NULL) {
+			values = g_hash_table_new_full (g_str_hash,
+							g_str_equal,
+							g_free,
+							(GDestroyNotify) g_hash_table_unref);
+			g_hash_table_insert (priv->index_metadata,
+					     g_strdup (key), values);
+		}
+		as_store_index_add (values, value, app, buckets);
+	}
+	array = as_app_get_categories (app);
+	for (i = 0; i < array->len; i++) {
+		as_store_index_add (priv->index_category,
+				    g_ptr_array_index (array, i), app, buckets);
+	}
+	array = as_app_get_mimetypes (app);
+	for (i = 0; i < array->len; i++) {
+		as_store_index_add (priv->index_mimetype,
+				    g_ptr_array_index (array, i), app, buckets);
+	}
+	as_store_index_add (priv->index_project_group,
+			    as_app_get_project_group (app), app, buckets);
+	array = as_app_get_provides (app);
+	for (i = 0; i < array->len; i++) {
+		provide = g_ptr_array_index (array, i);
+		if (as_provide_get_kind (provide) >= AS_PROVIDE_KIND_LAST)
 			continue;
-		g_ptr_array_add (apps, g_object_ref (app));
+		as_store_index_add (priv->index_provide[as_provide_get_kind (provide)],
+				    as_provide_get_value (provide), app, buckets);
 	}
-	return apps;
+
+	/* getting the provides may have loaded deferred data */
+	g_hash_table_insert (priv->index_serials, app,
+			     GUINT_TO_POINTER (as_app_get_changed_serial (app)));
 }
 
 /**
- * as_store_get_app_by_id:
- * @store: a #AsStore instance.
- * @id: the application full ID.
- *
- * Finds an application in the store by ID.
- *
- * Returns: (transfer none): a #AsApp or %NULL
+ * as_store_unindex_app:
  *
- * Since: 0.1.0
+ * Removes the application from every set it was added to. Empty sets are
+ * kept as other applications may still refer to them.
  **/
-AsApp *
-as_store_get_app_by_id (AsStore *store, const gchar *id)
+static void
+as_store_unindex_app (AsStore *store, AsApp *app)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	g_return_val_if_fail (AS_IS_STORE (store), NULL);
-	return g_hash_table_lookup (priv->hash_id, id);
+	GPtrArray *buckets;
+	guint i;
+
+	buckets = g_hash_table_lookup (priv->index_buckets, app);
+	if (buckets == NULL)
+		return;
+	for (i = 0; i < buckets->len; i++)
+		g_hash_table_remove (g_ptr_array_index (buckets, i), app);
+	g_hash_table_remove (priv->index_buckets, app);
+	g_hash_table_remove (priv->index_serials, app);
 }
 
 /**
- * as_store_get_app_by_pkgname:
- * @store: a #AsStore instance.
- * @pkgname: the package name.
- *
- * Finds an application in the store by package name.
- *
- * Returns: (transfer none): a #AsApp or %NULL
+ * as_store_indexes_ensure:
  *
- * Since: 0.1.0
+ * Builds the indexes the first time they are queried, so that loading a
+ * store that is never queried does not parse any lazily loaded data.
+ * After that they are kept up to date as applications are added and removed,
+ * and any application that has been changed since it was indexed is
+ * indexed again.
  **/
-AsApp *
-as_store_get_app_by_pkgname (AsStore *store, const gchar *pkgname)
+static void
+as_store_indexes_ensure (AsStore *store)
 {
+	AsApp *app;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	g_return_val_if_fail (AS_IS_STORE (store), NULL);
-	return g_hash_table_lookup (priv->hash_pkgname, pkgname);
+	gpointer serial;
+	guint i;
+	guint serial_global;
+
+	/* nothing has changed in any application */
+	serial_global = as_app_get_changed_serial_global ();
+	if (priv->indexes_valid && priv->indexes_serial == serial_global)
+		return;
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		if (priv->indexes_valid &&
+		    g_hash_table_lookup_extended (priv->index_serials, app,
+						  NULL, &serial) &&
+		    GPOINTER_TO_UINT (serial) == as_app_get_changed_serial (app))
+			continue;
+		as_store_unindex_app (store, app);
+		as_store_index_app (store, app);
+	}
+	priv->indexes_valid = TRUE;
+	priv->indexes_serial = serial_global;
 }
 
 /**
- * as_store_remove_app:
- * @store: a #AsStore instance.
- * @app: a #AsApp instance.
- *
- * Removes an application from the store if it exists.
- *
- * Since: 0.1.0
+ * as_store_index_lookup:
  **/
-void
-as_store_remove_app (AsStore *store, AsApp *app)
+static GPtrArray *
+as_store_index_lookup (GHashTable *index, const gchar *key)
+{
+	GHashTable *apps;
+	GHashTableIter iter;
+	GPtrArray *array;
+	gpointer app;
+
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	if (index == NULL || key == NULL)
+		return array;
+	apps = g_hash_table_lookup (index, key);
+	if (apps == NULL)
+		return array;
+	g_hash_table_iter_init (&iter, apps);
+	while (g_hash_table_iter_next (&iter, &app, NULL))
+		g_ptr_array_add (array, g_object_ref (app));
+	return array;
+}
+
+/**
+ * as_store_array_add:
+ **/
+static void
+as_store_array_add (AsStore *store, AsApp *app)
 {
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	g_hash_table_remove (priv->hash_id, as_app_get_id_full (app));
-	g_ptr_array_remove (priv->array, app);
+	g_hash_table_insert (priv->hash_position, app,
+			     GUINT_TO_POINTER (priv->array->len));
+	g_hash_table_insert (priv->hash_sequence, app,
+			     GUINT_TO_POINTER (++priv->sequence));
+	g_ptr_array_add (priv->array, g_object_ref (app));
 }
 
 /**
- * as_store_add_app:
- * @store: a #AsStore instance.
- * @app: a #AsApp instance.
+ * as_store_array_remove:
  *
- * Adds an application to the store. If a lower priority application has already
- * been added then this new application will replace it.
- *
- * Additionally only applications where the kind is known will be added.
- *
- * Since: 0.1.0
+ * Removes the application by moving the last one into its place.
  **/
-void
-as_store_add_app (AsStore *store, AsApp *app)
+static void
+as_store_array_remove (AsStore *store, AsApp *app)
 {
-	AsApp *item;
+	AsApp *last;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GPtrArray *pkgnames;
-	const gchar *id;
-	const gchar *pkgname;
-	guint i;
+	gpointer value;
+	guint idx;
 
-	/* have we recorded this before? */
-	id = as_app_get_id_full (app);
-	if (id == NULL) {
-		g_warning ("application has no ID set");
+	if (!g_hash_table_lookup_extended (priv->hash_position, app, NULL, &value))
 		return;
+	idx = GPOINTER_TO_UINT (value);
+	last = g_ptr_array_index (priv->array, priv->array->len - 1);
+	if (last != app) {
+		g_hash_table_insert (priv->hash_position, last,
+				     GUINT_TO_POINTER (idx));
 	}
-	item = g_hash_table_lookup (priv->hash_id, id);
-	if (item != NULL) {
-
-		/* the previously stored app is higher priority */
-		if (as_app_get_priority (item) >
-		    as_app_get_priority (app)) {
-			g_debug ("ignoring duplicate AppStream entry: %s", id);
-			return;
-		}
+	g_hash_table_remove (priv->hash_position, app);
+	g_hash_table_remove (priv->hash_sequence, app);
+	g_ptr_array_remove_index_fast (priv->array, idx);
+}
 
-		/* same priority */
-		if (as_app_get_priority (item) ==
-		    as_app_get_priority (app)) {
-			g_debug ("merging duplicate AppStream entries: %s", id);
-			as_app_subsume_full (item, app,
-					     AS_APP_SUBSUME_FLAG_BOTH_WAYS);
-			return;
-		}
+/**
+ * as_store_array_replace:
+ *
+ * Puts the application in the same place as an existing one.
+ **/
+static void
+as_store_array_replace (AsStore *store, AsApp *old, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	gpointer value;
+	guint idx;
 
-		/* this new item has a higher priority than the one we've
-		 * previously stored */
-		g_debug ("replacing duplicate AppStream entry: %s", id);
-		g_hash_table_remove (priv->hash_id, id);
-		g_ptr_array_remove (priv->array, item);
+	if (!g_hash_table_lookup_extended (priv->hash_position, old, NULL, &value)) {
+		as_store_array_add (store, app);
+		return;
 	}
+	idx = GPOINTER_TO_UINT (value);
+	g_hash_table_remove (priv->hash_position, old);
+	g_hash_table_remove (priv->hash_sequence, old);
+	g_hash_table_insert (priv->hash_position, app, GUINT_TO_POINTER (idx));
+	g_hash_table_insert (priv->hash_sequence, app,
+			     GUINT_TO_POINTER (++priv->sequence));
+	priv->array->pdata[idx] = g_object_ref (app);
+	g_object_unref (old);
+}
+
+/**
+ * as_store_pkgnames_add:
+ **/
+static void
+as_store_pkgnames_add (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *pkgnames;
+	const gchar *pkgname;
+	guint i;
 
-	/* success, add to array */
-	g_ptr_array_add (priv->array, g_object_ref (app));
-	g_hash_table_insert (priv->hash_id,
-			     (gpointer) as_app_get_id_full (app),
-			     app);
 	pkgnames = as_app_get_pkgnames (app);
 	for (i = 0; i < pkgnames->len; i++) {
 		pkgname = g_ptr_array_index (pkgnames, i);
@@ -343,434 +625,2641 @@ as_store_add_app (AsStore *store, AsApp *app)
 }
 
 /**
- * as_store_match_addons:
+ * as_store_pkgnames_remove:
  **/
 static void
-as_store_match_addons (AsStore *store)
+as_store_pkgnames_remove (AsStore *store, AsApp *app)
 {
-	AsApp *app;
-	AsApp *parent;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GPtrArray *plugin_ids;
-	const gchar *tmp;
+	GPtrArray *pkgnames;
+	const gchar *pkgname;
 	guint i;
-	guint j;
 
-	for (i = 0; i < priv->array->len; i++) {
-		app = g_ptr_array_index (priv->array, i);
-		if (as_app_get_id_kind (app) != AS_ID_KIND_ADDON)
-			continue;
-		plugin_ids = as_app_get_extends (app);
-		if (plugin_ids->len == 0) {
-			g_warning ("%s was of type plugin but had no plugin_for",
-				   as_app_get_id_full (app));
-			continue;
-		}
-		for (j = 0; j < plugin_ids->len; j++) {
-			tmp = g_ptr_array_index (plugin_ids, j);
-			parent = g_hash_table_lookup (priv->hash_id, tmp);
-			if (parent == NULL) {
-				g_warning ("%s had no parent of '%s'",
-					   as_app_get_id_full (app), tmp);
-				continue;
-			}
-			as_app_add_addon (parent, app);
-		}
+	pkgnames = as_app_get_pkgnames (app);
+	for (i = 0; i < pkgnames->len; i++) {
+		pkgname = g_ptr_array_index (pkgnames, i);
+		if (g_hash_table_lookup (priv->hash_pkgname, pkgname) == app)
+			g_hash_table_remove (priv->hash_pkgname, pkgname);
 	}
 }
 
 /**
- * as_store_from_root:
+ * as_store_sort_key_free:
  **/
-static gboolean
-as_store_from_root (AsStore *store,
-		    GNode *root,
-		    const gchar *icon_root,
-		    GError **error)
+static void
+as_store_sort_key_free (AsStoreSortKey *key)
 {
-	AsStorePrivate *priv = GET_PRIVATE (store);
-	GNode *apps;
-	GNode *n;
-	const gchar *tmp;
-	_cleanup_free_ gchar *icon_path = NULL;
+	g_free (key->id);
+	g_free (key->name_key);
+	g_slice_free (AsStoreSortKey, key);
+}
 
-	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+/**
+ * as_store_sort_key_set_name:
+ *
+ * Collates the name for the users default locale, so that comparing two
+ * names is just a byte comparison.
+ **/
+static void
+as_store_sort_key_set_name (AsStoreSortKey *key, AsApp *app)
+{
+	const gchar *name;
 
-	apps = as_node_find (root, "components");
-	if (apps == NULL) {
-		apps = as_node_find (root, "applications");
-		if (apps == NULL) {
-			g_set_error_literal (error,
-					     AS_STORE_ERROR,
-					     AS_STORE_ERROR_FAILED,
-					     "No valid root node specified");
-			return FALSE;
-		}
+	g_free (key->name_key);
+	name = as_app_get_name (app, NULL);
+	key->name_key = name != NULL ? g_utf8_collate_key (name, -1) : NULL;
+}
+
+/**
+ * as_store_sort_key_new:
+ *
+ * Records the values the application is sorted by, so that it can still be
+ * found in the sorted views if it is changed before the views are updated.
+ **/
+static AsStoreSortKey *
+as_store_sort_key_new (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSortKey *key;
+
+	key = g_slice_new0 (AsStoreSortKey);
+	key->id = g_strdup (as_app_get_id (app));
+	key->priority = as_app_get_priority (app);
+	key->sequence = GPOINTER_TO_UINT (g_hash_table_lookup (priv->hash_sequence, app));
+	key->serial = as_app_get_changed_serial (app);
+
+	/* only collate the name if something is sorted by it */
+	if (priv->sorted[AS_STORE_SORT_KIND_NAME] != NULL)
+		as_store_sort_key_set_name (key, app);
+	return key;
+}
+
+/**
+ * as_store_sort_cmp:
+ **/
+static gint
+as_store_sort_cmp (AsStore *store,
+		   AsStoreSortKind kind,
+		   AsApp *app1,
+		   AsApp *app2)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSortKey *key1;
+	AsStoreSortKey *key2;
+	gint rc;
+
+	if (app1 == app2)
+		return 0;
+	key1 = g_hash_table_lookup (priv->sort_keys, app1);
+	key2 = g_hash_table_lookup (priv->sort_keys, app2);
+	switch (kind) {
+	case AS_STORE_SORT_KIND_NAME:
+		/* applications without a name go last */
+		if (key1->name_key == NULL && key2->name_key != NULL)
+			return 1;
+		if (key1->name_key != NULL && key2->name_key == NULL)
+			return -1;
+		rc = g_strcmp0 (key1->name_key, key2->name_key);
+		if (rc != 0)
+			return rc;
+		break;
+	case AS_STORE_SORT_KIND_PRIORITY:
+		if (key1->priority != key2->priority)
+			return key1->priority > key2->priority ? -1 : 1;
+		break;
+	default:
+		break;
 	}
 
-	/* get version */
-	tmp = as_node_get_attribute (apps, "version");
-	if (tmp != NULL)
-		priv->api_version = g_ascii_strtod (tmp, NULL);
+	/* then by ID, and by the order added so every application has one place */
+	rc = g_strcmp0 (key1->id, key2->id);
+	if (rc != 0)
+		return rc;
+	return key1->sequence < key2->sequence ? -1 : 1;
+}
 
-	/* set in the XML file */
-	tmp = as_node_get_attribute (apps, "origin");
-	if (tmp != NULL)
-		as_store_set_origin (store, tmp);
+typedef struct {
+	AsStore		*store;
+	AsStoreSortKind	 kind;
+} AsStoreSortHelper;
 
-	/* if we have an origin either from the XML or _set_origin() */
-	if (priv->origin != NULL) {
-		if (icon_root == NULL)
-			icon_root = "/usr/share/app-info/icons/";
-		icon_path = g_build_filename (icon_root,
-					      priv->origin,
-					      NULL);
+/**
+ * as_store_sorted_sort_cb:
+ **/
+static gint
+as_store_sorted_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	AsStoreSortHelper *helper = (AsStoreSortHelper *) user_data;
+	return as_store_sort_cmp (helper->store, helper->kind,
+				  *(AsApp **) a, *(AsApp **) b);
+}
+
+/**
+ * as_store_sorted_find:
+ *
+ * Returns the position of the first application in the sorted view that
+ * does not sort before @app.
+ **/
+static guint
+as_store_sorted_find (AsStore *store, AsStoreSortKind kind, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *sorted = priv->sorted[kind];
+	guint hi = sorted->len;
+	guint lo = 0;
+	guint mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (as_store_sort_cmp (store, kind,
+				       g_ptr_array_index (sorted, mid), app) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	for (n = apps->children; n != NULL; n = n->next) {
-		_cleanup_error_free_ GError *error_local = NULL;
-		_cleanup_object_unref_ AsApp *app = NULL;
-		if (as_node_get_tag (n) != AS_TAG_APPLICATION)
+	return lo;
+}
+
+/**
+ * as_store_sorted_add:
+ *
+ * Inserts the application into each sorted view that has been requested.
+ **/
+static void
+as_store_sorted_add (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *sorted;
+	guint idx;
+	guint kind;
+
+	if (priv->sort_keys == NULL)
+		return;
+	g_hash_table_insert (priv->sort_keys, app,
+			     as_store_sort_key_new (store, app));
+	for (kind = 0; kind < AS_STORE_SORT_KIND_LAST; kind++) {
+		sorted = priv->sorted[kind];
+		if (sorted == NULL)
 			continue;
-		app = as_app_new ();
-		if (icon_path != NULL)
-			as_app_set_icon_path (app, icon_path, -1);
-		as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
-		if (!as_app_node_parse (app, n, &error_local)) {
-			g_set_error (error,
-				     AS_STORE_ERROR,
-				     AS_STORE_ERROR_FAILED,
-				     "Failed to parse root: %s",
-				     error_local->message);
-			return FALSE;
+		idx = as_store_sorted_find (store, kind, app);
+		g_ptr_array_add (sorted, NULL);
+		memmove (sorted->pdata + idx + 1,
+			 sorted->pdata + idx,
+			 (sorted->len - idx - 1) * sizeof (gpointer));
+		sorted->pdata[idx] = app;
+	}
+}
+
+/**
+ * as_store_sorted_remove:
+ **/
+static void
+as_store_sorted_remove (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *sorted;
+	guint idx;
+	guint kind;
+
+	if (priv->sort_keys == NULL)
+		return;
+	if (!g_hash_table_contains (priv->sort_keys, app))
+		return;
+	for (kind = 0; kind < AS_STORE_SORT_KIND_LAST; kind++) {
+		sorted = priv->sorted[kind];
+		if (sorted == NULL)
+			continue;
+		idx = as_store_sorted_find (store, kind, app);
+		if (idx < sorted->len && g_ptr_array_index (sorted, idx) == app)
+			g_ptr_array_remove_index (sorted, idx);
+	}
+	g_hash_table_remove (priv->sort_keys, app);
+}
+
+/**
+ * as_store_sorted_refresh:
+ *
+ * Moves the applications that have changed since their keys were recorded
+ * to their new places in the sorted views.
+ **/
+static void
+as_store_sorted_refresh (AsStore *store)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSortKey *key;
+	guint i;
+	guint serial;
+
+	/* nothing has changed anywhere */
+	serial = as_app_get_changed_serial_global ();
+	if (priv->sort_serial == serial)
+		return;
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		key = g_hash_table_lookup (priv->sort_keys, app);
+		if (key == NULL || key->serial == as_app_get_changed_serial (app))
+			continue;
+		as_store_sorted_remove (store, app);
+		as_store_sorted_add (store, app);
+	}
+	priv->sort_serial = serial;
+}
+
+/**
+ * as_store_sorted_ensure:
+ *
+ * Sorts the applications the first time a view is requested. After that
+ * the view is kept up to date as applications are added and removed.
+ **/
+static GPtrArray *
+as_store_sorted_ensure (AsStore *store, AsStoreSortKind kind)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSortHelper helper;
+	AsStoreSortKey *key;
+	GPtrArray *sorted;
+	guint i;
+	_cleanup_free_ gchar *locales = NULL;
+
+	/* record the keys of every application the first time */
+	if (priv->sort_keys == NULL) {
+		priv->sort_keys = g_hash_table_new_full (g_direct_hash,
+							 g_direct_equal,
+							 NULL,
+							 (GDestroyNotify) as_store_sort_key_free);
+		priv->sort_serial = as_app_get_changed_serial_global ();
+		for (i = 0; i < priv->array->len; i++) {
+			app = g_ptr_array_index (priv->array, i);
+			g_hash_table_insert (priv->sort_keys, app,
+					     as_store_sort_key_new (store, app));
 		}
-		as_store_add_app (store, app);
 	}
 
-	/* add addon kinds to their parent AsApp */
-	as_store_match_addons (store);
+	/* move any applications that have changed since they were added */
+	as_store_sorted_refresh (store);
+
+	/* the names have to be collated again if the locale changes, which
+	 * is compared by value as the array is owned by each thread */
+	if (kind == AS_STORE_SORT_KIND_NAME) {
+		locales = g_strjoinv (":", (gchar **) g_get_language_names ());
+		if (priv->sorted[kind] != NULL &&
+		    g_strcmp0 (priv->sort_locales, locales) != 0) {
+			g_ptr_array_unref (priv->sorted[kind]);
+			priv->sorted[kind] = NULL;
+		}
+		if (priv->sorted[kind] == NULL) {
+			for (i = 0; i < priv->array->len; i++) {
+				app = g_ptr_array_index (priv->array, i);
+				key = g_hash_table_lookup (priv->sort_keys, app);
+				as_store_sort_key_set_name (key, app);
+			}
+			g_free (priv->sort_locales);
+			priv->sort_locales = locales;
+			locales = NULL;
+		}
+	}
 
-	return TRUE;
+	/* already up to date */
+	if (priv->sorted[kind] != NULL)
+		return priv->sorted[kind];
+
+	sorted = g_ptr_array_sized_new (priv->array->len);
+	for (i = 0; i < priv->array->len; i++)
+		g_ptr_array_add (sorted, g_ptr_array_index (priv->array, i));
+	helper.store = store;
+	helper.kind = kind;
+	g_ptr_array_sort_with_data (sorted, as_store_sorted_sort_cb, &helper);
+	priv->sorted[kind] = sorted;
+	return sorted;
 }
 
 /**
- * as_store_from_file:
+ * as_store_get_apps_sorted:
  * @store: a #AsStore instance.
- * @file: a #GFile.
- * @icon_root: the icon path, or %NULL for the default.
- * @cancellable: a #GCancellable.
- * @error: A #GError or %NULL.
+ * @kind: a #AsStoreSortKind, e.g. %AS_STORE_SORT_KIND_NAME
  *
- * Parses an AppStream XML file and adds any valid applications to the store.
+ * Gets all the applications in the store in a specific order. The order is
+ * worked out the first time it is requested and is then kept up to date as
+ * applications are added and removed, so this is cheap to call repeatedly.
  *
- * If the root node does not have a 'origin' attribute, then the method
- * as_store_set_origin() should be called *before* this function if cached
- * icons are required.
+ * Names are compared using collation keys for the users default locale.
+ * Applications that are changed after being added to the store are moved
+ * to their new place the next time the view is requested.
  *
- * Returns: %TRUE for success
+ * Returns: (element-type AsApp) (transfer none): an array
  *
- * Since: 0.1.0
+ * Since: 0.1.8
  **/
-gboolean
-as_store_from_file (AsStore *store,
-		    GFile *file,
-		    const gchar *icon_root,
-		    GCancellable *cancellable,
-		    GError **error)
+GPtrArray *
+as_store_get_apps_sorted (AsStore *store, AsStoreSortKind kind)
 {
-	_cleanup_error_free_ GError *error_local = NULL;
-	_cleanup_node_unref_ GNode *root = NULL;
-
-	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
-
-	root = as_node_from_file (file,
-				  AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
-				  cancellable,
-				  &error_local);
-	if (root == NULL) {
-		g_set_error (error,
-			     AS_STORE_ERROR,
-			     AS_STORE_ERROR_FAILED,
-			     "Failed to parse file: %s",
-			     error_local->message);
-		return FALSE;
-	}
-	return as_store_from_root (store, root, icon_root, error);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	g_return_val_if_fail (kind < AS_STORE_SORT_KIND_LAST, NULL);
+	return as_store_sorted_ensure (store, kind);
 }
 
 /**
- * as_store_from_xml:
+ * as_store_get_apps_by_metadata:
  * @store: a #AsStore instance.
- * @data: XML data
- * @data_len: Length of @data, or -1 if NULL terminated
- * @icon_root: the icon path, or %NULL for the default.
- * @error: A #GError or %NULL.
- *
- * Parses AppStream XML file and adds any valid applications to the store.
+ * @key: metadata key
+ * @value: metadata value, or %NULL for the applications without the key
  *
- * If the root node does not have a 'origin' attribute, then the method
- * as_store_set_origin() should be called *before* this function if cached
- * icons are required.
+ * Gets an array of all the applications that match a specific metadata element.
  *
- * Returns: %TRUE for success
+ * Returns: (element-type AsApp) (transfer container): an array
  *
- * Since: 0.1.1
+ * Since: 0.1.4
  **/
-gboolean
-as_store_from_xml (AsStore *store,
-		   const gchar *data,
-		   gssize data_len,
-		   const gchar *icon_root,
-		   GError **error)
+GPtrArray *
+as_store_get_apps_by_metadata (AsStore *store,
+			       const gchar *key,
+			       const gchar *value)
 {
-	_cleanup_error_free_ GError *error_local = NULL;
-	_cleanup_node_unref_ GNode *root = NULL;
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *apps;
+	guint i;
 
-	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
 
-	root = as_node_from_xml (data, data_len,
-				 AS_NODE_FROM_XML_FLAG_LITERAL_TEXT,
-				 &error_local);
-	if (root == NULL) {
-		g_set_error (error,
-			     AS_STORE_ERROR,
-			     AS_STORE_ERROR_FAILED,
-			     "Failed to parse XML: %s",
-			     error_local->message);
-		return TRUE;
+	/* the applications without the key are not indexed */
+	if (key != NULL && value == NULL) {
+		apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		for (i = 0; i < priv->array->len; i++) {
+			app = g_ptr_array_index (priv->array, i);
+			if (as_app_get_metadata_item (app, key) != NULL)
+				continue;
+			g_ptr_array_add (apps, g_object_ref (app));
+		}
+		return apps;
 	}
-	return as_store_from_root (store, root, icon_root, error);
+
+	as_store_indexes_ensure (store);
+	if (key == NULL)
+		return as_store_index_lookup (NULL, NULL);
+	return as_store_index_lookup (g_hash_table_lookup (priv->index_metadata, key),
+				      value);
 }
 
 /**
- * as_store_apps_sort_cb:
+ * as_store_get_apps_by_category:
+ * @store: a #AsStore instance.
+ * @category: a category, e.g. "AudioVideo"
+ *
+ * Gets an array of all the applications in a specific category.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array
+ *
+ * Since: 0.1.8
  **/
-static gint
-as_store_apps_sort_cb (gconstpointer a, gconstpointer b)
+GPtrArray *
+as_store_get_apps_by_category (AsStore *store, const gchar *category)
 {
-	return g_strcmp0 (as_app_get_id (AS_APP (*(AsApp **) a)),
-			  as_app_get_id (AS_APP (*(AsApp **) b)));
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	as_store_indexes_ensure (store);
+	return as_store_index_lookup (priv->index_category, category);
 }
 
 /**
- * as_store_to_xml:
+ * as_store_get_apps_by_mimetype:
  * @store: a #AsStore instance.
- * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_INSERT_FLAG_NONE.
+ * @mimetype: a mimetype, e.g. "text/plain"
  *
- * Outputs an XML representation of all the applications in the store.
+ * Gets an array of all the applications that handle a specific mimetype.
  *
- * Returns: A #GString
+ * Returns: (element-type AsApp) (transfer container): an array
  *
- * Since: 0.1.0
+ * Since: 0.1.8
  **/
-GString *
-as_store_to_xml (AsStore *store, AsNodeToXmlFlags flags)
+GPtrArray *
+as_store_get_apps_by_mimetype (AsStore *store, const gchar *mimetype)
 {
-	AsApp *app;
 	AsStorePrivate *priv = GET_PRIVATE (store);
-	GNode *node_apps;
-	GNode *node_root;
-	GString *xml;
-	guint i;
-	gchar version[6];
-
-	/* get XML text */
-	node_root = as_node_new ();
-	if (priv->api_version >= 0.6) {
-		node_apps = as_node_insert (node_root, "components", NULL, 0, NULL);
-	} else {
-		node_apps = as_node_insert (node_root, "applications", NULL, 0, NULL);
-	}
-
-	/* set origin attribute */
-	if (priv->origin != NULL)
-		as_node_add_attribute (node_apps, "origin", priv->origin, -1);
-
-	/* set version attribute */
-	if (priv->api_version > 0.1f) {
-		g_ascii_formatd (version, sizeof (version),
-				 "%.1f", priv->api_version);
-		as_node_add_attribute (node_apps, "version", version, -1);
-	}
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	as_store_indexes_ensure (store);
+	return as_store_index_lookup (priv->index_mimetype, mimetype);
+}
 
-	/* sort by ID */
-	g_ptr_array_sort (priv->array, as_store_apps_sort_cb);
+/**
+ * as_store_get_apps_by_project_group:
+ * @store: a #AsStore instance.
+ * @project_group: a project group, e.g. "GNOME"
+ *
+ * Gets an array of all the applications in a specific project group.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_store_get_apps_by_project_group (AsStore *store, const gchar *project_group)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	as_store_indexes_ensure (store);
+	return as_store_index_lookup (priv->index_project_group, project_group);
+}
 
-	/* add applications */
-	for (i = 0; i < priv->array->len; i++) {
-		app = g_ptr_array_index (priv->array, i);
-		as_app_node_insert (app, node_apps, priv->api_version);
-	}
-	xml = as_node_to_xml (node_root, flags);
-	as_node_unref (node_root);
-	return xml;
+/**
+ * as_store_get_apps_by_provide:
+ * @store: a #AsStore instance.
+ * @kind: the #AsProvideKind, e.g. %AS_PROVIDE_KIND_BINARY
+ * @value: the provided value, e.g. "/usr/bin/gimp"
+ *
+ * Gets an array of all the applications that provide a specific item.
+ *
+ * Returns: (element-type AsApp) (transfer container): an array
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_store_get_apps_by_provide (AsStore *store,
+			      AsProvideKind kind,
+			      const gchar *value)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	g_return_val_if_fail (kind < AS_PROVIDE_KIND_LAST, NULL);
+	as_store_indexes_ensure (store);
+	return as_store_index_lookup (priv->index_provide[kind], value);
 }
 
 /**
- * as_store_to_file:
+ * as_store_get_app_by_id:
  * @store: a #AsStore instance.
- * @file: file
- * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_INSERT_FLAG_NONE.
- * @cancellable: A #GCancellable, or %NULL
- * @error: A #GError or %NULL
+ * @id: the application full ID.
  *
- * Outputs a compressed XML file of all the applications in the store.
+ * Finds an application in the store by ID.
  *
- * Returns: A #GString
+ * Returns: (transfer none): a #AsApp or %NULL
  *
  * Since: 0.1.0
  **/
-gboolean
-as_store_to_file (AsStore *store,
-		  GFile *file,
-		  AsNodeToXmlFlags flags,
-		  GCancellable *cancellable,
-		  GError **error)
+AsApp *
+as_store_get_app_by_id (AsStore *store, const gchar *id)
 {
-	_cleanup_error_free_ GError *error_local = NULL;
-	_cleanup_object_unref_ GOutputStream *out2 = NULL;
-	_cleanup_object_unref_ GOutputStream *out = NULL;
-	_cleanup_object_unref_ GZlibCompressor *compressor = NULL;
-	_cleanup_string_free_ GString *xml = NULL;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	return g_hash_table_lookup (priv->hash_id, id);
+}
+
+/**
+ * as_store_get_app_by_pkgname:
+ * @store: a #AsStore instance.
+ * @pkgname: the package name.
+ *
+ * Finds an application in the store by package name.
+ *
+ * Returns: (transfer none): a #AsApp or %NULL
+ *
+ * Since: 0.1.0
+ **/
+AsApp *
+as_store_get_app_by_pkgname (AsStore *store, const gchar *pkgname)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+	return g_hash_table_lookup (priv->hash_pkgname, pkgname);
+}
+
+/**
+ * as_store_search_token_sort_cb:
+ **/
+static gint
+as_store_search_token_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (((AsStoreSearchToken *) a)->token,
+			  ((AsStoreSearchToken *) b)->token);
+}
+
+/**
+ * as_store_search_index_ensure:
+ *
+ * Creates a sorted array of every search token in the store, so that all
+ * the tokens matching a prefix are found with one binary search.
+ *
+ * The rank is the order in which as_app_search_matches() would check the
+ * token, so the lowest ranked match for an application gives the same
+ * score as the linear search.
+ **/
+static void
+as_store_search_index_ensure (AsStore *store)
+{
+	AsApp *app;
+	AsAppTokenItem *item;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSearchToken tok;
+	GPtrArray *tokens;
+	guint i, j, k;
+
+	/* already valid */
+	if (priv->search_index_valid)
+		return;
+
+	g_array_set_size (priv->search_index, 0);
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		tok.app = app;
+		tokens = as_app_get_search_tokens (app);
+		for (j = 0; j < tokens->len; j++) {
+			item = g_ptr_array_index (tokens, j);
+			if (item->values_utf8 != NULL) {
+				tok.rank = j * 2;
+				tok.score = item->score;
+				for (k = 0; item->values_utf8[k] != NULL; k++) {
+					tok.token = item->values_utf8[k];
+					g_array_append_val (priv->search_index, tok);
+				}
+			}
+			if (item->values_ascii != NULL) {
+				tok.rank = j * 2 + 1;
+				tok.score = item->score / 2;
+				for (k = 0; item->values_ascii[k] != NULL; k++) {
+					tok.token = item->values_ascii[k];
+					g_array_append_val (priv->search_index, tok);
+				}
+			}
+		}
+	}
+	g_array_sort (priv->search_index, as_store_search_token_sort_cb);
+	priv->search_index_valid = TRUE;
+	priv->fuzzy_index_valid = FALSE;
+}
+
+/**
+ * as_store_search_term:
+ *
+ * Returns a hash of AsApp to the score of the best AsStoreSearchToken for
+ * the term, leaving out the applications where that scores zero.
+ **/
+static GHashTable *
+as_store_search_term (AsStore *store, const gchar *search)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSearchToken *best;
+	AsStoreSearchToken *tok;
+	GHashTable *scores;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	guint lower = 0;
+	guint mid;
+	guint upper = priv->search_index->len;
+	_cleanup_hashtable_unref_ GHashTable *hash = NULL;
+
+	/* find the first token that is not less than the term */
+	while (lower < upper) {
+		mid = lower + (upper - lower) / 2;
+		tok = &g_array_index (priv->search_index, AsStoreSearchToken, mid);
+		if (g_strcmp0 (tok->token, search) < 0)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	/* all the tokens with this prefix follow it */
+	hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (; lower < priv->search_index->len; lower++) {
+		tok = &g_array_index (priv->search_index, AsStoreSearchToken, lower);
+		if (!g_str_has_prefix (tok->token, search))
+			break;
+		best = g_hash_table_lookup (hash, tok->app);
+		if (best == NULL || tok->rank < best->rank)
+			g_hash_table_insert (hash, tok->app, tok);
+	}
+
+	scores = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_hash_table_iter_init (&iter, hash);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		tok = (AsStoreSearchToken *) value;
+		if (tok->score == 0)
+			continue;
+		g_hash_table_insert (scores, key, GUINT_TO_POINTER (tok->score));
+	}
+	return scores;
+}
+
+/**
+ * as_store_fuzzy_trigram:
+ *
+ * Gets the key for three characters, which is exact if they are all below
+ * U+0400 and is otherwise a hash. A hash collision can only add candidates
+ * that are then rejected by the edit distance.
+ **/
+static gpointer
+as_store_fuzzy_trigram (gunichar a, gunichar b, gunichar c)
+{
+	if (a < 0x400 && b < 0x400 && c < 0x400)
+		return GUINT_TO_POINTER ((a << 20) | (b << 10) | c);
+	return GUINT_TO_POINTER (((a * 0x9e3779b1u) ^
+				  (b * 0x85ebca6bu) ^
+				  (c * 0xc2b2ae35u)) | 0x80000000u);
+}
+
+/**
+ * as_store_fuzzy_index_add:
+ **/
+static void
+as_store_fuzzy_index_add (GHashTable *trigrams, gpointer trigram, guint idx)
+{
+	GArray *posting;
+
+	posting = g_hash_table_lookup (trigrams, trigram);
+	if (posting == NULL) {
+		posting = g_array_new (FALSE, FALSE, sizeof (guint));
+		g_hash_table_insert (trigrams, trigram, posting);
+	}
+
+	/* a token may contain the same trigram more than once */
+	if (posting->len > 0 &&
+	    g_array_index (posting, guint, posting->len - 1) == idx)
+		return;
+	g_array_append_val (posting, idx);
+}
+
+/**
+ * as_store_fuzzy_index_ensure:
+ *
+ * Lists each different search token once, and records which of them
+ * contain each trigram. The first trigram of every token starts with a
+ * space, so that terms only match at the start of a token.
+ **/
+static void
+as_store_fuzzy_index_ensure (AsStore *store)
+{
+	AsStoreFuzzyToken ftok;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSearchToken *tok;
+	const gchar *tmp;
+	gunichar c[3];
+	guint i;
+	guint idx;
+
+	/* already valid */
+	if (priv->fuzzy_index_valid)
+		return;
+
+	g_array_set_size (priv->fuzzy_tokens, 0);
+	g_hash_table_remove_all (priv->fuzzy_trigrams);
+
+	/* the search index is sorted, so equal tokens are next to each other */
+	for (i = 0; i < priv->search_index->len; i = ftok.end) {
+		tok = &g_array_index (priv->search_index, AsStoreSearchToken, i);
+		ftok.token = tok->token;
+		ftok.start = i;
+		for (ftok.end = i + 1; ftok.end < priv->search_index->len; ftok.end++) {
+			tok = &g_array_index (priv->search_index,
+					      AsStoreSearchToken, ftok.end);
+			if (g_strcmp0 (tok->token, ftok.token) != 0)
+				break;
+		}
+		idx = priv->fuzzy_tokens->len;
+		g_array_append_val (priv->fuzzy_tokens, ftok);
+
+		/* each trigram is of characters rather than bytes */
+		if (ftok.token[0] == '\0')
+			continue;
+		c[0] = ' ';
+		c[1] = g_utf8_get_char (ftok.token);
+		for (tmp = g_utf8_next_char (ftok.token);
+		     *tmp != '\0';
+		     tmp = g_utf8_next_char (tmp)) {
+			c[2] = g_utf8_get_char (tmp);
+			as_store_fuzzy_index_add (priv->fuzzy_trigrams,
+						  as_store_fuzzy_trigram (c[0], c[1], c[2]),
+						  idx);
+			c[0] = c[1];
+			c[1] = c[2];
+		}
+	}
+	priv->fuzzy_index_valid = TRUE;
+}
+
+/**
+ * as_store_fuzzy_distance:
+ *
+ * Returns the smallest number of single character edits needed to turn
+ * the term into the start of @token, or more than @max_edits if it cannot
+ * be done with that many.
+ **/
+static guint
+as_store_fuzzy_distance (const gunichar *search,
+			 guint search_len,
+			 const gchar *token,
+			 guint max_edits)
+{
+	const gchar *tmp;
+	gunichar chars[AS_STORE_FUZZY_TERM_MAX];
+	guint prev[AS_STORE_FUZZY_TERM_MAX + 1];
+	guint row[AS_STORE_FUZZY_TERM_MAX + 1];
+	guint best;
+	guint cost;
+	guint i, j;
+	guint len = 0;
+	guint row_min;
+
+	/* only the start of the token can match */
+	for (tmp = token;
+	     *tmp != '\0' && len < search_len + max_edits;
+	     tmp = g_utf8_next_char (tmp))
+		chars[len++] = g_utf8_get_char (tmp);
+
+	for (j = 0; j <= len; j++)
+		prev[j] = j;
+	for (i = 1; i <= search_len; i++) {
+		row[0] = i;
+		row_min = i;
+		for (j = 1; j <= len; j++) {
+			cost = search[i - 1] == chars[j - 1] ? 0 : 1;
+			row[j] = MIN (MIN (prev[j], row[j - 1]) + 1,
+				      prev[j - 1] + cost);
+			row_min = MIN (row_min, row[j]);
+		}
+
+		/* the following rows can only be worse */
+		if (row_min > max_edits)
+			return max_edits + 1;
+		memcpy (prev, row, (len + 1) * sizeof (guint));
+	}
+
+	/* the term may match any length of prefix */
+	best = prev[0];
+	for (j = 1; j <= len; j++)
+		best = MIN (best, prev[j]);
+	return best;
+}
+
+/**
+ * as_store_search_term_fuzzy:
+ *
+ * Adds the applications with a token that starts with a slight misspelling
+ * of the term, if they do not already match it exactly. Every edit changes
+ * at most three trigrams, so only the tokens that share enough trigrams
+ * with the term have the edit distance worked out.
+ *
+ * @counts has an entry for each token that must be zero, and is left that
+ * way so it can be used for the next term.
+ **/
+static void
+as_store_search_term_fuzzy (AsStore *store,
+			    const gchar *search,
+			    guint *counts,
+			    GHashTable *hits)
+{
+	AsStoreFuzzyToken *ftok;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreSearchToken *tok;
+	GArray *posting;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer trigram;
+	gpointer value;
+	glong search_len;
+	guint distance;
+	guint i, j;
+	guint idx;
+	guint max_edits;
+	guint needed;
+	guint pass;
+	guint score;
+	_cleanup_array_unref_ GArray *candidates = NULL;
+	_cleanup_free_ gunichar *search_ucs4 = NULL;
+	_cleanup_hashtable_unref_ GHashTable *fuzzy = NULL;
+
+	/* short terms match too many tokens with any edit */
+	search_ucs4 = g_utf8_to_ucs4_fast (search, -1, &search_len);
+	if (search_len < AS_STORE_FUZZY_TERM_MIN ||
+	    search_len > AS_STORE_FUZZY_TERM_MAX - 2)
+		return;
+	max_edits = search_len >= 8 ? 2 : 1;
+	needed = search_len - 1 > 3 * max_edits ? search_len - 1 - 3 * max_edits : 1;
+
+	/* count the trigrams each token shares with the term, and then
+	 * clear just the counts that were used */
+	candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i + 1 < (guint) search_len; i++) {
+			trigram = as_store_fuzzy_trigram (i > 0 ? search_ucs4[i - 1] : ' ',
+							  search_ucs4[i],
+							  search_ucs4[i + 1]);
+			posting = g_hash_table_lookup (priv->fuzzy_trigrams, trigram);
+			if (posting == NULL)
+				continue;
+			for (j = 0; j < posting->len; j++) {
+				idx = g_array_index (posting, guint, j);
+				if (pass > 0)
+					counts[idx] = 0;
+				else if (++counts[idx] == needed)
+					g_array_append_val (candidates, idx);
+			}
+		}
+	}
+
+	/* a match with more edits gets a lower score */
+	fuzzy = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (i = 0; i < candidates->len; i++) {
+		idx = g_array_index (candidates, guint, i);
+		ftok = &g_array_index (priv->fuzzy_tokens, AsStoreFuzzyToken, idx);
+		distance = as_store_fuzzy_distance (search_ucs4, search_len,
+						    ftok->token, max_edits);
+		if (distance == 0 || distance > max_edits)
+			continue;
+		for (j = ftok->start; j < ftok->end; j++) {
+			tok = &g_array_index (priv->search_index,
+					      AsStoreSearchToken, j);
+			score = tok->score / (distance + 1);
+			if (score == 0 || g_hash_table_contains (hits, tok->app))
+				continue;
+			value = g_hash_table_lookup (fuzzy, tok->app);
+			if (score > GPOINTER_TO_UINT (value)) {
+				g_hash_table_insert (fuzzy, tok->app,
+						     GUINT_TO_POINTER (score));
+			}
+		}
+	}
+	g_hash_table_iter_init (&iter, fuzzy);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_hash_table_insert (hits, key, value);
+}
+
+/**
+ * as_store_search_sort_cb:
+ **/
+static gint
+as_store_search_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	AsApp *app1 = *(AsApp **) a;
+	AsApp *app2 = *(AsApp **) b;
+	GHashTable *results = (GHashTable *) user_data;
+	guint score1;
+	guint score2;
+
+	score1 = GPOINTER_TO_UINT (g_hash_table_lookup (results, app1));
+	score2 = GPOINTER_TO_UINT (g_hash_table_lookup (results, app2));
+	if (score1 != score2)
+		return score1 < score2 ? 1 : -1;
+	return g_strcmp0 (as_app_get_id_full (app1), as_app_get_id_full (app2));
+}
+
+/**
+ * as_store_search_full:
+ * @store: a #AsStore instance.
+ * @search: the search terms.
+ * @flags: the #AsStoreSearchFlags to use, e.g. %AS_STORE_SEARCH_FLAG_FUZZY
+ *
+ * Finds all the applications in the store that match all the search terms.
+ *
+ * Each term is matched as a prefix against the same tokens and with the same
+ * score as as_app_search_matches_all(), but the store keeps a sorted index
+ * of all the tokens so the applications do not have to be checked in turn.
+ *
+ * With %AS_STORE_SEARCH_FLAG_FUZZY, terms of four or more characters also
+ * match tokens that start with the term misspelled by one edit, or by two
+ * edits for terms of eight or more characters. These matches have a lower
+ * score than exact matches, and are found using an index of the trigrams
+ * in each token so that only a few tokens have to be compared in full.
+ *
+ * The indexes are rebuilt the first time the store is searched after an
+ * application has been added or removed.
+ *
+ * Returns: (element-type AsApp) (transfer container): the matching
+ * applications, with the best match first
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_store_search_full (AsStore *store, gchar **search, AsStoreSearchFlags flags)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	GPtrArray *array;
+	gpointer key;
+	gpointer value;
+	guint i;
+	guint score;
+	_cleanup_free_ guint *counts = NULL;
+	_cleanup_hashtable_unref_ GHashTable *results = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), NULL);
+
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	if (search == NULL || search[0] == NULL)
+		return array;
+
+	/* the trigram counts are shared by all the terms */
+	as_store_search_index_ensure (store);
+	if (flags & AS_STORE_SEARCH_FLAG_FUZZY) {
+		as_store_fuzzy_index_ensure (store);
+		counts = g_new0 (guint, priv->fuzzy_tokens->len);
+	}
+
+	/* do *all* search keywords match */
+	for (i = 0; search[i] != NULL; i++) {
+		_cleanup_hashtable_unref_ GHashTable *hits = NULL;
+		hits = as_store_search_term (store, search[i]);
+		if (flags & AS_STORE_SEARCH_FLAG_FUZZY)
+			as_store_search_term_fuzzy (store, search[i], counts, hits);
+
+		/* the first term decides the candidates */
+		if (results == NULL) {
+			results = g_hash_table_ref (hits);
+			continue;
+		}
+
+		/* remove any candidates that do not match this term */
+		g_hash_table_iter_init (&iter, results);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			score = GPOINTER_TO_UINT (g_hash_table_lookup (hits, key));
+			if (score == 0) {
+				g_hash_table_iter_remove (&iter);
+				continue;
+			}
+			g_hash_table_iter_replace (&iter,
+						   GUINT_TO_POINTER (GPOINTER_TO_UINT (value) +
+								     score));
+		}
+	}
+
+	/* best match first */
+	g_hash_table_iter_init (&iter, results);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		app = AS_APP (key);
+		g_ptr_array_add (array, g_object_ref (app));
+	}
+	g_ptr_array_sort_with_data (array, as_store_search_sort_cb, results);
+	return array;
+}
+
+/**
+ * as_store_search:
+ * @store: a #AsStore instance.
+ * @search: the search terms.
+ *
+ * Finds all the applications in the store that match all the search terms,
+ * as as_store_search_full() does with no flags.
+ *
+ * Returns: (element-type AsApp) (transfer container): the matching
+ * applications, with the best match first
+ *
+ * Since: 0.1.8
+ **/
+GPtrArray *
+as_store_search (AsStore *store, gchar **search)
+{
+	return as_store_search_full (store, search, AS_STORE_SEARCH_FLAG_NONE);
+}
+
+/**
+ * as_store_shadowed_add:
+ *
+ * Keeps an application loaded from a file that lost to another with the
+ * same ID, so that it can be used again if the other file is removed.
+ **/
+static void
+as_store_shadowed_add (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *apps;
+	const gchar *id;
+
+	if (as_app_get_source_file (app) == NULL)
+		return;
+	id = as_app_get_id_full (app);
+	apps = g_hash_table_lookup (priv->hash_shadowed, id);
+	if (apps == NULL) {
+		apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+		g_hash_table_insert (priv->hash_shadowed, g_strdup (id), apps);
+	}
+	g_ptr_array_add (apps, g_object_ref (app));
+}
+
+/**
+ * as_store_shadowed_remove_file:
+ **/
+static void
+as_store_shadowed_remove_file (AsStore *store, const gchar *filename)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	GPtrArray *apps;
+	guint i;
+
+	g_hash_table_iter_init (&iter, priv->hash_shadowed);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &apps)) {
+		for (i = apps->len; i > 0; i--) {
+			app = g_ptr_array_index (apps, i - 1);
+			if (g_strcmp0 (as_app_get_source_file (app), filename) == 0)
+				g_ptr_array_remove_index (apps, i - 1);
+		}
+		if (apps->len == 0)
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
+/**
+ * as_store_shadowed_restore:
+ *
+ * Adds back the highest priority application that lost to one that has
+ * just been removed, returning it, or %NULL if there was none.
+ **/
+static AsApp *
+as_store_shadowed_restore (AsStore *store, const gchar *id)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *apps;
+	guint best = 0;
+	guint i;
+	_cleanup_free_ gchar *key = NULL;
+	_cleanup_object_unref_ AsApp *app_best = NULL;
+
+	if (g_hash_table_lookup (priv->hash_id, id) != NULL)
+		return NULL;
+	apps = g_hash_table_lookup (priv->hash_shadowed, id);
+	if (apps == NULL)
+		return NULL;
+	for (i = 1; i < apps->len; i++) {
+		app = g_ptr_array_index (apps, i);
+		if (as_app_get_priority (app) >
+		    as_app_get_priority (g_ptr_array_index (apps, best)))
+			best = i;
+	}
+	app_best = g_object_ref (g_ptr_array_index (apps, best));
+	g_ptr_array_remove_index (apps, best);
+	key = g_strdup (id);
+	if (apps->len == 0)
+		g_hash_table_remove (priv->hash_shadowed, key);
+	as_store_add_app (store, app_best);
+	return g_hash_table_lookup (priv->hash_id, key);
+}
+
+/**
+ * as_store_remove_app:
+ * @store: a #AsStore instance.
+ * @app: a #AsApp instance.
+ *
+ * Removes an application from the store if it exists.
+ *
+ * The last application in the store is moved into the place of the removed
+ * one, so this takes the same time however large the store is. This means
+ * the order of as_store_get_apps() is not kept.
+ *
+ * Since: 0.1.0
+ **/
+void
+as_store_remove_app (AsStore *store, AsApp *app)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+
+	g_return_if_fail (AS_IS_STORE (store));
+
+	if (!g_hash_table_contains (priv->hash_position, app))
+		return;
+	as_store_pkgnames_remove (store, app);
+	if (g_hash_table_lookup (priv->hash_id, as_app_get_id_full (app)) == app)
+		g_hash_table_remove (priv->hash_id, as_app_get_id_full (app));
+	as_store_unindex_app (store, app);
+	as_store_sorted_remove (store, app);
+	priv->search_index_valid = FALSE;
+
+	/* this may drop the last reference */
+	as_store_array_remove (store, app);
+}
+
+/**
+ * as_store_add_app:
+ * @store: a #AsStore instance.
+ * @app: a #AsApp instance.
+ *
+ * Adds an application to the store. If a lower priority application has already
+ * been added then this new application will replace it.
+ *
+ * Additionally only applications where the kind is known will be added.
+ *
+ * Since: 0.1.0
+ **/
+void
+as_store_add_app (AsStore *store, AsApp *app)
+{
+	AsApp *item;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	const gchar *id;
+
+	/* have we recorded this before? */
+	id = as_app_get_id_full (app);
+	if (id == NULL) {
+		g_warning ("application has no ID set");
+		return;
+	}
+	priv->search_index_valid = FALSE;
+	item = g_hash_table_lookup (priv->hash_id, id);
+	if (item != NULL) {
+
+		/* the previously stored app is higher priority */
+		if (as_app_get_priority (item) >
+		    as_app_get_priority (app)) {
+			g_debug ("ignoring duplicate AppStream entry: %s", id);
+			as_store_shadowed_add (store, app);
+			return;
+		}
+
+		/* same priority */
+		if (as_app_get_priority (item) ==
+		    as_app_get_priority (app)) {
+			g_debug ("merging duplicate AppStream entries: %s", id);
+			as_app_subsume_full (item, app,
+					     AS_APP_SUBSUME_FLAG_BOTH_WAYS);
+			as_store_shadowed_add (store, app);
+
+			/* the merged application may have new keys */
+			as_store_pkgnames_add (store, item);
+			if (priv->indexes_valid) {
+				as_store_unindex_app (store, item);
+				as_store_index_app (store, item);
+			}
+			as_store_sorted_remove (store, item);
+			as_store_sorted_add (store, item);
+			return;
+		}
+
+		/* this new item has a higher priority than the one we've
+		 * previously stored */
+		g_debug ("replacing duplicate AppStream entry: %s", id);
+		as_store_shadowed_add (store, item);
+		g_hash_table_remove (priv->hash_id, id);
+		as_store_pkgnames_remove (store, item);
+		as_store_unindex_app (store, item);
+		as_store_sorted_remove (store, item);
+		as_store_array_replace (store, item, app);
+	} else {
+		as_store_array_add (store, app);
+	}
+
+	/* success */
+	g_hash_table_insert (priv->hash_id,
+			     (gpointer) as_app_get_id_full (app),
+			     app);
+	as_store_pkgnames_add (store, app);
+	if (priv->indexes_valid)
+		as_store_index_app (store, app);
+	as_store_sorted_add (store, app);
+}
+
+/**
+ * as_store_match_addons:
+ **/
+static void
+as_store_match_addons (AsStore *store)
+{
+	AsApp *app;
+	AsApp *parent;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *plugin_ids;
+	const gchar *tmp;
+	guint i;
+	guint j;
+
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		if (as_app_get_id_kind (app) != AS_ID_KIND_ADDON)
+			continue;
+		plugin_ids = as_app_get_extends (app);
+		if (plugin_ids->len == 0) {
+			g_warning ("%s was of type plugin but had no plugin_for",
+				   as_app_get_id_full (app));
+			continue;
+		}
+		for (j = 0; j < plugin_ids->len; j++) {
+			tmp = g_ptr_array_index (plugin_ids, j);
+			parent = g_hash_table_lookup (priv->hash_id, tmp);
+			if (parent == NULL) {
+				g_warning ("%s had no parent of '%s'",
+					   as_app_get_id_full (app), tmp);
+				continue;
+			}
+			as_app_add_addon (parent, app);
+		}
+	}
+}
+
+/**
+ * as_store_set_header:
+ **/
+static void
+as_store_set_header (AsStore *store,
+		     const gchar *version,
+		     const gchar *origin,
+		     const gchar *icon_root,
+		     gchar **icon_path)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+
+	/* get version */
+	if (version != NULL)
+		priv->api_version = g_ascii_strtod (version, NULL);
+
+	/* set in the XML file */
+	if (origin != NULL)
+		as_store_set_origin (store, origin);
+
+	/* if we have an origin either from the XML or _set_origin() */
+	if (priv->origin != NULL) {
+		if (icon_root == NULL)
+			icon_root = "/usr/share/app-info/icons/";
+		*icon_path = g_build_filename (icon_root,
+					       priv->origin,
+					       NULL);
+	}
+}
+
+/**
+ * as_store_from_node:
+ **/
+static gboolean
+as_store_from_node (AsStore *store,
+		    GNode *n,
+		    const gchar *icon_path,
+		    const gchar *source_file,
+		    GError **error)
+{
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_object_unref_ AsApp *app = NULL;
+
+	app = as_app_new ();
+	if (icon_path != NULL)
+		as_app_set_icon_path (app, icon_path, -1);
+	as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
+	as_app_set_source_file (app, source_file);
+	if (!as_app_node_parse (app, n, &error_local)) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to parse root: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	as_store_add_app (store, app);
+	return TRUE;
+}
+
+/**
+ * as_store_find_apps_node:
+ **/
+static GNode *
+as_store_find_apps_node (GNode *root, GError **error)
+{
+	GNode *apps;
+
+	apps = as_node_find_tag (root, AS_TAG_APPLICATIONS);
+	if (apps != NULL)
+		return apps;
+	apps = as_node_find (root, "applications");
+	if (apps != NULL)
+		return apps;
+	g_set_error_literal (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "No valid root node specified");
+	return NULL;
+}
+
+/**
+ * as_store_from_root:
+ **/
+static gboolean
+as_store_from_root (AsStore *store,
+		    GNode *root,
+		    const gchar *icon_root,
+		    GError **error)
+{
+	GNode *apps;
+	GNode *n;
+	_cleanup_free_ gchar *icon_path = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+
+	apps = as_store_find_apps_node (root, error);
+	if (apps == NULL)
+		return FALSE;
+	as_store_set_header (store,
+			     as_node_get_attribute (apps, "version"),
+			     as_node_get_attribute (apps, "origin"),
+			     icon_root, &icon_path);
+	for (n = apps->children; n != NULL; n = n->next) {
+		if (as_node_get_tag (n) != AS_TAG_APPLICATION)
+			continue;
+		if (!as_store_from_node (store, n, icon_path, NULL, error))
+			return FALSE;
+	}
+
+	/* add addon kinds to their parent AsApp */
+	as_store_match_addons (store);
+
+	return TRUE;
+}
+
+typedef struct {
+	AsStore		*store;
+	const gchar	*icon_root;
+	gchar		*icon_path;
+	gchar		*source_file;
+	gboolean	 got_header;
+} AsStoreStreamHelper;
+
+/**
+ * as_store_stream_component_cb:
+ **/
+static void
+as_store_stream_component_cb (GNode *node, gpointer user_data, GError **error)
+{
+	AsStoreStreamHelper *helper = (AsStoreStreamHelper *) user_data;
+	GNode *apps = node->parent;
+
+	/* the root attributes are complete before the first child */
+	if (!helper->got_header) {
+		if (g_strcmp0 (as_node_get_name (apps), "components") != 0 &&
+		    g_strcmp0 (as_node_get_name (apps), "applications") != 0) {
+			g_set_error_literal (error,
+					     AS_STORE_ERROR,
+					     AS_STORE_ERROR_FAILED,
+					     "No valid root node specified");
+			return;
+		}
+		as_store_set_header (helper->store,
+				     as_node_get_attribute (apps, "version"),
+				     as_node_get_attribute (apps, "origin"),
+				     helper->icon_root,
+				     &helper->icon_path);
+		helper->got_header = TRUE;
+	}
+	as_store_from_node (helper->store, node,
+			    helper->icon_path,
+			    helper->source_file,
+			    error);
+}
+
+/**
+ * as_store_from_file:
+ * @store: a #AsStore instance.
+ * @file: a #GFile.
+ * @icon_root: the icon path, or %NULL for the default.
+ * @cancellable: a #GCancellable.
+ * @error: A #GError or %NULL.
+ *
+ * Parses an AppStream XML file and adds any valid applications to the store.
+ *
+ * The file is parsed incrementally, and each application is added to the
+ * store as soon as it has been read, so the whole document is never held
+ * in memory.
+ *
+ * If the root node does not have a 'origin' attribute, then the method
+ * as_store_set_origin() should be called *before* this function if cached
+ * icons are required.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+as_store_from_file (AsStore *store,
+		    GFile *file,
+		    const gchar *icon_root,
+		    GCancellable *cancellable,
+		    GError **error)
+{
+	AsStoreStreamHelper helper;
+	GNode *apps;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_free_ gchar *icon_path = NULL;
+	_cleanup_free_ gchar *source_file = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+
+	source_file = g_file_get_path (file);
+	helper.store = store;
+	helper.icon_root = icon_root;
+	helper.icon_path = NULL;
+	helper.source_file = source_file;
+	helper.got_header = FALSE;
+	root = as_node_from_file_streaming (file,
+					    AS_NODE_FROM_XML_FLAG_LITERAL_TEXT |
+					    AS_NODE_FROM_XML_FLAG_ARENA,
+					    as_store_stream_component_cb,
+					    &helper,
+					    cancellable,
+					    &error_local);
+	icon_path = helper.icon_path;
+	if (root == NULL) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to parse file: %s",
+			     error_local->message);
+		return FALSE;
+	}
+
+	/* no components, but the root attributes are still used */
+	if (!helper.got_header) {
+		apps = as_store_find_apps_node (root, error);
+		if (apps == NULL)
+			return FALSE;
+		as_store_set_header (store,
+				     as_node_get_attribute (apps, "version"),
+				     as_node_get_attribute (apps, "origin"),
+				     icon_root, &icon_path);
+	}
+
+	/* add addon kinds to their parent AsApp */
+	as_store_match_addons (store);
+
+	return TRUE;
+}
+
+/**
+ * as_store_from_xml:
+ * @store: a #AsStore instance.
+ * @data: XML data
+ * @data_len: Length of @data, or -1 if NULL terminated
+ * @icon_root: the icon path, or %NULL for the default.
+ * @error: A #GError or %NULL.
+ *
+ * Parses AppStream XML file and adds any valid applications to the store.
+ *
+ * If the root node does not have a 'origin' attribute, then the method
+ * as_store_set_origin() should be called *before* this function if cached
+ * icons are required.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.1
+ **/
+gboolean
+as_store_from_xml (AsStore *store,
+		   const gchar *data,
+		   gssize data_len,
+		   const gchar *icon_root,
+		   GError **error)
+{
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+
+	root = as_node_from_xml (data, data_len,
+				 AS_NODE_FROM_XML_FLAG_LITERAL_TEXT |
+				 AS_NODE_FROM_XML_FLAG_ARENA,
+				 &error_local);
+	if (root == NULL) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to parse XML: %s",
+			     error_local->message);
+		return TRUE;
+	}
+	return as_store_from_root (store, root, icon_root, error);
+}
+
+/**
+ * as_store_node_new:
+ *
+ * Creates the root node and the empty applications node.
+ **/
+static GNode *
+as_store_node_new (AsStore *store, GNode **node_apps)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GNode *node_root;
+	gchar version[6];
+
+	node_root = as_node_new ();
+	if (priv->api_version >= 0.6) {
+		*node_apps = as_node_insert (node_root, "components", NULL, 0, NULL);
+	} else {
+		*node_apps = as_node_insert (node_root, "applications", NULL, 0, NULL);
+	}
+
+	/* set origin attribute */
+	if (priv->origin != NULL)
+		as_node_add_attribute (*node_apps, "origin", priv->origin, -1);
+
+	/* set version attribute */
+	if (priv->api_version > 0.1f) {
+		g_ascii_formatd (version, sizeof (version),
+				 "%.1f", priv->api_version);
+		as_node_add_attribute (*node_apps, "version", version, -1);
+	}
+	return node_root;
+}
+
+/**
+ * as_store_write_sort_cb:
+ **/
+static gint
+as_store_write_sort_cb (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	AsApp *app1 = *((AsApp **) a);
+	AsApp *app2 = *((AsApp **) b);
+	AsStorePrivate *priv = GET_PRIVATE (AS_STORE (user_data));
+	gint rc;
+
+	rc = g_strcmp0 (as_app_get_id (app1), as_app_get_id (app2));
+	if (rc != 0)
+		return rc;
+	return GPOINTER_TO_UINT (g_hash_table_lookup (priv->hash_sequence, app1)) <
+	       GPOINTER_TO_UINT (g_hash_table_lookup (priv->hash_sequence, app2)) ? -1 : 1;
+}
+
+/**
+ * as_store_write_apps_new:
+ *
+ * Gets a copy of the applications sorted by ID, so that writing the store
+ * does not reorder it or need the sorted views to be kept up to date.
+ **/
+static GPtrArray *
+as_store_write_apps_new (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GPtrArray *apps;
+
+	apps = g_ptr_array_sized_new (priv->array->len);
+	g_ptr_array_set_size (apps, priv->array->len);
+	memcpy (apps->pdata, priv->array->pdata,
+		priv->array->len * sizeof (gpointer));
+	g_ptr_array_sort_with_data (apps, as_store_write_sort_cb, store);
+	return apps;
+}
+
+/* the number of applications converted in parallel before being written */
+#define AS_STORE_WRITE_BATCH_SIZE	1024
+
+typedef struct {
+	GMutex		 mutex;
+	GCond		 cond;
+	guint		 pending;
+	gdouble		 api_version;
+	AsNodeToXmlFlags flags;
+} AsStoreWriteHelper;
+
+typedef struct {
+	AsApp		*app;
+	GString		*xml;
+} AsStoreWriteItem;
+
+/**
+ * as_store_write_item_thread_cb:
+ **/
+static void
+as_store_write_item_thread_cb (gpointer data, gpointer user_data)
+{
+	AsStoreWriteItem *item = (AsStoreWriteItem *) data;
+	AsStoreWriteHelper *helper = (AsStoreWriteHelper *) user_data;
+	GNode *node_apps;
+	GNode *n;
+	_cleanup_node_unref_ GNode *node_root = NULL;
+
+	/* each thread needs its own tree at the same depth; the state shared
+	 * with the other workers is the interned strings and the arena table,
+	 * each of which has its own lock, and the elements parsed on demand
+	 * for lazily loaded applications, which are guarded by the lazy mutex
+	 * in as-app.c -- nothing else in the application may be changed while
+	 * the store is being written */
+	node_root = as_node_new ();
+	node_apps = as_node_insert (node_root, "components", NULL, 0, NULL);
+	n = as_app_node_insert (item->app, node_apps, helper->api_version);
+	item->xml = g_string_sized_new (4 * 1024);
+	as_node_to_xml_append (item->xml, n, helper->flags);
+
+	g_mutex_lock (&helper->mutex);
+	if (--helper->pending == 0)
+		g_cond_signal (&helper->cond);
+	g_mutex_unlock (&helper->mutex);
+}
+
+/**
+ * as_store_render_apps:
+ *
+ * Appends the XML for the applications from @start up to @end, converting
+ * them in the thread pool if one is supplied.
+ **/
+static void
+as_store_render_apps (AsStore *store,
+		      GPtrArray *apps,
+		      GNode *node_apps,
+		      GThreadPool *pool,
+		      AsStoreWriteHelper *helper,
+		      guint start,
+		      guint end,
+		      GString *xml)
+{
+	AsApp *app;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreWriteItem *items;
+	GNode *n;
+	guint i;
+
+	/* convert in order using the shared tree */
+	if (pool == NULL) {
+		for (i = start; i < end; i++) {
+			app = g_ptr_array_index (apps, i);
+			n = as_app_node_insert (app, node_apps, priv->api_version);
+			as_node_to_xml_append (xml, n, helper->flags);
+			as_node_unref (n);
+		}
+		return;
+	}
+
+	/* convert in any order, then append in sorted order */
+	items = g_new0 (AsStoreWriteItem, end - start);
+	helper->pending = end - start;
+	for (i = start; i < end; i++) {
+		items[i - start].app = g_ptr_array_index (apps, i);
+		if (!g_thread_pool_push (pool, &items[i - start], NULL))
+			as_store_write_item_thread_cb (&items[i - start], helper);
+	}
+	g_mutex_lock (&helper->mutex);
+	while (helper->pending > 0)
+		g_cond_wait (&helper->cond, &helper->mutex);
+	g_mutex_unlock (&helper->mutex);
+	for (i = 0; i < end - start; i++) {
+		g_string_append_len (xml, items[i].xml->str, items[i].xml->len);
+		g_string_free (items[i].xml, TRUE);
+	}
+	g_free (items);
+}
+
+/**
+ * as_store_write_helper_init:
+ **/
+static GThreadPool *
+as_store_write_helper_init (AsStore *store,
+			    AsStoreWriteHelper *helper,
+			    AsNodeToXmlFlags flags)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+
+	g_mutex_init (&helper->mutex);
+	g_cond_init (&helper->cond);
+	helper->pending = 0;
+	helper->api_version = priv->api_version;
+	helper->flags = flags;
+	if ((priv->write_flags & AS_STORE_WRITE_FLAG_PARALLEL) == 0)
+		return NULL;
+	return g_thread_pool_new (as_store_write_item_thread_cb,
+				  helper,
+				  (gint) g_get_num_processors (),
+				  FALSE,
+				  NULL);
+}
+
+/**
+ * as_store_write_helper_clear:
+ **/
+static void
+as_store_write_helper_clear (AsStoreWriteHelper *helper, GThreadPool *pool)
+{
+	if (pool != NULL)
+		g_thread_pool_free (pool, FALSE, TRUE);
+	g_mutex_clear (&helper->mutex);
+	g_cond_clear (&helper->cond);
+}
+
+/**
+ * as_store_to_xml:
+ * @store: a #AsStore instance.
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_INSERT_FLAG_NONE.
+ *
+ * Outputs an XML representation of all the applications in the store.
+ *
+ * If %AS_STORE_WRITE_FLAG_PARALLEL has been set using
+ * as_store_set_write_flags() then the applications are converted in a pool
+ * of threads. The output is identical in either case.
+ *
+ * Returns: A #GString
+ *
+ * Since: 0.1.0
+ **/
+GString *
+as_store_to_xml (AsStore *store, AsNodeToXmlFlags flags)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreWriteHelper helper;
+	GNode *node_apps;
+	GThreadPool *pool;
+	GString *xml;
+	_cleanup_node_unref_ GNode *node_root = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+
+	/* an empty element is written as a single tag */
+	node_root = as_store_node_new (store, &node_apps);
+	if (priv->array->len == 0)
+		return as_node_to_xml (node_root, flags);
+
+	/* get XML text */
+	apps = as_store_write_apps_new (store);
+	pool = as_store_write_helper_init (store, &helper, flags);
+	xml = g_string_new ("");
+	as_node_to_xml_start (xml, node_apps, helper.flags);
+	as_store_render_apps (store, apps, node_apps, pool, &helper,
+			      0, apps->len, xml);
+	as_node_to_xml_end (xml, node_apps, helper.flags);
+	as_store_write_helper_clear (&helper, pool);
+	return xml;
+}
+
+/* the uncompressed size of each independently compressed gzip member */
+#define AS_STORE_GZIP_BLOCK_SIZE	(128 * 1024)
+
+typedef struct {
+	GMutex		 mutex;
+	GCond		 cond;
+	guint		 pending;
+	gint		 level;
+	GThreadPool	*pool;
+} AsStoreGzipHelper;
+
+typedef struct {
+	const gchar	*data;
+	gsize		 data_len;
+	guint8		*out;
+	gsize		 out_len;
+	gboolean	 ret;
+} AsStoreGzipItem;
+
+/**
+ * as_store_gzip_item_thread_cb:
+ *
+ * Compresses one block as a complete gzip member, so that the members can be
+ * produced in any order and then simply concatenated.
+ **/
+static void
+as_store_gzip_item_thread_cb (gpointer data, gpointer user_data)
+{
+	AsStoreGzipItem *item = (AsStoreGzipItem *) data;
+	AsStoreGzipHelper *helper = (AsStoreGzipHelper *) user_data;
+	gsize out_size;
+	z_stream zs;
+
+	memset (&zs, 0, sizeof (zs));
+	if (deflateInit2 (&zs, helper->level, Z_DEFLATED,
+			  MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+		out_size = deflateBound (&zs, item->data_len);
+		item->out = g_malloc (out_size);
+		zs.next_in = (Bytef *) item->data;
+		zs.avail_in = item->data_len;
+		zs.next_out = item->out;
+		zs.avail_out = out_size;
+		item->ret = deflate (&zs, Z_FINISH) == Z_STREAM_END;
+		item->out_len = zs.total_out;
+		deflateEnd (&zs);
+	}
+
+	g_mutex_lock (&helper->mutex);
+	if (--helper->pending == 0)
+		g_cond_signal (&helper->cond);
+	g_mutex_unlock (&helper->mutex);
+}
+
+/**
+ * as_store_write_gzip:
+ *
+ * Compresses all the complete blocks in @xml in parallel and writes them in
+ * order, keeping any partial block for the next call unless @finish is set.
+ **/
+static gboolean
+as_store_write_gzip (GOutputStream *stream,
+		     GString *xml,
+		     AsStoreGzipHelper *helper,
+		     gboolean finish,
+		     GCancellable *cancellable,
+		     GError **error)
+{
+	AsStoreGzipItem *items;
+	gboolean ret = TRUE;
+	gsize consumed = 0;
+	guint nr_blocks;
+	guint i;
+	_cleanup_error_free_ GError *error_local = NULL;
+
+	nr_blocks = xml->len / AS_STORE_GZIP_BLOCK_SIZE;
+	if (finish && xml->len % AS_STORE_GZIP_BLOCK_SIZE != 0)
+		nr_blocks++;
+	if (nr_blocks == 0)
+		return TRUE;
+
+	/* compress each block */
+	items = g_new0 (AsStoreGzipItem, nr_blocks);
+	helper->pending = nr_blocks;
+	for (i = 0; i < nr_blocks; i++) {
+		items[i].data = xml->str + consumed;
+		items[i].data_len = MIN (AS_STORE_GZIP_BLOCK_SIZE, xml->len - consumed);
+		consumed += items[i].data_len;
+		if (!g_thread_pool_push (helper->pool, &items[i], NULL))
+			as_store_gzip_item_thread_cb (&items[i], helper);
+	}
+	g_mutex_lock (&helper->mutex);
+	while (helper->pending > 0)
+		g_cond_wait (&helper->cond, &helper->mutex);
+	g_mutex_unlock (&helper->mutex);
+
+	/* write the members in order */
+	for (i = 0; i < nr_blocks; i++) {
+		if (!items[i].ret) {
+			g_set_error_literal (error,
+					     AS_STORE_ERROR,
+					     AS_STORE_ERROR_FAILED,
+					     "Failed to compress data");
+			ret = FALSE;
+			break;
+		}
+		ret = g_output_stream_write_all (stream,
+						 items[i].out,
+						 items[i].out_len,
+						 NULL, cancellable, &error_local);
+		if (!ret) {
+			g_set_error (error,
+				     AS_STORE_ERROR,
+				     AS_STORE_ERROR_FAILED,
+				     "Failed to write stream: %s",
+				     error_local->message);
+			break;
+		}
+	}
+	for (i = 0; i < nr_blocks; i++)
+		g_free (items[i].out);
+	g_free (items);
+	g_string_erase (xml, 0, consumed);
+	return ret;
+}
+
+/**
+ * as_store_write_xml:
+ *
+ * Writes @xml to @stream, compressing it first if @gzip is set.
+ **/
+static gboolean
+as_store_write_xml (GOutputStream *stream,
+		    GString *xml,
+		    AsStoreGzipHelper *gzip,
+		    gboolean finish,
+		    GCancellable *cancellable,
+		    GError **error)
+{
+	_cleanup_error_free_ GError *error_local = NULL;
+
+	if (gzip != NULL)
+		return as_store_write_gzip (stream, xml, gzip, finish,
+					    cancellable, error);
+	if (!g_output_stream_write_all (stream, xml->str, xml->len,
+					NULL, cancellable, &error_local)) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to write stream: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	g_string_truncate (xml, 0);
+	return TRUE;
+}
+
+/**
+ * as_store_to_stream:
+ *
+ * Writes the XML for each application to @stream as it is generated.
+ **/
+static gboolean
+as_store_to_stream (AsStore *store,
+		    GOutputStream *stream,
+		    AsNodeToXmlFlags flags,
+		    AsStoreGzipHelper *gzip,
+		    GCancellable *cancellable,
+		    GError **error)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreWriteHelper helper;
+	GNode *node_apps;
+	GThreadPool *pool;
+	gboolean ret = TRUE;
+	guint batch;
+	guint i;
+	_cleanup_node_unref_ GNode *node_root = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *apps = NULL;
+	_cleanup_string_free_ GString *xml = NULL;
+
+	node_root = as_store_node_new (store, &node_apps);
+
+	/* an empty element is written as a single tag */
+	if (priv->array->len == 0) {
+		xml = as_node_to_xml (node_root, flags);
+		return as_store_write_xml (stream, xml, gzip, TRUE,
+					   cancellable, error);
+	}
+
+	/* the same buffer is reused for each application, or for each batch
+	 * of applications if converting in parallel */
+	apps = as_store_write_apps_new (store);
+	pool = as_store_write_helper_init (store, &helper, flags);
+	batch = pool != NULL ? AS_STORE_WRITE_BATCH_SIZE : 1;
+	xml = g_string_sized_new (16 * 1024);
+	as_node_to_xml_start (xml, node_apps, helper.flags);
+	for (i = 0; i < apps->len; i += batch) {
+		as_store_render_apps (store, apps, node_apps, pool, &helper, i,
+				      MIN (i + batch, apps->len), xml);
+		ret = as_store_write_xml (stream, xml, gzip, FALSE,
+					  cancellable, error);
+		if (!ret)
+			break;
+	}
+	as_store_write_helper_clear (&helper, pool);
+	if (!ret)
+		return FALSE;
+	as_node_to_xml_end (xml, node_apps, helper.flags);
+	return as_store_write_xml (stream, xml, gzip, TRUE, cancellable, error);
+}
+
+/**
+ * as_store_to_file:
+ * @store: a #AsStore instance.
+ * @file: file
+ * @flags: the AsNodeToXmlFlags, e.g. %AS_NODE_INSERT_FLAG_NONE.
+ * @cancellable: A #GCancellable, or %NULL
+ * @error: A #GError or %NULL
+ *
+ * Outputs a compressed XML file of all the applications in the store.
+ *
+ * Each application is converted and compressed in turn, so the complete
+ * document is never held in memory.
+ *
+ * If %AS_STORE_WRITE_FLAG_COMPRESS_PARALLEL has been set using
+ * as_store_set_write_flags() then the document is
+ * split into blocks which are compressed as independent gzip members in a
+ * pool of threads. The result is a valid gzip file which as_store_from_file()
+ * reads completely, although some other readers such as #GZlibDecompressor
+ * only return the first member, and so this has to be requested explicitly.
+ *
+ * Returns: A #GString
+ *
+ * Since: 0.1.0
+ **/
+gboolean
+as_store_to_file (AsStore *store,
+		  GFile *file,
+		  AsNodeToXmlFlags flags,
+		  GCancellable *cancellable,
+		  GError **error)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	AsStoreGzipHelper gzip;
+	gboolean ret;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_object_unref_ GCancellable *cancellable_abort = NULL;
+	_cleanup_object_unref_ GFileOutputStream *out = NULL;
+	_cleanup_object_unref_ GOutputStream *out2 = NULL;
+	_cleanup_object_unref_ GZlibCompressor *compressor = NULL;
+
+	/* the file is only replaced when the stream is closed */
+	out = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE,
+			      cancellable, &error_local);
+	if (out == NULL) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to write file: %s",
+			     error_local->message);
+		return FALSE;
+	}
+
+	/* compress each block as a separate gzip member */
+	if (priv->write_flags & AS_STORE_WRITE_FLAG_COMPRESS_PARALLEL) {
+		g_mutex_init (&gzip.mutex);
+		g_cond_init (&gzip.cond);
+		gzip.pending = 0;
+		gzip.level = priv->compression_level;
+		gzip.pool = g_thread_pool_new (as_store_gzip_item_thread_cb,
+					       &gzip,
+					       (gint) g_get_num_processors (),
+					       FALSE,
+					       NULL);
+		out2 = g_object_ref (out);
+		ret = as_store_to_stream (store, out2, flags, &gzip,
+					  cancellable, error);
+		g_thread_pool_free (gzip.pool, FALSE, TRUE);
+		g_mutex_clear (&gzip.mutex);
+		g_cond_clear (&gzip.cond);
+
+	/* compress as a single gzip stream */
+	} else {
+		compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP,
+						    priv->compression_level);
+		out2 = g_converter_output_stream_new (G_OUTPUT_STREAM (out),
+						      G_CONVERTER (compressor));
+		ret = as_store_to_stream (store, out2, flags, NULL,
+					  cancellable, error);
+	}
+	if (!ret) {
+		/* closing with a cancelled cancellable keeps the old file */
+		cancellable_abort = g_cancellable_new ();
+		g_cancellable_cancel (cancellable_abort);
+		g_output_stream_close (G_OUTPUT_STREAM (out), cancellable_abort, NULL);
+		return FALSE;
+	}
+	if (!g_output_stream_close (out2, cancellable, &error_local)) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to close stream: %s",
+			     error_local->message);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * as_store_get_origin:
+ * @store: a #AsStore instance.
+ *
+ * Gets the metadata origin, which is used to locate icons.
+ *
+ * Returns: the origin string, or %NULL if unset
+ *
+ * Since: 0.1.1
+ **/
+const gchar *
+as_store_get_origin (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	return priv->origin;
+}
+
+/**
+ * as_store_set_origin:
+ * @store: a #AsStore instance.
+ * @origin: the origin, e.g. "fedora-21"
+ *
+ * Sets the metadata origin, which is used to locate icons.
+ *
+ * Since: 0.1.1
+ **/
+void
+as_store_set_origin (AsStore *store, const gchar *origin)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_free (priv->origin);
+	priv->origin = g_strdup (origin);
+}
+
+/**
+ * as_store_get_api_version:
+ * @store: a #AsStore instance.
+ *
+ * Gets the AppStream API version.
+ *
+ * Returns: the #AsNodeInsertFlags, or 0 if unset
+ *
+ * Since: 0.1.1
+ **/
+gdouble
+as_store_get_api_version (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	return priv->api_version;
+}
+
+/**
+ * as_store_set_api_version:
+ * @store: a #AsStore instance.
+ * @api_version: the API version
+ *
+ * Sets the AppStream API version.
+ *
+ * Since: 0.1.1
+ **/
+void
+as_store_set_api_version (AsStore *store, gdouble api_version)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	priv->api_version = api_version;
+}
+
+/**
+ * as_store_get_compression_level:
+ * @store: a #AsStore instance.
+ *
+ * Gets the zlib compression level used when writing files.
+ *
+ * Returns: the level from 0 to 9, or -1 for the zlib default
+ *
+ * Since: 0.1.8
+ **/
+gint
+as_store_get_compression_level (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	return priv->compression_level;
+}
+
+/**
+ * as_store_set_compression_level:
+ * @store: a #AsStore instance.
+ * @level: the level from 0 to 9, or -1 for the zlib default
+ *
+ * Sets the zlib compression level used by as_store_to_file().
+ * Lower levels are faster but produce larger files.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_store_set_compression_level (AsStore *store, gint level)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	g_return_if_fail (level >= -1 && level <= 9);
+	priv->compression_level = level;
+}
+
+/**
+ * as_store_get_write_flags:
+ * @store: a #AsStore instance.
+ *
+ * Gets the flags used when writing the store.
+ *
+ * Returns: the #AsStoreWriteFlags, e.g. %AS_STORE_WRITE_FLAG_NONE
+ *
+ * Since: 0.1.8
+ **/
+AsStoreWriteFlags
+as_store_get_write_flags (AsStore *store)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	return priv->write_flags;
+}
+
+/**
+ * as_store_set_write_flags:
+ * @store: a #AsStore instance.
+ * @flags: the #AsStoreWriteFlags, e.g. %AS_STORE_WRITE_FLAG_PARALLEL
+ *
+ * Sets the flags used by as_store_to_xml() and as_store_to_file().
+ *
+ * When writing in parallel the applications in the store must not be
+ * modified by other threads until the write has finished.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_store_set_write_flags (AsStore *store, AsStoreWriteFlags flags)
+{
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	priv->write_flags = flags;
+}
+
+/**
+ * as_store_guess_origin_fallback:
+ */
+static gboolean
+as_store_guess_origin_fallback (AsStore *store,
+				const gchar *filename,
+				GError **error)
+{
+	gchar *tmp;
+	_cleanup_free_ gchar *origin_fallback;
+
+	/* the first component of the file (e.g. "fedora-20.xml.gz)
+	 * is used for the icon directory as we might want to clean up
+	 * the icons manually if they are installed in /var/cache */
+	origin_fallback = g_path_get_basename (filename);
+	tmp = g_strstr_len (origin_fallback, -1, ".xml");
+	if (tmp == NULL) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "AppStream metadata name %s not valid, "
+			     "expected .xml[.*]",
+			     filename);
+		return FALSE;
+	}
+	tmp[0] = '\0';
+
+	/* load this specific file */
+	as_store_set_origin (store, origin_fallback);
+	return TRUE;
+}
+
+/**
+ * as_store_cache_get_filename:
+ **/
+static gchar *
+as_store_cache_get_filename (const gchar *filename)
+{
+	_cleanup_free_ gchar *basename = NULL;
+	_cleanup_free_ gchar *checksum = NULL;
+
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, filename, -1);
+	basename = g_strdup_printf ("%s.cache", checksum);
+	return g_build_filename (g_get_user_cache_dir (),
+				 "appstream-glib",
+				 basename,
+				 NULL);
+}
+
+typedef struct {
+	gchar		*filename;
+	AsStoreLoadFlags flags;
+	gchar		*version;
+	gchar		*origin;
+	gboolean	 got_header;
+	GPtrArray	*apps;		/* of AsApp */
+	GVariantBuilder	*cache;
+	GError		*error;
+} AsStoreLoadItem;
+
+/**
+ * as_store_load_item_new:
+ **/
+static AsStoreLoadItem *
+as_store_load_item_new (const gchar *filename, AsStoreLoadFlags flags)
+{
+	AsStoreLoadItem *item;
+	item = g_slice_new0 (AsStoreLoadItem);
+	item->filename = g_strdup (filename);
+	item->flags = flags;
+	item->apps = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	return item;
+}
+
+/**
+ * as_store_load_item_free:
+ **/
+static void
+as_store_load_item_free (AsStoreLoadItem *item)
+{
+	g_free (item->filename);
+	g_free (item->version);
+	g_free (item->origin);
+	g_ptr_array_unref (item->apps);
+	if (item->cache != NULL)
+		g_variant_builder_unref (item->cache);
+	if (item->error != NULL)
+		g_error_free (item->error);
+	g_slice_free (AsStoreLoadItem, item);
+}
+
+/**
+ * as_store_load_item_component_cb:
+ **/
+static void
+as_store_load_item_component_cb (GNode *node, gpointer user_data, GError **error)
+{
+	AsStoreLoadItem *item = (AsStoreLoadItem *) user_data;
+	GNode *apps;
+	gboolean ret;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_object_unref_ AsApp *app = NULL;
+
+	/* the root attributes are complete before the first child */
+	if (!item->got_header) {
+		apps = as_store_find_apps_node (node->parent->parent, error);
+		if (apps == NULL)
+			return;
+		item->version = g_strdup (as_node_get_attribute (apps, "version"));
+		item->origin = g_strdup (as_node_get_attribute (apps, "origin"));
+		item->got_header = TRUE;
+	}
+
+	/* there is no point deferring anything that is about to be cached */
+	app = as_app_new ();
+	if ((item->flags & AS_STORE_LOAD_FLAG_LAZY) > 0 && item->cache == NULL)
+		ret = as_app_node_parse_lazy (app, node, &error_local);
+	else
+		ret = as_app_node_parse (app, node, &error_local);
+	if (!ret) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to parse root: %s",
+			     error_local->message);
+		return;
+	}
+
+	/* save the app before it has been merged with any others */
+	if (item->cache != NULL)
+		g_variant_builder_add_value (item->cache, as_app_to_variant (app));
+	g_ptr_array_add (item->apps, g_object_ref (app));
+}
+
+/**
+ * as_store_load_item_parse:
+ *
+ * Parses the file into the item without touching the store, which means
+ * this is safe to call from a worker thread.
+ **/
+static gboolean
+as_store_load_item_parse (AsStoreLoadItem *item,
+			  GCancellable *cancellable,
+			  GError **error)
+{
+	AsNodeFromXmlFlags flags = AS_NODE_FROM_XML_FLAG_LITERAL_TEXT;
+	GNode *apps;
+	_cleanup_error_free_ GError *error_local = NULL;
+	_cleanup_node_unref_ GNode *root = NULL;
+	_cleanup_object_unref_ GFile *file = NULL;
+
+	/* deferred nodes are kept after the component has been parsed */
+	if ((item->flags & AS_STORE_LOAD_FLAG_LAZY) == 0 || item->cache != NULL)
+		flags |= AS_NODE_FROM_XML_FLAG_ARENA;
+
+	g_debug ("Loading AppStream XML %s", item->filename);
+	file = g_file_new_for_path (item->filename);
+	root = as_node_from_file_streaming (file,
+					    flags,
+					    as_store_load_item_component_cb,
+					    item,
+					    cancellable,
+					    &error_local);
+	if (root == NULL) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to parse file: %s",
+			     error_local->message);
+		return FALSE;
+	}
+
+	/* no components, but the root attributes are still used */
+	if (!item->got_header) {
+		apps = as_store_find_apps_node (root, error);
+		if (apps == NULL)
+			return FALSE;
+		item->version = g_strdup (as_node_get_attribute (apps, "version"));
+		item->origin = g_strdup (as_node_get_attribute (apps, "origin"));
+	}
+	return TRUE;
+}
+
+/**
+ * as_store_cache_get_mtime_nsec:
+ *
+ * Gets the sub-second part of the modification time, so that a file that
+ * is rewritten with the same size in the same second is not missed.
+ **/
+static guint32
+as_store_cache_get_mtime_nsec (GStatBuf *st)
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	return (guint32) st->st_mtim.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * as_store_cache_load:
+ *
+ * The cache is a #GVariant which is mapped straight from disk, so no
+ * decompression or XML parsing is required to load the applications.
+ **/
+static gboolean
+as_store_cache_load (AsStoreLoadItem *item, GError **error)
+{
+	GStatBuf st;
+	const gchar *source = NULL;
+	gboolean ret;
+	guint32 cache_version = 0;
+	guint32 mtime_nsec = 0;
+	guint64 mtime = 0;
+	guint64 size = 0;
+	guint i;
+	_cleanup_bytes_unref_ GBytes *bytes = NULL;
+	_cleanup_free_ gchar *cache_fn = NULL;
+	_cleanup_mapped_file_unref_ GMappedFile *mapped = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *array = NULL;
+	_cleanup_variant_unref_ GVariant *apps = NULL;
+	_cleanup_variant_unref_ GVariant *data = NULL;
+	_cleanup_variant_unref_ GVariant *value = NULL;
+
+	if (g_stat (item->filename, &st) != 0) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to stat %s", item->filename);
+		return FALSE;
+	}
 
-	/* compress as a gzip file */
-	compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
-	out = g_memory_output_stream_new_resizable ();
-	out2 = g_converter_output_stream_new (out, G_CONVERTER (compressor));
-	xml = as_store_to_xml (store, flags);
-	if (!g_output_stream_write_all (out2, xml->str, xml->len,
-					NULL, NULL, &error_local)) {
+	/* map the cache file */
+	cache_fn = as_store_cache_get_filename (item->filename);
+	mapped = g_mapped_file_new (cache_fn, FALSE, error);
+	if (mapped == NULL)
+		return FALSE;
+	bytes = g_mapped_file_get_bytes (mapped);
+	value = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("(uv)"),
+							      bytes, FALSE));
+	g_variant_get (value, "(uv)", &cache_version, &data);
+	if (cache_version != AS_STORE_CACHE_VERSION) {
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
-			     "Failed to write stream: %s",
-			     error_local->message);
+			     "Cache version %u is not supported",
+			     cache_version);
 		return FALSE;
 	}
-	if (!g_output_stream_close (out2, NULL, &error_local)) {
+	if (!g_variant_is_of_type (data, G_VARIANT_TYPE (AS_STORE_CACHE_TYPE))) {
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
-			     "Failed to close stream: %s",
-			     error_local->message);
+			     "Cache type %s is invalid",
+			     g_variant_get_type_string (data));
 		return FALSE;
 	}
 
-	/* write file */
-	if (!g_file_replace_contents (file,
-		g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out)),
-		g_memory_output_stream_get_size (G_MEMORY_OUTPUT_STREAM (out)),
-				      NULL,
-				      FALSE,
-				      G_FILE_CREATE_NONE,
-				      NULL,
-				      cancellable,
-				      &error_local)) {
+	/* is the cache still valid for the source file */
+	g_variant_get_child (data, 0, "&s", &source);
+	g_variant_get_child (data, 1, "t", &mtime);
+	g_variant_get_child (data, 2, "u", &mtime_nsec);
+	g_variant_get_child (data, 3, "t", &size);
+	if (g_strcmp0 (source, item->filename) != 0 ||
+	    mtime != (guint64) st.st_mtime ||
+	    mtime_nsec != as_store_cache_get_mtime_nsec (&st) ||
+	    size != (guint64) st.st_size) {
 		g_set_error (error,
 			     AS_STORE_ERROR,
 			     AS_STORE_ERROR_FAILED,
-			     "Failed to write file: %s",
-			     error_local->message);
+			     "Cache %s is out of date",
+			     cache_fn);
 		return FALSE;
 	}
+
+	/* create all the applications before returning any */
+	apps = g_variant_get_child_value (data, 6);
+	array = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+	for (i = 0; i < g_variant_n_children (apps); i++) {
+		AsApp *app;
+		_cleanup_variant_unref_ GVariant *app_data = NULL;
+		app_data = g_variant_get_child_value (apps, i);
+		app = as_app_new ();
+		g_ptr_array_add (array, app);
+		if ((item->flags & AS_STORE_LOAD_FLAG_LAZY) > 0)
+			ret = as_app_from_variant_lazy (app, app_data, error);
+		else
+			ret = as_app_from_variant (app, app_data, error);
+		if (!ret)
+			return FALSE;
+	}
+
+	/* success */
+	g_variant_get_child (data, 4, "ms", &item->version);
+	g_variant_get_child (data, 5, "ms", &item->origin);
+	for (i = 0; i < array->len; i++)
+		g_ptr_array_add (item->apps, g_object_ref (g_ptr_array_index (array, i)));
 	return TRUE;
 }
 
 /**
- * as_store_get_origin:
- * @store: a #AsStore instance.
- *
- * Gets the metadata origin, which is used to locate icons.
- *
- * Returns: the origin string, or %NULL if unset
- *
- * Since: 0.1.1
+ * as_store_cache_save:
  **/
-const gchar *
-as_store_get_origin (AsStore *store)
+static gboolean
+as_store_cache_save (AsStoreLoadItem *item, GStatBuf *st, GError **error)
 {
-	AsStorePrivate *priv = GET_PRIVATE (store);
-	return priv->origin;
+	GVariant *data;
+	_cleanup_free_ gchar *cache_dir = NULL;
+	_cleanup_free_ gchar *cache_fn = NULL;
+	_cleanup_variant_unref_ GVariant *value = NULL;
+
+	data = g_variant_new ("(stutmsms@a" AS_APP_VARIANT_TYPE ")",
+			      item->filename,
+			      (guint64) st->st_mtime,
+			      as_store_cache_get_mtime_nsec (st),
+			      (guint64) st->st_size,
+			      item->version,
+			      item->origin,
+			      g_variant_builder_end (item->cache));
+	value = g_variant_ref_sink (g_variant_new ("(uv)",
+						   AS_STORE_CACHE_VERSION,
+						   data));
+
+	/* write atomically */
+	cache_fn = as_store_cache_get_filename (item->filename);
+	cache_dir = g_path_get_dirname (cache_fn);
+	if (g_mkdir_with_parents (cache_dir, 0755) != 0) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to create %s", cache_dir);
+		return FALSE;
+	}
+	return g_file_set_contents (cache_fn,
+				    g_variant_get_data (value),
+				    g_variant_get_size (value),
+				    error);
 }
 
 /**
- * as_store_set_origin:
- * @store: a #AsStore instance.
- * @origin: the origin, e.g. "fedora-21"
- *
- * Sets the metadata origin, which is used to locate icons.
- *
- * Since: 0.1.1
+ * as_store_cache_create:
  **/
-void
-as_store_set_origin (AsStore *store, const gchar *origin)
+static gboolean
+as_store_cache_create (AsStoreLoadItem *item,
+		       GCancellable *cancellable,
+		       GError **error)
 {
-	AsStorePrivate *priv = GET_PRIVATE (store);
-	g_free (priv->origin);
-	priv->origin = g_strdup (origin);
+	GStatBuf st;
+	_cleanup_error_free_ GError *error_local = NULL;
+
+	/* get this before parsing so a change during the load is caught */
+	if (g_stat (item->filename, &st) != 0) {
+		g_set_error (error,
+			     AS_STORE_ERROR,
+			     AS_STORE_ERROR_FAILED,
+			     "Failed to stat %s", item->filename);
+		return FALSE;
+	}
+
+	/* parse the XML, recording each app as it is added */
+	item->cache = g_variant_builder_new (G_VARIANT_TYPE ("a" AS_APP_VARIANT_TYPE));
+	if (!as_store_load_item_parse (item, cancellable, error))
+		return FALSE;
+
+	/* not being able to write the cache is not fatal */
+	if (!as_store_cache_save (item, &st, &error_local)) {
+		g_debug ("Failed to save cache for %s: %s",
+			 item->filename, error_local->message);
+	}
+	return TRUE;
 }
 
 /**
- * as_store_get_api_version:
- * @store: a #AsStore instance.
- *
- * Gets the AppStream API version.
- *
- * Returns: the #AsNodeInsertFlags, or 0 if unset
- *
- * Since: 0.1.1
+ * as_store_load_item_run:
  **/
-gdouble
-as_store_get_api_version (AsStore *store)
+static gboolean
+as_store_load_item_run (AsStoreLoadItem *item,
+			GCancellable *cancellable,
+			GError **error)
 {
-	AsStorePrivate *priv = GET_PRIVATE (store);
-	return priv->api_version;
+	_cleanup_error_free_ GError *error_local = NULL;
+
+	if ((item->flags & AS_STORE_LOAD_FLAG_USE_CACHE) == 0)
+		return as_store_load_item_parse (item, cancellable, error);
+
+	/* use the binary cache if it is still valid */
+	if (as_store_cache_load (item, &error_local))
+		return TRUE;
+	g_debug ("Not using cache for %s: %s",
+		 item->filename, error_local->message);
+	return as_store_cache_create (item, cancellable, error);
 }
 
 /**
- * as_store_set_api_version:
- * @store: a #AsStore instance.
- * @api_version: the API version
- *
- * Sets the AppStream API version.
+ * as_store_load_item_prepare:
  *
- * Since: 0.1.1
+ * Sets the store header and the per-file application properties.
  **/
-void
-as_store_set_api_version (AsStore *store, gdouble api_version)
+static void
+as_store_load_item_prepare (AsStore *store,
+			    AsStoreLoadItem *item,
+			    const gchar *icon_root)
 {
-	AsStorePrivate *priv = GET_PRIVATE (store);
-	priv->api_version = api_version;
+	AsApp *app;
+	guint i;
+	_cleanup_free_ gchar *icon_path = NULL;
+
+	as_store_set_header (store, item->version, item->origin,
+			     icon_root, &icon_path);
+	for (i = 0; i < item->apps->len; i++) {
+		app = g_ptr_array_index (item->apps, i);
+		if (icon_path != NULL)
+			as_app_set_icon_path (app, icon_path, -1);
+		as_app_set_source_kind (app, AS_APP_SOURCE_KIND_APPSTREAM);
+		as_app_set_source_file (app, item->filename);
+	}
 }
 
 /**
- * as_store_guess_origin_fallback:
- */
+ * as_store_add_item:
+ *
+ * Merges the applications loaded from one file into the store.
+ **/
 static gboolean
-as_store_guess_origin_fallback (AsStore *store,
-				const gchar *filename,
-				GError **error)
+as_store_add_item (AsStore *store,
+		   AsStoreLoadItem *item,
+		   const gchar *icon_root,
+		   GError **error)
 {
-	gchar *tmp;
-	_cleanup_free_ gchar *origin_fallback;
+	guint i;
 
-	/* the first component of the file (e.g. "fedora-20.xml.gz)
-	 * is used for the icon directory as we might want to clean up
-	 * the icons manually if they are installed in /var/cache */
-	origin_fallback = g_path_get_basename (filename);
-	tmp = g_strstr_len (origin_fallback, -1, ".xml");
-	if (tmp == NULL) {
-		g_set_error (error,
-			     AS_STORE_ERROR,
-			     AS_STORE_ERROR_FAILED,
-			     "AppStream metadata name %s not valid, "
-			     "expected .xml[.*]",
-			     filename);
+	/* guess this based on the name */
+	if (!as_store_guess_origin_fallback (store, item->filename, error))
 		return FALSE;
-	}
-	tmp[0] = '\0';
 
-	/* load this specific file */
-	as_store_set_origin (store, origin_fallback);
+	as_store_load_item_prepare (store, item, icon_root);
+	for (i = 0; i < item->apps->len; i++)
+		as_store_add_app (store, g_ptr_array_index (item->apps, i));
+
+	/* add addon kinds to their parent AsApp */
+	as_store_match_addons (store);
 	return TRUE;
 }
 
@@ -781,11 +3270,24 @@ static gboolean
 as_store_load_app_info_file (AsStore *store,
 			     const gchar *path_xml,
 			     const gchar *icon_root,
+			     AsStoreLoadFlags flags,
 			     GCancellable *cancellable,
 			     GError **error)
 {
+	AsStoreLoadItem *item;
+	gboolean ret;
 	_cleanup_object_unref_ GFile *file = NULL;
 
+	/* the cache is written from the parsed applications */
+	if ((flags & (AS_STORE_LOAD_FLAG_USE_CACHE | AS_STORE_LOAD_FLAG_LAZY)) > 0) {
+		item = as_store_load_item_new (path_xml, flags);
+		ret = as_store_load_item_run (item, cancellable, error);
+		if (ret)
+			ret = as_store_add_item (store, item, icon_root, error);
+		as_store_load_item_free (item);
+		return ret;
+	}
+
 	/* guess this based on the name */
 	if (!as_store_guess_origin_fallback (store, path_xml, error))
 		return FALSE;
@@ -801,6 +3303,71 @@ as_store_load_app_info_file (AsStore *store,
 				   error);
 }
 
+/**
+ * as_store_load_item_thread_cb:
+ **/
+static void
+as_store_load_item_thread_cb (gpointer data, gpointer user_data)
+{
+	AsStoreLoadItem *item = (AsStoreLoadItem *) data;
+	GCancellable *cancellable = (GCancellable *) user_data;
+	as_store_load_item_run (item, cancellable, &item->error);
+}
+
+/**
+ * as_store_load_app_info_parallel:
+ *
+ * Each file is decompressed and parsed on a worker thread, and then the
+ * results are merged into the store in the order of @filenames so that
+ * the priority rules in as_store_add_app() are applied deterministically.
+ **/
+static gboolean
+as_store_load_app_info_parallel (AsStore *store,
+				 GPtrArray *filenames,
+				 const gchar *icon_root,
+				 AsStoreLoadFlags flags,
+				 GCancellable *cancellable,
+				 GError **error)
+{
+	AsStoreLoadItem *item;
+	GThreadPool *pool;
+	guint i;
+	_cleanup_ptrarray_unref_ GPtrArray *items = NULL;
+
+	pool = g_thread_pool_new (as_store_load_item_thread_cb,
+				  cancellable,
+				  (gint) g_get_num_processors (),
+				  FALSE,
+				  error);
+	if (pool == NULL)
+		return FALSE;
+	items = g_ptr_array_new_with_free_func ((GDestroyNotify) as_store_load_item_free);
+	for (i = 0; i < filenames->len; i++) {
+		item = as_store_load_item_new (g_ptr_array_index (filenames, i), flags);
+		g_ptr_array_add (items, item);
+		if (!g_thread_pool_push (pool, item, error)) {
+			g_thread_pool_free (pool, TRUE, TRUE);
+			return FALSE;
+		}
+	}
+
+	/* wait for all the files to be loaded */
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	/* merge on this thread */
+	for (i = 0; i < items->len; i++) {
+		item = g_ptr_array_index (items, i);
+		if (item->error != NULL) {
+			g_propagate_error (error, item->error);
+			item->error = NULL;
+			return FALSE;
+		}
+		if (!as_store_add_item (store, item, icon_root, error))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 /**
  * as_store_cache_changed_cb:
  */
@@ -815,11 +3382,192 @@ as_store_cache_changed_cb (GFileMonitor *monitor,
 }
 
 /**
- * as_store_monitor_directory:
+ * as_store_app_equal:
  **/
 static gboolean
+as_store_app_equal (AsApp *app1, AsApp *app2)
+{
+	_cleanup_variant_unref_ GVariant *value1 = NULL;
+	_cleanup_variant_unref_ GVariant *value2 = NULL;
+
+	if (g_strcmp0 (as_app_get_icon_path (app1),
+		       as_app_get_icon_path (app2)) != 0)
+		return FALSE;
+	value1 = g_variant_ref_sink (as_app_to_variant (app1));
+	value2 = g_variant_ref_sink (as_app_to_variant (app2));
+	return g_variant_equal (value1, value2);
+}
+
+/**
+ * as_store_reload_file:
+ * @store: a #AsStore instance.
+ * @file: a #GFile.
+ * @icon_root: the icon path, or %NULL for the default.
+ * @cancellable: a #GCancellable.
+ * @error: A #GError or %NULL.
+ *
+ * Reloads an AppStream XML file that has previously been added to the store
+ * and updates only the applications that came from that file.
+ *
+ * The ::app-added, ::app-removed and ::app-changed signals are emitted for
+ * each application that is different, followed by ::changed if anything in
+ * the store was modified. If @file no longer exists then all the applications
+ * from it are removed.
+ *
+ * If an application from @file had replaced one with the same ID from another
+ * file, the other application is added back when the one from @file is
+ * removed or lowered in priority, and ::app-changed is emitted for it.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.1.8
+ **/
+gboolean
+as_store_reload_file (AsStore *store,
+		      GFile *file,
+		      const gchar *icon_root,
+		      GCancellable *cancellable,
+		      GError **error)
+{
+	AsApp *app;
+	AsApp *app_old;
+	AsStoreLoadItem *item;
+	AsStorePrivate *priv = GET_PRIVATE (store);
+	GHashTableIter iter;
+	const gchar *id;
+	gboolean changed = FALSE;
+	guint i;
+	_cleanup_free_ gchar *filename = NULL;
+	_cleanup_hashtable_unref_ GHashTable *apps_old = NULL;
+
+	g_return_val_if_fail (AS_IS_STORE (store), FALSE);
+
+	/* the applications previously loaded from this file */
+	filename = g_file_get_path (file);
+	apps_old = g_hash_table_new_full (g_str_hash, g_str_equal,
+					  NULL, (GDestroyNotify) g_object_unref);
+	for (i = 0; i < priv->array->len; i++) {
+		app = g_ptr_array_index (priv->array, i);
+		if (g_strcmp0 (as_app_get_source_file (app), filename) != 0)
+			continue;
+		g_hash_table_insert (apps_old,
+				     (gpointer) as_app_get_id_full (app),
+				     g_object_ref (app));
+	}
+
+	/* the applications from this file that lost to others are parsed
+	 * again below if they are still in the file */
+	as_store_shadowed_remove_file (store, filename);
+
+	/* a deleted file just has no applications */
+	item = as_store_load_item_new (filename,
+				       priv->load_flags &
+				       (AS_STORE_LOAD_FLAG_USE_CACHE |
+					AS_STORE_LOAD_FLAG_LAZY));
+	if (g_file_query_exists (file, cancellable)) {
+		if (!as_store_load_item_run (item, cancellable, error)) {
+			as_store_load_item_free (item);
+			return FALSE;
+		}
+		as_store_load_item_prepare (store, item, icon_root);
+	}
+
+	for (i = 0; i < item->apps->len; i++) {
+		app = g_ptr_array_index (item->apps, i);
+		id = as_app_get_id_full (app);
+		if (id == NULL)
+			continue;
+		app_old = g_hash_table_lookup (apps_old, id);
+		if (app_old == NULL) {
+			as_store_add_app (store, app);
+			if (g_hash_table_lookup (priv->hash_id, id) != app)
+				continue;
+			g_debug ("Emitting ::app-added(%s)", id);
+			g_signal_emit (store, signals[SIGNAL_APP_ADDED], 0, app);
+			changed = TRUE;
+			continue;
+		}
+		if (!as_store_app_equal (app_old, app)) {
+			as_store_remove_app (store, app_old);
+			as_store_shadowed_restore (store, id);
+			as_store_add_app (store, app);
+			g_debug ("Emitting ::app-changed(%s)", id);
+			g_signal_emit (store, signals[SIGNAL_APP_CHANGED], 0,
+				       g_hash_table_lookup (priv->hash_id, id));
+			changed = TRUE;
+		}
+		g_hash_table_remove (apps_old, id);
+	}
+	as_store_load_item_free (item);
+
+	/* anything left over is no longer in the file, but another file may
+	 * still provide the same ID */
+	g_hash_table_iter_init (&iter, apps_old);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &app_old)) {
+		id = as_app_get_id_full (app_old);
+		as_store_remove_app (store, app_old);
+		changed = TRUE;
+		app = as_store_shadowed_restore (store, id);
+		if (app != NULL) {
+			g_debug ("Emitting ::app-changed(%s)", id);
+			g_signal_emit (store, signals[SIGNAL_APP_CHANGED], 0, app);
+			continue;
+		}
+		g_debug ("Emitting ::app-removed(%s)", id);
+		g_signal_emit (store, signals[SIGNAL_APP_REMOVED], 0, app_old);
+	}
+	if (!changed)
+		return TRUE;
+
+	/* add addon kinds to their parent AsApp */
+	as_store_match_addons (store);
+
+	g_debug ("Emitting ::changed()");
+	g_signal_emit (store, signals[SIGNAL_CHANGED], 0);
+	return TRUE;
+}
+
+/**
+ * as_store_xmls_changed_cb:
+ */
+static void
+as_store_xmls_changed_cb (GFileMonitor *monitor,
+			  GFile *file, GFile *other_file,
+			  GFileMonitorEvent event_type,
+			  AsStore *store)
+{
+	const gchar *icon_root;
+	_cleanup_error_free_ GError *error = NULL;
+	_cleanup_free_ gchar *basename = NULL;
+
+	/* only reload once the file has been completely written */
+	if (event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT &&
+	    event_type != G_FILE_MONITOR_EVENT_DELETED)
+		return;
+
+	/* ignore temporary files, e.g. foo.xml.gz.AB12CD from an atomic write
+	 * which is renamed to foo.xml.gz when complete */
+	basename = g_file_get_basename (file);
+	if (!g_str_has_suffix (basename, ".xml") &&
+	    !g_str_has_suffix (basename, ".xml.gz"))
+		return;
+
+	icon_root = g_object_get_data (G_OBJECT (monitor), "icon-root");
+	if (!as_store_guess_origin_fallback (store, basename, &error) ||
+	    !as_store_reload_file (store, file, icon_root, NULL, &error)) {
+		g_warning ("Failed to reload %s: %s", basename, error->message);
+		g_debug ("Emitting ::changed()");
+		g_signal_emit (store, signals[SIGNAL_CHANGED], 0);
+	}
+}
+
+/**
+ * as_store_monitor_directory:
+ **/
+static GFileMonitor *
 as_store_monitor_directory (AsStore *store,
 			    const gchar *path,
+			    GCallback callback,
 			    GCancellable *cancellable,
 			    GError **error)
 {
@@ -839,13 +3587,20 @@ as_store_monitor_directory (AsStore *store,
 			     AS_STORE_ERROR_FAILED,
 			     "Failed to monitor %s: %s",
 			     path, error_local->message);
-		return FALSE;
+		return NULL;
 	}
-	g_signal_connect (monitor, "changed",
-			  G_CALLBACK (as_store_cache_changed_cb),
-			  store);
+	g_signal_connect (monitor, "changed", callback, store);
 	g_ptr_array_add (priv->file_monitors, g_object_ref (monitor));
-	return TRUE;
+	return monitor;
+}
+
+/**
+ * as_store_filenames_sort_cb:
+ **/
+static gint
+as_store_filenames_sort_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
 }
 
 /**
@@ -854,23 +3609,41 @@ as_store_monitor_directory (AsStore *store,
 static gboolean
 as_store_load_app_info (AsStore *store,
 			const gchar *path,
+			AsStoreLoadFlags flags,
 			GCancellable *cancellable,
 			GError **error)
 {
+	GFileMonitor *monitor;
 	const gchar *tmp;
+	guint i;
 	_cleanup_dir_close_ GDir *dir = NULL;
 	_cleanup_error_free_ GError *error_local = NULL;
 	_cleanup_free_ gchar *icon_root = NULL;
 	_cleanup_free_ gchar *path_xml = NULL;
+	_cleanup_ptrarray_unref_ GPtrArray *filenames = NULL;
 
 	/* watch the directory for changes */
-	if (!as_store_monitor_directory (store, path, cancellable, error))
+	monitor = as_store_monitor_directory (store, path,
+					      G_CALLBACK (as_store_cache_changed_cb),
+					      cancellable, error);
+	if (monitor == NULL)
 		return FALSE;
 
 	/* search all files */
 	path_xml = g_build_filename (path, "xmls", NULL);
 	if (!g_file_test (path_xml, G_FILE_TEST_EXISTS))
 		return TRUE;
+	icon_root = g_build_filename (path, "icons", NULL);
+
+	/* reload individual files when they change */
+	monitor = as_store_monitor_directory (store, path_xml,
+					      G_CALLBACK (as_store_xmls_changed_cb),
+					      cancellable, error);
+	if (monitor == NULL)
+		return FALSE;
+	g_object_set_data_full (G_OBJECT (monitor), "icon-root",
+				g_strdup (icon_root), g_free);
+
 	dir = g_dir_open (path_xml, 0, &error_local);
 	if (dir == NULL) {
 		g_set_error (error,
@@ -880,13 +3653,25 @@ as_store_load_app_info (AsStore *store,
 			     path_xml, error_local->message);
 		return FALSE;
 	}
-	icon_root = g_build_filename (path, "icons", NULL);
-	while ((tmp = g_dir_read_name (dir)) != NULL) {
-		_cleanup_free_ gchar *filename_xml;
-		filename_xml = g_build_filename (path_xml, tmp, NULL);
+
+	/* sort so that the merge order does not depend on the filesystem */
+	filenames = g_ptr_array_new_with_free_func (g_free);
+	while ((tmp = g_dir_read_name (dir)) != NULL)
+		g_ptr_array_add (filenames, g_build_filename (path_xml, tmp, NULL));
+	g_ptr_array_sort (filenames, as_store_filenames_sort_cb);
+	if ((flags & AS_STORE_LOAD_FLAG_PARALLEL) > 0) {
+		return as_store_load_app_info_parallel (store,
+							filenames,
+							icon_root,
+							flags,
+							cancellable,
+							error);
+	}
+	for (i = 0; i < filenames->len; i++) {
 		if (!as_store_load_app_info_file (store,
-						  filename_xml,
+						  g_ptr_array_index (filenames, i),
 						  icon_root,
+						  flags,
 						  cancellable,
 						  error))
 			return FALSE;
@@ -1018,6 +3803,14 @@ as_store_load_app_install (AsStore *store,
  *
  * Loads the store from the default locations.
  *
+ * The AppStream files in each location are added in filename order. If
+ * %AS_STORE_LOAD_FLAG_PARALLEL is used then the files are parsed in a pool
+ * of threads, but are still added to the store in the same order.
+ *
+ * If %AS_STORE_LOAD_FLAG_LAZY is used then the descriptions, screenshots,
+ * releases, provides and languages of each application are only parsed
+ * when they are first accessed.
+ *
  * Returns: %TRUE for success
  *
  * Since: 0.1.2
@@ -1028,12 +3821,16 @@ as_store_load (AsStore *store,
 	       GCancellable *cancellable,
 	       GError **error)
 {
+	AsStorePrivate *priv = GET_PRIVATE (store);
 	const gchar * const * data_dirs;
 	const gchar *tmp;
 	gchar *path;
 	guint i;
 	_cleanup_ptrarray_unref_ GPtrArray *app_info = NULL;
 
+	/* used when the AppStream files change */
+	priv->load_flags = flags;
+
 	/* system locations */
 	app_info = g_ptr_array_new_with_free_func (g_free);
 	if ((flags & AS_STORE_LOAD_FLAG_APP_INFO_SYSTEM) > 0) {
@@ -1059,7 +3856,7 @@ as_store_load (AsStore *store,
 		tmp = g_ptr_array_index (app_info, i);
 		if (!g_file_test (tmp, G_FILE_TEST_EXISTS))
 			continue;
-		if (!as_store_load_app_info (store, tmp, cancellable, error))
+		if (!as_store_load_app_info (store, tmp, flags, cancellable, error))
 			return FALSE;
 	}
 
@@ -53,10 +53,13 @@ struct _AsStoreClass
 {
 	GObjectClass		parent_class;
 	void			(*changed)	(AsStore	*store);
+	void			(*app_added)	(AsStore	*store,
+						 AsApp		*app);
+	void			(*app_removed)	(AsStore	*store,
+						 AsApp		*app);
+	void			(*app_changed)	(AsStore	*store,
+						 AsApp		*app);
 	/*< private >*/
-	void (*_as_reserved1)	(void);
-	void (*_as_reserved2)	(void);
-	void (*_as_reserved3)	(void);
 	void (*_as_reserved4)	(void);
 	void (*_as_reserved5)	(void);
 	void (*_as_reserved6)	(void);
@@ -69,6 +72,9 @@ struct _AsStoreClass
  * @AS_STORE_LOAD_FLAG_APP_INFO_SYSTEM:		The system app-info AppStream data
  * @AS_STORE_LOAD_FLAG_APP_INFO_USER:		The per-user app-info AppStream data
  * @AS_STORE_LOAD_FLAG_APP_INSTALL:		The ubuntu-specific app-install data
+ * @AS_STORE_LOAD_FLAG_USE_CACHE:		Use and update a binary cache of the XML data
+ * @AS_STORE_LOAD_FLAG_PARALLEL:		Parse each AppStream file in a thread pool
+ * @AS_STORE_LOAD_FLAG_LAZY:			Only parse large elements when first used
  *
  * The flags to use when loading the store.
  **/
@@ -77,10 +83,59 @@ typedef enum {
 	AS_STORE_LOAD_FLAG_APP_INFO_SYSTEM	= 1,	/* Since: 0.1.2 */
 	AS_STORE_LOAD_FLAG_APP_INFO_USER	= 2,	/* Since: 0.1.2 */
 	AS_STORE_LOAD_FLAG_APP_INSTALL		= 4,	/* Since: 0.1.2 */
+	AS_STORE_LOAD_FLAG_USE_CACHE		= 8,	/* Since: 0.1.8 */
+	AS_STORE_LOAD_FLAG_PARALLEL		= 16,	/* Since: 0.1.8 */
+	AS_STORE_LOAD_FLAG_LAZY			= 32,	/* Since: 0.1.8 */
 	/*< private >*/
 	AS_STORE_LOAD_FLAG_LAST
 } AsStoreLoadFlags;
 
+/**
+ * AsStoreWriteFlags:
+ * @AS_STORE_WRITE_FLAG_NONE:			No extra flags to use
+ * @AS_STORE_WRITE_FLAG_PARALLEL:		Convert the applications in a thread pool
+ * @AS_STORE_WRITE_FLAG_COMPRESS_PARALLEL:	Compress files as independent gzip members in a thread pool
+ *
+ * The flags to use when writing the store.
+ **/
+typedef enum {
+	AS_STORE_WRITE_FLAG_NONE		= 0,	/* Since: 0.1.8 */
+	AS_STORE_WRITE_FLAG_PARALLEL		= 1,	/* Since: 0.1.8 */
+	AS_STORE_WRITE_FLAG_COMPRESS_PARALLEL	= 2,	/* Since: 0.1.8 */
+	/*< private >*/
+	AS_STORE_WRITE_FLAG_LAST
+} AsStoreWriteFlags;
+
+/**
+ * AsStoreSortKind:
+ * @AS_STORE_SORT_KIND_ID:		Sorted by application ID
+ * @AS_STORE_SORT_KIND_NAME:		Sorted by localized name
+ * @AS_STORE_SORT_KIND_PRIORITY:	Sorted by priority, highest first
+ *
+ * The orders the applications in a store can be sorted in.
+ **/
+typedef enum {
+	AS_STORE_SORT_KIND_ID,			/* Since: 0.1.8 */
+	AS_STORE_SORT_KIND_NAME,		/* Since: 0.1.8 */
+	AS_STORE_SORT_KIND_PRIORITY,		/* Since: 0.1.8 */
+	/*< private >*/
+	AS_STORE_SORT_KIND_LAST
+} AsStoreSortKind;
+
+/**
+ * AsStoreSearchFlags:
+ * @AS_STORE_SEARCH_FLAG_NONE:		No special actions to use
+ * @AS_STORE_SEARCH_FLAG_FUZZY:		Also match terms that are misspelled
+ *
+ * The flags to use when searching the store.
+ **/
+typedef enum {
+	AS_STORE_SEARCH_FLAG_NONE		= 0,	/* Since: 0.1.8 */
+	AS_STORE_SEARCH_FLAG_FUZZY		= 1,	/* Since: 0.1.8 */
+	/*< private >*/
+	AS_STORE_SEARCH_FLAG_LAST
+} AsStoreSearchFlags;
+
 /**
  * AsStoreError:
  * @AS_STORE_ERROR_FAILED:			Generic failure
@@ -108,6 +163,11 @@ gboolean	 as_store_from_file		(AsStore	*store,
 						 const gchar	*icon_root,
 						 GCancellable	*cancellable,
 						 GError		**error);
+gboolean	 as_store_reload_file		(AsStore	*store,
+						 GFile		*file,
+						 const gchar	*icon_root,
+						 GCancellable	*cancellable,
+						 GError		**error);
 gboolean	 as_store_from_xml		(AsStore	*store,
 						 const gchar	*data,
 						 gssize		 data_len,
@@ -118,13 +178,29 @@ gboolean	 as_store_load			(AsStore	*store,
 						 GCancellable	*cancellable,
 						 GError		**error);
 GPtrArray	*as_store_get_apps		(AsStore	*store);
+GPtrArray	*as_store_get_apps_sorted	(AsStore	*store,
+						 AsStoreSortKind kind);
 GPtrArray	*as_store_get_apps_by_metadata	(AsStore	*store,
 						 const gchar	*key,
 						 const gchar	*value);
+GPtrArray	*as_store_get_apps_by_category	(AsStore	*store,
+						 const gchar	*category);
+GPtrArray	*as_store_get_apps_by_mimetype	(AsStore	*store,
+						 const gchar	*mimetype);
+GPtrArray	*as_store_get_apps_by_project_group (AsStore	*store,
+						 const gchar	*project_group);
+GPtrArray	*as_store_get_apps_by_provide	(AsStore	*store,
+						 AsProvideKind	 kind,
+						 const gchar	*value);
 AsApp		*as_store_get_app_by_id		(AsStore	*store,
 						 const gchar	*id);
 AsApp		*as_store_get_app_by_pkgname	(AsStore	*store,
 						 const gchar	*pkgname);
+GPtrArray	*as_store_search		(AsStore	*store,
+						 gchar		**search);
+GPtrArray	*as_store_search_full		(AsStore	*store,
+						 gchar		**search,
+						 AsStoreSearchFlags flags);
 void		 as_store_add_app		(AsStore	*store,
 						 AsApp		*app);
 void		 as_store_remove_app		(AsStore	*store,
@@ -142,6 +218,12 @@ void		 as_store_set_origin		(AsStore	*store,
 gdouble		 as_store_get_api_version	(AsStore	*store);
 void		 as_store_set_api_version	(AsStore	*store,
 						 gdouble	 api_version);
+gint		 as_store_get_compression_level	(AsStore	*store);
+void		 as_store_set_compression_level	(AsStore	*store,
+						 gint		 level);
+AsStoreWriteFlags as_store_get_write_flags	(AsStore	*store);
+void		 as_store_set_write_flags	(AsStore	*store,
+						 AsStoreWriteFlags flags);
 
 G_END_DECLS
 
@@ -32,8 +32,32 @@ G_BEGIN_DECLS
 
 gchar		*as_strndup			(const gchar	*text,
 						 gssize		 text_len);
+const gchar	*as_intern			(const gchar	*text,
+						 gssize		 text_len);
 const gchar	*as_hash_lookup_by_locale	(GHashTable	*hash,
 						 const gchar	*locale);
+const gchar	*as_hash_lookup_by_locales	(GHashTable	*hash,
+						 const gchar * const *locales);
+
+/**
+ * AsUtilsSpdxIdFunc:
+ * @license_id: a license ID, which is not NUL terminated
+ * @len: the length of @license_id
+ * @user_data: user data
+ *
+ * Checks a license ID found when parsing an SPDX license expression.
+ *
+ * Returns: %TRUE if the license ID is known
+ **/
+typedef gboolean (*AsUtilsSpdxIdFunc)			(const gchar	*license_id,
+							 guint		 len,
+							 gpointer	 user_data);
+
+AsSpdxExpression *as_utils_spdx_parse_full	(const gchar	*license,
+						 AsSpdxParseFlags flags,
+						 AsUtilsSpdxIdFunc id_func,
+						 gpointer	 user_data,
+						 GError		**error);
 
 G_END_DECLS
 
@@ -40,6 +40,14 @@
 #include "as-utils.h"
 #include "as-utils-private.h"
 
+#ifdef HAVE_GPERF
+  /* we need to define these now as gperf just writes a big header file */
+  const char *as_license_id_from_gperf (const char *str, guint len);
+  const char *as_stock_icon_from_gperf (const char *str, guint len);
+  #include "as-license-ids-private.h"
+  #include "as-stock-icons-private.h"
+#endif
+
 /**
  * as_strndup:
  * @text: the text to copy.
@@ -59,6 +67,73 @@ as_strndup (const gchar *text, gssize text_len)
 	return g_strndup (text, text_len);
 }
 
+/* the number of duplicate strings that have been shared, updated without a
+ * lock as as_intern() is called from the parser threads */
+static volatile gint as_intern_lookups = 0;
+static volatile gint as_intern_hits = 0;
+static volatile gsize as_intern_bytes_saved = 0;
+
+/**
+ * as_intern: (skip)
+ * @text: the text to intern.
+ * @text_len: the length of @text, or -1 if @text is NULL terminated.
+ *
+ * Gets a canonical copy of a string that is shared for the lifetime of the
+ * process. This should only be used for strings that are drawn from a small
+ * set of values, for instance locales, categories or metadata keys.
+ *
+ * Returns: an interned string, or %NULL if @text is %NULL
+ *
+ * Since: 0.1.8
+ **/
+const gchar *
+as_intern (const gchar *text, gssize text_len)
+{
+	const gchar *tmp;
+	_cleanup_free_ gchar *copy = NULL;
+
+	if (text == NULL)
+		return NULL;
+	if (text_len >= 0) {
+		copy = g_strndup (text, text_len);
+		text = copy;
+	}
+
+	/* is this a string we have seen before */
+	tmp = g_quark_to_string (g_quark_try_string (text));
+	g_atomic_int_inc (&as_intern_lookups);
+	if (tmp == NULL)
+		return g_intern_string (text);
+	g_atomic_int_inc (&as_intern_hits);
+	g_atomic_pointer_add (&as_intern_bytes_saved, strlen (tmp) + 1);
+	return tmp;
+}
+
+/**
+ * as_utils_get_intern_stats:
+ * @lookups: (out) (allow-none): the number of strings that were interned
+ * @hits: (out) (allow-none): the number of strings that were already known
+ * @bytes_saved: (out) (allow-none): the string data that was not duplicated
+ *
+ * Gets statistics about the strings shared between applications, for
+ * instance locales, categories and metadata keys. The numbers are totals
+ * for the lifetime of the process. Each counter is updated atomically, so
+ * while other threads are interning strings the three values may not be
+ * from exactly the same moment.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_utils_get_intern_stats (guint *lookups, guint *hits, gsize *bytes_saved)
+{
+	if (lookups != NULL)
+		*lookups = (guint) g_atomic_int_get (&as_intern_lookups);
+	if (hits != NULL)
+		*hits = (guint) g_atomic_int_get (&as_intern_hits);
+	if (bytes_saved != NULL)
+		*bytes_saved = (gsize) g_atomic_pointer_get (&as_intern_bytes_saved);
+}
+
 /**
  * as_markup_convert_simple:
  * @markup: the text to copy.
@@ -140,6 +215,31 @@ as_markup_convert_simple (const gchar *markup,
 	return g_strdup (str->str);
 }
 
+/**
+ * as_hash_lookup_by_locales:
+ * @hash: a #GHashTable.
+ * @locales: a list of locales, best first
+ *
+ * Gets the data entry for the first locale in the list that has one, so
+ * that the list returned by g_get_language_names() can be looked up once
+ * and used for many hash tables.
+ *
+ * Returns: the string value, or %NULL if there was no data
+ **/
+const gchar *
+as_hash_lookup_by_locales (GHashTable *hash, const gchar * const *locales)
+{
+	const gchar *tmp;
+	guint i;
+
+	for (i = 0; locales[i] != NULL; i++) {
+		tmp = g_hash_table_lookup (hash, locales[i]);
+		if (tmp != NULL)
+			return tmp;
+	}
+	return NULL;
+}
+
 /**
  * as_hash_lookup_by_locale:
  * @hash: a #GHashTable.
@@ -158,10 +258,6 @@ as_markup_convert_simple (const gchar *markup,
 const gchar *
 as_hash_lookup_by_locale (GHashTable *hash, const gchar *locale)
 {
-	const gchar *const *locales;
-	const gchar *tmp = NULL;
-	guint i;
-
 	g_return_val_if_fail (hash != NULL, NULL);
 
 	/* the user specified a locale */
@@ -169,13 +265,7 @@ as_hash_lookup_by_locale (GHashTable *hash, const gchar *locale)
 		return g_hash_table_lookup (hash, locale);
 
 	/* use LANGUAGE, LC_ALL, LC_MESSAGES and LANG */
-	locales = g_get_language_names ();
-	for (i = 0; locales[i] != NULL; i++) {
-		tmp = g_hash_table_lookup (hash, locales[i]);
-		if (tmp != NULL)
-			return tmp;
-	}
-	return NULL;
+	return as_hash_lookup_by_locales (hash, g_get_language_names ());
 }
 
 /**
@@ -192,6 +282,12 @@ as_hash_lookup_by_locale (GHashTable *hash, const gchar *locale)
 gboolean
 as_utils_is_stock_icon_name (const gchar *name)
 {
+#ifdef HAVE_GPERF
+	/* use a perfect hash */
+	if (name == NULL)
+		return FALSE;
+	return as_stock_icon_from_gperf (name, strlen (name)) != NULL;
+#else
 	_cleanup_bytes_unref_ GBytes *data;
 	_cleanup_free_ gchar *key = NULL;
 
@@ -204,6 +300,7 @@ as_utils_is_stock_icon_name (const gchar *name)
 		return FALSE;
 	key = g_strdup_printf ("\n%s\n", name);
 	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+#endif
 }
 
 /**
@@ -219,6 +316,12 @@ as_utils_is_stock_icon_name (const gchar *name)
 gboolean
 as_utils_is_spdx_license_id (const gchar *license_id)
 {
+#ifdef HAVE_GPERF
+	/* use a perfect hash */
+	if (license_id == NULL)
+		return FALSE;
+	return as_license_id_from_gperf (license_id, strlen (license_id)) != NULL;
+#else
 	_cleanup_bytes_unref_ GBytes *data;
 	_cleanup_free_ gchar *key = NULL;
 
@@ -231,6 +334,7 @@ as_utils_is_spdx_license_id (const gchar *license_id)
 		return FALSE;
 	key = g_strdup_printf ("\n%s\n", license_id);
 	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+#endif
 }
 
 /**
@@ -241,6 +345,8 @@ as_utils_is_spdx_license_id (const gchar *license_id)
  * into parts. Any non-licence parts of the string e.g. " and " are prefexed
  * with "#".
  *
+ * Use as_utils_spdx_parse() to get the structure of the expression.
+ *
  * Returns: (transfer full): array of strings
  *
  * Since: 0.1.5
@@ -249,7 +355,6 @@ gchar **
 as_utils_spdx_license_tokenize (const gchar *license)
 {
 	GPtrArray *array;
-	gchar buf[1024];
 	guint i;
 	guint old = 0;
 	guint matchlen = 0;
@@ -260,8 +365,7 @@ as_utils_spdx_license_tokenize (const gchar *license)
 		/* leading bracket */
 		if (i == 0 && license[i] == '(') {
 			matchlen = 1;
-			g_snprintf (buf, matchlen + 2, "#%s", &license[i]);
-			g_ptr_array_add (array, g_strdup (buf));
+			g_ptr_array_add (array, g_strdup ("#("));
 			old = i + matchlen;
 			continue;
 		}
@@ -276,22 +380,22 @@ as_utils_spdx_license_tokenize (const gchar *license)
 		if (matchlen > 0) {
 
 			/* brackets */
-			if (license[i - 1] == ')') {
+			if (i > old && license[i - 1] == ')') {
 				i--;
 				matchlen++;
 			}
 
 			/* get previous token */
-			g_snprintf (buf, i - old + 1, "%s", &license[old]);
-			g_ptr_array_add (array, g_strdup (buf));
+			g_ptr_array_add (array, g_strndup (&license[old], i - old));
 
 			/* brackets */
 			if (license[i + matchlen] == '(')
 				matchlen++;
 
 			/* get operation */
-			g_snprintf (buf, matchlen + 2, "#%s", &license[i]);
-			g_ptr_array_add (array, g_strdup (buf));
+			g_ptr_array_add (array, g_strdup_printf ("#%.*s",
+								 (gint) matchlen,
+								 &license[i]));
 
 			old = i + matchlen;
 			i += matchlen - 1;
@@ -299,14 +403,12 @@ as_utils_spdx_license_tokenize (const gchar *license)
 	}
 
 	/* trailing bracket */
-	if (i > 0 && license[i - 1] == ')') {
+	if (i > old && license[i - 1] == ')') {
 		/* token */
-		g_snprintf (buf, i - old, "%s", &license[old]);
-		g_ptr_array_add (array, g_strdup (buf));
+		g_ptr_array_add (array, g_strndup (&license[old], i - old - 1));
 
 		/* brackets */
-		g_snprintf (buf, i - 1, "#%s", &license[i - 1]);
-		g_ptr_array_add (array, g_strdup (buf));
+		g_ptr_array_add (array, g_strdup ("#)"));
 	} else {
 		/* token */
 		g_ptr_array_add (array, g_strdup (&license[old]));
@@ -316,6 +418,542 @@ as_utils_spdx_license_tokenize (const gchar *license)
 	return (gchar **) g_ptr_array_free (array, FALSE);
 }
 
+struct _AsSpdxExpression {
+	GArray			*nodes;		/* of AsSpdxNode, pointing into the license */
+	gint			 root;
+};
+
+/* the deepest nesting of brackets, which limits the recursion */
+#define AS_SPDX_DEPTH_MAX	64
+
+/* the exception IDs from the SPDX license exception list */
+static const gchar *as_utils_spdx_exception_ids[] = {
+	"Autoconf-exception-2.0",
+	"Autoconf-exception-3.0",
+	"Bison-exception-2.2",
+	"Classpath-exception-2.0",
+	"CLISP-exception-2.0",
+	"eCos-exception-2.0",
+	"FLTK-exception",
+	"Font-exception-2.0",
+	"freertos-exception-2.0",
+	"GCC-exception-2.0",
+	"GCC-exception-3.1",
+	"gnu-javamail-exception",
+	"i2p-gpl-java-exception",
+	"Libtool-exception",
+	"LZMA-exception",
+	"mif-exception",
+	"Nokia-Qt-exception-1.1",
+	"OCCT-exception-1.0",
+	"openvpn-openssl-exception",
+	"Qwt-exception-1.0",
+	"u-boot-exception-2.0",
+	"WxWindows-exception-3.1",
+	NULL };
+
+typedef struct {
+	AsSpdxExpression	*expr;
+	AsSpdxParseFlags	 flags;
+	AsUtilsSpdxIdFunc	 id_func;
+	gpointer		 user_data;
+	const gchar		*pos;
+	guint			 depth;
+} AsSpdxParser;
+
+/**
+ * as_utils_spdx_is_license_id_len:
+ **/
+static gboolean
+as_utils_spdx_is_license_id_len (const gchar *license_id,
+				 guint len,
+				 gpointer user_data)
+{
+#ifdef HAVE_GPERF
+	return as_license_id_from_gperf (license_id, len) != NULL;
+#else
+	_cleanup_free_ gchar *tmp = NULL;
+	tmp = g_strndup (license_id, len);
+	return as_utils_is_spdx_license_id (tmp);
+#endif
+}
+
+/**
+ * as_utils_spdx_is_exception_id_len:
+ **/
+static gboolean
+as_utils_spdx_is_exception_id_len (const gchar *exception_id, guint len)
+{
+	guint i;
+	for (i = 0; as_utils_spdx_exception_ids[i] != NULL; i++) {
+		if (strlen (as_utils_spdx_exception_ids[i]) == len &&
+		    strncmp (as_utils_spdx_exception_ids[i], exception_id, len) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * as_utils_spdx_peek:
+ *
+ * Skips any whitespace and returns the next token without consuming it.
+ **/
+static const gchar *
+as_utils_spdx_peek (AsSpdxParser *parser, guint *len)
+{
+	const gchar *tok;
+	guint i;
+
+	while (g_ascii_isspace (parser->pos[0]))
+		parser->pos++;
+	tok = parser->pos;
+	if (tok[0] == '(' || tok[0] == ')') {
+		*len = 1;
+		return tok;
+	}
+	for (i = 0; tok[i] != '\0'; i++) {
+		if (g_ascii_isspace (tok[i]) || tok[i] == '(' || tok[i] == ')')
+			break;
+	}
+	*len = i;
+	return tok;
+}
+
+/**
+ * as_utils_spdx_token_is:
+ **/
+static gboolean
+as_utils_spdx_token_is (const gchar *tok, guint len, const gchar *keyword)
+{
+	return len == strlen (keyword) && g_ascii_strncasecmp (tok, keyword, len) == 0;
+}
+
+/**
+ * as_utils_spdx_token_is_id:
+ **/
+static gboolean
+as_utils_spdx_token_is_id (const gchar *tok, guint len)
+{
+	if (len == 0 || tok[0] == '(' || tok[0] == ')')
+		return FALSE;
+	if (as_utils_spdx_token_is (tok, len, "and") ||
+	    as_utils_spdx_token_is (tok, len, "or") ||
+	    as_utils_spdx_token_is (tok, len, "with"))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * as_utils_spdx_set_unexpected_error:
+ **/
+static void
+as_utils_spdx_set_unexpected_error (GError **error, const gchar *tok, guint len)
+{
+	if (len == 0) {
+		g_set_error_literal (error,
+				     AS_NODE_ERROR,
+				     AS_NODE_ERROR_FAILED,
+				     "unexpected end of license");
+		return;
+	}
+	g_set_error (error,
+		     AS_NODE_ERROR,
+		     AS_NODE_ERROR_FAILED,
+		     "unexpected '%.*s'", (gint) len, tok);
+}
+
+/**
+ * as_utils_spdx_add:
+ **/
+static gint
+as_utils_spdx_add (AsSpdxParser *parser, AsSpdxNodeKind kind,
+		   gint left, gint right)
+{
+	AsSpdxNode node;
+
+	node.kind = kind;
+	node.id = NULL;
+	node.id_len = 0;
+	node.or_later = FALSE;
+	node.left = left;
+	node.right = right;
+	g_array_append_val (parser->expr->nodes, node);
+	return parser->expr->nodes->len - 1;
+}
+
+static gint as_utils_spdx_parse_or (AsSpdxParser *parser, GError **error);
+
+/**
+ * as_utils_spdx_parse_license:
+ *
+ * Parses a license ID with an optional exception, or a bracketed expression.
+ **/
+static gint
+as_utils_spdx_parse_license (AsSpdxParser *parser, GError **error)
+{
+	AsSpdxNode *node;
+	const gchar *tok;
+	gint idx;
+	guint len;
+
+	/* sub-expression */
+	tok = as_utils_spdx_peek (parser, &len);
+	if (tok[0] == '(') {
+		if (parser->depth++ >= AS_SPDX_DEPTH_MAX) {
+			g_set_error_literal (error,
+					     AS_NODE_ERROR,
+					     AS_NODE_ERROR_FAILED,
+					     "too many brackets");
+			return -1;
+		}
+		parser->pos = tok + 1;
+		idx = as_utils_spdx_parse_or (parser, error);
+		if (idx < 0)
+			return -1;
+		tok = as_utils_spdx_peek (parser, &len);
+		if (tok[0] != ')') {
+			g_set_error_literal (error,
+					     AS_NODE_ERROR,
+					     AS_NODE_ERROR_FAILED,
+					     "missing ')'");
+			return -1;
+		}
+		parser->pos = tok + 1;
+		parser->depth--;
+		return idx;
+	}
+
+	/* license ID, where the "+" suffix may also be part of the ID */
+	if (!as_utils_spdx_token_is_id (tok, len)) {
+		as_utils_spdx_set_unexpected_error (error, tok, len);
+		return -1;
+	}
+	if ((parser->flags & AS_SPDX_PARSE_FLAG_VALIDATE) > 0 &&
+	    !parser->id_func (tok, len, parser->user_data) &&
+	    !(len > 1 && tok[len - 1] == '+' &&
+	      parser->id_func (tok, len - 1, parser->user_data))) {
+		g_set_error (error,
+			     AS_NODE_ERROR,
+			     AS_NODE_ERROR_FAILED,
+			     "SPDX ID '%.*s' unknown", (gint) len, tok);
+		return -1;
+	}
+	idx = as_utils_spdx_add (parser, AS_SPDX_NODE_KIND_LICENSE, -1, -1);
+	node = &g_array_index (parser->expr->nodes, AsSpdxNode, idx);
+	node->id = tok;
+	node->id_len = len;
+	if (len > 1 && tok[len - 1] == '+') {
+		node->id_len--;
+		node->or_later = TRUE;
+	}
+	parser->pos = tok + len;
+
+	/* exception */
+	tok = as_utils_spdx_peek (parser, &len);
+	if (!as_utils_spdx_token_is (tok, len, "with"))
+		return idx;
+	parser->pos = tok + len;
+	tok = as_utils_spdx_peek (parser, &len);
+	if (!as_utils_spdx_token_is_id (tok, len)) {
+		as_utils_spdx_set_unexpected_error (error, tok, len);
+		return -1;
+	}
+	if ((parser->flags & AS_SPDX_PARSE_FLAG_VALIDATE) > 0 &&
+	    !as_utils_spdx_is_exception_id_len (tok, len)) {
+		g_set_error (error,
+			     AS_NODE_ERROR,
+			     AS_NODE_ERROR_FAILED,
+			     "SPDX exception '%.*s' unknown", (gint) len, tok);
+		return -1;
+	}
+	idx = as_utils_spdx_add (parser, AS_SPDX_NODE_KIND_WITH, idx, -1);
+	node = &g_array_index (parser->expr->nodes, AsSpdxNode, idx);
+	node->id = tok;
+	node->id_len = len;
+	parser->pos = tok + len;
+	return idx;
+}
+
+/**
+ * as_utils_spdx_parse_and:
+ **/
+static gint
+as_utils_spdx_parse_and (AsSpdxParser *parser, GError **error)
+{
+	const gchar *tok;
+	gint left;
+	gint right;
+	guint len;
+
+	left = as_utils_spdx_parse_license (parser, error);
+	while (left >= 0) {
+		tok = as_utils_spdx_peek (parser, &len);
+		if (!as_utils_spdx_token_is (tok, len, "and"))
+			break;
+		parser->pos = tok + len;
+		right = as_utils_spdx_parse_license (parser, error);
+		if (right < 0)
+			return -1;
+		left = as_utils_spdx_add (parser, AS_SPDX_NODE_KIND_AND,
+					  left, right);
+	}
+	return left;
+}
+
+/**
+ * as_utils_spdx_parse_or:
+ **/
+static gint
+as_utils_spdx_parse_or (AsSpdxParser *parser, GError **error)
+{
+	const gchar *tok;
+	gint left;
+	gint right;
+	guint len;
+
+	left = as_utils_spdx_parse_and (parser, error);
+	while (left >= 0) {
+		tok = as_utils_spdx_peek (parser, &len);
+		if (!as_utils_spdx_token_is (tok, len, "or"))
+			break;
+		parser->pos = tok + len;
+		right = as_utils_spdx_parse_and (parser, error);
+		if (right < 0)
+			return -1;
+		left = as_utils_spdx_add (parser, AS_SPDX_NODE_KIND_OR,
+					  left, right);
+	}
+	return left;
+}
+
+/**
+ * as_utils_spdx_expression_free:
+ * @expr: a #AsSpdxExpression
+ *
+ * Frees a parsed SPDX license expression.
+ *
+ * Since: 0.1.8
+ **/
+void
+as_utils_spdx_expression_free (AsSpdxExpression *expr)
+{
+	if (expr == NULL)
+		return;
+	g_array_unref (expr->nodes);
+	g_slice_free (AsSpdxExpression, expr);
+}
+
+/**
+ * as_utils_spdx_expression_get_size:
+ * @expr: a #AsSpdxExpression
+ *
+ * Gets the number of nodes in a parsed SPDX license expression.
+ *
+ * Returns: the number of nodes
+ *
+ * Since: 0.1.8
+ **/
+guint
+as_utils_spdx_expression_get_size (const AsSpdxExpression *expr)
+{
+	g_return_val_if_fail (expr != NULL, 0);
+	return expr->nodes->len;
+}
+
+/**
+ * as_utils_spdx_expression_get_root:
+ * @expr: a #AsSpdxExpression
+ *
+ * Gets the index of the top level node of a parsed SPDX license expression.
+ *
+ * Returns: the node index
+ *
+ * Since: 0.1.8
+ **/
+gint
+as_utils_spdx_expression_get_root (const AsSpdxExpression *expr)
+{
+	g_return_val_if_fail (expr != NULL, -1);
+	return expr->root;
+}
+
+/**
+ * as_utils_spdx_expression_get_node:
+ * @expr: a #AsSpdxExpression
+ * @idx: the node index, e.g. from as_utils_spdx_expression_get_root()
+ *
+ * Gets a node of a parsed SPDX license expression.
+ *
+ * Returns: (transfer none): a #AsSpdxNode, or %NULL if @idx is invalid
+ *
+ * Since: 0.1.8
+ **/
+const AsSpdxNode *
+as_utils_spdx_expression_get_node (const AsSpdxExpression *expr, guint idx)
+{
+	g_return_val_if_fail (expr != NULL, NULL);
+	if (idx >= expr->nodes->len)
+		return NULL;
+	return &g_array_index (expr->nodes, AsSpdxNode, idx);
+}
+
+/**
+ * as_utils_spdx_parse_full:
+ * @license: a license string, e.g. "LGPL-2.0+ and (QPL-1.0 or GPL-2.0)"
+ * @flags: a #AsSpdxParseFlags, e.g. %AS_SPDX_PARSE_FLAG_VALIDATE
+ * @id_func: (scope call) (allow-none): the function used to check license
+ * IDs, or %NULL to use the SPDX license list
+ * @user_data: user data for @id_func
+ * @error: A #GError or %NULL
+ *
+ * Parses a SPDX license expression, checking each license ID with @id_func
+ * if %AS_SPDX_PARSE_FLAG_VALIDATE is used. The nodes point into @license,
+ * which has to outlive the returned expression.
+ *
+ * Returns: a new #AsSpdxExpression, or %NULL if the expression was invalid
+ **/
+AsSpdxExpression *
+as_utils_spdx_parse_full (const gchar *license,
+			  AsSpdxParseFlags flags,
+			  AsUtilsSpdxIdFunc id_func,
+			  gpointer user_data,
+			  GError **error)
+{
+	AsSpdxExpression *expr;
+	AsSpdxParser parser;
+	const gchar *tok;
+	guint len;
+
+	g_return_val_if_fail (license != NULL, NULL);
+
+	expr = g_slice_new (AsSpdxExpression);
+	expr->nodes = g_array_sized_new (FALSE, FALSE, sizeof (AsSpdxNode), 8);
+	parser.expr = expr;
+	parser.flags = flags;
+	parser.id_func = id_func;
+	parser.user_data = user_data;
+	if (parser.id_func == NULL)
+		parser.id_func = as_utils_spdx_is_license_id_len;
+	parser.pos = license;
+	parser.depth = 0;
+	expr->root = as_utils_spdx_parse_or (&parser, error);
+	if (expr->root < 0) {
+		as_utils_spdx_expression_free (expr);
+		return NULL;
+	}
+
+	/* trailing junk, e.g. an unmatched bracket */
+	tok = as_utils_spdx_peek (&parser, &len);
+	if (len > 0) {
+		as_utils_spdx_set_unexpected_error (error, tok, len);
+		as_utils_spdx_expression_free (expr);
+		return NULL;
+	}
+	return expr;
+}
+
+/**
+ * as_utils_spdx_parse:
+ * @license: a license string, e.g. "LGPL-2.0+ and (QPL-1.0 or GPL-2.0)"
+ * @flags: a #AsSpdxParseFlags, e.g. %AS_SPDX_PARSE_FLAG_VALIDATE
+ * @error: A #GError or %NULL
+ *
+ * Parses a SPDX license expression in a single pass. The "AND", "OR" and
+ * "WITH" operators are accepted in either upper or lower case, and "AND"
+ * binds more tightly than "OR". There is no limit on the number of
+ * licenses in the expression.
+ *
+ * The license string is not copied and the nodes point into it, so
+ * @license has to outlive the returned expression.
+ *
+ * With %AS_SPDX_PARSE_FLAG_VALIDATE each license ID has to be on the SPDX
+ * license list, and each exception ID after "WITH" has to be on the SPDX
+ * license exception list.
+ *
+ * Returns: (transfer full): a new #AsSpdxExpression, free with
+ * as_utils_spdx_expression_free(), or %NULL if the expression was invalid
+ *
+ * Since: 0.1.8
+ **/
+AsSpdxExpression *
+as_utils_spdx_parse (const gchar *license,
+		     AsSpdxParseFlags flags,
+		     GError **error)
+{
+	return as_utils_spdx_parse_full (license, flags, NULL, NULL, error);
+}
+
+/**
+ * as_utils_spdx_node_to_string:
+ **/
+static void
+as_utils_spdx_node_to_string (const AsSpdxExpression *expr,
+			      gint idx,
+			      AsSpdxNodeKind parent_kind,
+			      GString *str)
+{
+	const AsSpdxNode *node = &g_array_index (expr->nodes, AsSpdxNode, idx);
+	gboolean brackets;
+
+	switch (node->kind) {
+	case AS_SPDX_NODE_KIND_LICENSE:
+		g_string_append_len (str, node->id, node->id_len);
+		if (node->or_later)
+			g_string_append_c (str, '+');
+		break;
+	case AS_SPDX_NODE_KIND_WITH:
+		as_utils_spdx_node_to_string (expr, node->left, node->kind, str);
+		g_string_append (str, " WITH ");
+		g_string_append_len (str, node->id, node->id_len);
+		break;
+	case AS_SPDX_NODE_KIND_AND:
+	case AS_SPDX_NODE_KIND_OR:
+		/* only use brackets where they change the meaning */
+		brackets = node->kind == AS_SPDX_NODE_KIND_OR &&
+			   parent_kind == AS_SPDX_NODE_KIND_AND;
+		if (brackets)
+			g_string_append_c (str, '(');
+		as_utils_spdx_node_to_string (expr, node->left, node->kind, str);
+		if (node->kind == AS_SPDX_NODE_KIND_AND)
+			g_string_append (str, " AND ");
+		else
+			g_string_append (str, " OR ");
+		as_utils_spdx_node_to_string (expr, node->right, node->kind, str);
+		if (brackets)
+			g_string_append_c (str, ')');
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * as_utils_spdx_to_string:
+ * @expr: a #AsSpdxExpression
+ *
+ * Converts a parsed SPDX license expression back to a string, using upper
+ * case operators, single spaces and only the brackets that are required.
+ *
+ * Returns: (transfer full): a normalized license string, e.g.
+ *          "LGPL-2.0+ AND (QPL-1.0 OR GPL-2.0)"
+ *
+ * Since: 0.1.8
+ **/
+gchar *
+as_utils_spdx_to_string (const AsSpdxExpression *expr)
+{
+	GString *str;
+
+	g_return_val_if_fail (expr != NULL, NULL);
+
+	str = g_string_new ("");
+	if (expr->root >= 0) {
+		as_utils_spdx_node_to_string (expr, expr->root,
+					      AS_SPDX_NODE_KIND_UNKNOWN, str);
+	}
+	return g_string_free (str, FALSE);
+}
+
 /**
  * as_util_get_possible_kudos:
  *
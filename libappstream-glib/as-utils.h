@@ -30,6 +30,71 @@
 
 G_BEGIN_DECLS
 
+/**
+ * AsSpdxNodeKind:
+ * @AS_SPDX_NODE_KIND_UNKNOWN:		Type invalid or not known
+ * @AS_SPDX_NODE_KIND_LICENSE:		A license ID, e.g. "GPL-2.0"
+ * @AS_SPDX_NODE_KIND_AND:		Both of the children apply
+ * @AS_SPDX_NODE_KIND_OR:		Either of the children applies
+ * @AS_SPDX_NODE_KIND_WITH:		A license ID with an exception
+ *
+ * The kind of node in a parsed SPDX license expression.
+ **/
+typedef enum {
+	AS_SPDX_NODE_KIND_UNKNOWN,		/* Since: 0.1.8 */
+	AS_SPDX_NODE_KIND_LICENSE,		/* Since: 0.1.8 */
+	AS_SPDX_NODE_KIND_AND,			/* Since: 0.1.8 */
+	AS_SPDX_NODE_KIND_OR,			/* Since: 0.1.8 */
+	AS_SPDX_NODE_KIND_WITH,			/* Since: 0.1.8 */
+	/*< private >*/
+	AS_SPDX_NODE_KIND_LAST
+} AsSpdxNodeKind;
+
+/**
+ * AsSpdxParseFlags:
+ * @AS_SPDX_PARSE_FLAG_NONE:		No special actions to use
+ * @AS_SPDX_PARSE_FLAG_VALIDATE:	Fail if a license or exception ID is not known
+ *
+ * The flags used when parsing SPDX license expressions.
+ **/
+typedef enum {
+	AS_SPDX_PARSE_FLAG_NONE		= 0,	/* Since: 0.1.8 */
+	AS_SPDX_PARSE_FLAG_VALIDATE	= 1,	/* Since: 0.1.8 */
+	/*< private >*/
+	AS_SPDX_PARSE_FLAG_LAST
+} AsSpdxParseFlags;
+
+/**
+ * AsSpdxNode:
+ * @kind:		the #AsSpdxNodeKind
+ * @id:			the license ID, or the exception ID for a WITH node,
+ *			which points into the parsed license string and is
+ *			not NUL terminated
+ * @id_len:		the length of @id
+ * @or_later:		%TRUE if the license ID had a "+" suffix, which is not
+ *			included in @id
+ * @left:		index of the first child, or -1
+ * @right:		index of the second child, or -1
+ *
+ * A node in a parsed SPDX license expression.
+ **/
+typedef struct {
+	AsSpdxNodeKind		 kind;
+	const gchar		*id;
+	guint			 id_len;
+	gboolean		 or_later;
+	gint			 left;
+	gint			 right;
+} AsSpdxNode;
+
+/**
+ * AsSpdxExpression:
+ *
+ * A parsed SPDX license expression. The contents are private and should
+ * only be accessed using the as_utils_spdx_expression_*() functions.
+ **/
+typedef struct _AsSpdxExpression AsSpdxExpression;
+
 gchar		*as_markup_convert_simple	(const gchar	*markup,
 						 gssize		 markup_len,
 						 GError		**error);
@@ -37,9 +102,21 @@ gboolean	 as_utils_is_stock_icon_name	(const gchar	*name);
 gboolean	 as_utils_is_spdx_license_id	(const gchar	*license_id);
 const gchar * const *as_util_get_possible_kudos	(void);
 gchar		**as_utils_spdx_license_tokenize (const gchar	*license);
+AsSpdxExpression *as_utils_spdx_parse		(const gchar	*license,
+						 AsSpdxParseFlags flags,
+						 GError		**error);
+void		 as_utils_spdx_expression_free	(AsSpdxExpression *expr);
+guint		 as_utils_spdx_expression_get_size (const AsSpdxExpression *expr);
+gint		 as_utils_spdx_expression_get_root (const AsSpdxExpression *expr);
+const AsSpdxNode *as_utils_spdx_expression_get_node (const AsSpdxExpression *expr,
+						 guint		 idx);
+gchar		*as_utils_spdx_to_string	(const AsSpdxExpression *expr);
 gboolean	 as_utils_check_url_exists	(const gchar	*url,
 						 guint		 timeout,
 						 GError		**error);
+void		 as_utils_get_intern_stats	(guint		*lookups,
+						 guint		*hits,
+						 gsize		*bytes_saved);
 
 G_END_DECLS
 